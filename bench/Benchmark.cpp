@@ -0,0 +1,183 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+bool ke::bench::State::keepRunning()
+{
+    Clock::time_point now = Clock::now();
+
+    if(mStarted)
+    {
+        if(mDone >= mWarmup)
+            mSamples.push_back(std::chrono::duration<double, std::nano>(now - mIterationStart - mPaused).count());
+        mDone++;
+    }
+    mStarted = true;
+
+    if(mDone >= mWarmup + mIterations) return false;
+
+    mPaused = Clock::duration{0};
+    mIterationStart = Clock::now();
+    return true;
+}
+
+void ke::bench::State::pause()
+{
+    mPauseStart = Clock::now();
+}
+
+void ke::bench::State::resume()
+{
+    mPaused += Clock::now() - mPauseStart;
+}
+
+ke::bench::Statistics ke::bench::computeStatistics(std::vector<double> samples)
+{
+    Statistics stats;
+    if(samples.empty()) return stats;
+
+    std::sort(samples.begin(), samples.end());
+
+    // Nearest-rank percentiles, the sample counts here are small enough that interpolation buys nothing.
+    auto percentile = [&samples](double p)
+    {
+        size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(samples.size())));
+        return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+
+    stats.min = samples.front();
+    stats.max = samples.back();
+    stats.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+    stats.median = samples.size() % 2 == 0
+        ? (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) * 0.5
+        : samples[samples.size() / 2];
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+
+    double variance = 0.0;
+    for(double sample : samples)
+        variance += (sample - stats.mean) * (sample - stats.mean);
+    stats.stddev = samples.size() > 1 ? std::sqrt(variance / static_cast<double>(samples.size() - 1)) : 0.0;
+
+    return stats;
+}
+
+const char* ke::bench::getSuiteName(Suite suite)
+{
+    return suite == Suite::Cpu ? "cpu" : "gpu";
+}
+
+void ke::bench::runSuite(Suite suite, const Options& options, std::vector<Result>& results)
+{
+    for(const Benchmark& benchmark : Registry::getInstance().getBenchmarks())
+    {
+        if(benchmark.suite != suite) continue;
+        if(!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) continue;
+
+        State state(options.warmup, options.iterations);
+        benchmark.function(state);
+
+        Result result;
+        result.name = benchmark.name;
+        result.suite = getSuiteName(suite);
+        result.iterations = static_cast<uint32_t>(state.getSamples().size());
+        result.stats = computeStatistics(state.getSamples());
+        result.counters = state.getCounters();
+        if(state.getItemsPerIteration() > 0.0 && result.stats.mean > 0.0)
+            result.itemsPerSecond = state.getItemsPerIteration() * 1e9 / result.stats.mean;
+
+        std::cout << benchmark.name << ": median " << result.stats.median / 1000.0 << " us, p95 " << result.stats.p95 / 1000.0
+                  << " us (" << result.iterations << " iterations)\n";
+
+        results.push_back(std::move(result));
+    }
+}
+
+namespace
+{
+    std::string escape(const std::string& value)
+    {
+        std::string escaped;
+        for(char c : value)
+        {
+            if(c == '"' || c == '\\') escaped += '\\';
+            if(static_cast<unsigned char>(c) < 0x20) continue;
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::string number(double value)
+    {
+        if(!std::isfinite(value)) return "null";
+
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+        return buffer;
+    }
+}
+
+bool ke::bench::writeJson(const std::string& path, const std::vector<Result>& results, const Options& options)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if(!file)
+    {
+        std::cerr << "Failed to open " << path << " for the benchmark results.\n";
+        return false;
+    }
+
+    char timestamp[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+#ifdef NDEBUG
+    const char* configuration = "Release";
+#else
+    const char* configuration = "Debug";
+#endif
+
+    file << "{\n"
+         << "  \"schema\": 1,\n"
+         << "  \"timestamp\": \"" << timestamp << "\",\n"
+         << "  \"build\": {\"configuration\": \"" << configuration << "\", \"compiler\": \"" << escape(__VERSION__) << "\"},\n"
+         << "  \"warmup\": " << options.warmup << ",\n"
+         << "  \"results\": [\n";
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const Result& result = results[i];
+        const Statistics& stats = result.stats;
+
+        file << "    {\"name\": \"" << escape(result.name) << "\", \"suite\": \"" << result.suite << "\", \"unit\": \"" << result.unit << "\""
+             << ", \"iterations\": " << result.iterations
+             << ", \"mean\": " << number(stats.mean) << ", \"median\": " << number(stats.median)
+             << ", \"min\": " << number(stats.min) << ", \"max\": " << number(stats.max)
+             << ", \"stddev\": " << number(stats.stddev) << ", \"p95\": " << number(stats.p95) << ", \"p99\": " << number(stats.p99);
+
+        if(result.itemsPerSecond > 0.0)
+            file << ", \"items_per_second\": " << number(result.itemsPerSecond);
+
+        if(!result.counters.empty())
+        {
+            file << ", \"counters\": {";
+            bool first = true;
+            for(const auto& [name, value] : result.counters)
+            {
+                file << (first ? "" : ", ") << "\"" << escape(name) << "\": " << number(value);
+                first = false;
+            }
+            file << "}";
+        }
+
+        file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+
+    file << "  ]\n}\n";
+    return true;
+}
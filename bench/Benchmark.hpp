@@ -0,0 +1,143 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ke
+{
+    namespace bench
+    {
+        // Cpu benchmarks run standalone, Gpu ones run inside a headless Application once the renderer is up.
+        enum class Suite
+        {
+            Cpu,
+            Gpu
+        };
+
+        struct Statistics
+        {
+            double mean = 0.0;
+            double median = 0.0;
+            double min = 0.0;
+            double max = 0.0;
+            double stddev = 0.0;
+            double p95 = 0.0;
+            double p99 = 0.0;
+        };
+
+        struct Result
+        {
+            std::string name;
+            std::string suite;
+            std::string unit = "ns";
+            uint32_t iterations = 0;
+            Statistics stats;
+            double itemsPerSecond = 0.0;
+            std::map<std::string, double> counters;
+        };
+
+        // Drives one benchmark: the body loops on keepRunning() and everything between two calls is timed.
+        // The first `warmup` iterations are run but not recorded.
+        class State
+        {
+        public:
+            using Clock = std::chrono::steady_clock;
+
+            State(uint32_t warmup, uint32_t iterations)
+                : mWarmup(warmup), mIterations(iterations) {}
+
+            bool keepRunning();
+
+            // Excludes setup/teardown inside an iteration from the sample.
+            void pause();
+            void resume();
+
+            void setItemsPerIteration(double items) {mItemsPerIteration = items;}
+            void setCounter(const std::string& name, double value) {mCounters[name] = value;}
+
+            const std::vector<double>& getSamples() const {return mSamples;}
+            double getItemsPerIteration() const {return mItemsPerIteration;}
+            const std::map<std::string, double>& getCounters() const {return mCounters;}
+        private:
+            uint32_t mWarmup;
+            uint32_t mIterations;
+            uint32_t mDone = 0;
+            bool mStarted = false;
+
+            Clock::time_point mIterationStart;
+            Clock::time_point mPauseStart;
+            Clock::duration mPaused{0};
+
+            std::vector<double> mSamples;
+            double mItemsPerIteration = 0.0;
+            std::map<std::string, double> mCounters;
+        };
+
+        using BenchmarkFunction = std::function<void(State&)>;
+
+        struct Benchmark
+        {
+            std::string name;
+            Suite suite;
+            BenchmarkFunction function;
+        };
+
+        class Registry
+        {
+        public:
+            static Registry& getInstance()
+            {
+                static Registry instance;
+                return instance;
+            }
+
+            void add(const std::string& name, Suite suite, BenchmarkFunction function) {mBenchmarks.push_back({name, suite, std::move(function)});}
+            const std::vector<Benchmark>& getBenchmarks() const {return mBenchmarks;}
+        private:
+            Registry() = default;
+
+            std::vector<Benchmark> mBenchmarks;
+        };
+
+        struct Registrar
+        {
+            Registrar(const char* name, Suite suite, BenchmarkFunction function)
+            {
+                Registry::getInstance().add(name, suite, std::move(function));
+            }
+        };
+
+        struct Options
+        {
+            std::string filter;
+            uint32_t warmup = 3;
+            uint32_t iterations = 30;
+        };
+
+        Statistics computeStatistics(std::vector<double> samples);
+        const char* getSuiteName(Suite suite);
+
+        // Runs every registered benchmark of the suite whose name contains the filter.
+        void runSuite(Suite suite, const Options& options, std::vector<Result>& results);
+
+        bool writeJson(const std::string& path, const std::vector<Result>& results, const Options& options);
+
+        // Keeps the compiler from discarding a result that is otherwise unused.
+        template<typename T>
+        inline void doNotOptimize(T& value)
+        {
+            asm volatile("" : : "g"(&value) : "memory");
+        }
+    }
+}
+
+#define KE_BENCH_CONCAT_INNER(a, b) a##b
+#define KE_BENCH_CONCAT(a, b) KE_BENCH_CONCAT_INNER(a, b)
+#define KE_BENCHMARK(name, suite) \
+    static void name(::ke::bench::State& state); \
+    static ::ke::bench::Registrar KE_BENCH_CONCAT(keBenchRegistrar, __LINE__)(#name, ::ke::bench::Suite::suite, name); \
+    static void name(::ke::bench::State& state)
@@ -0,0 +1,136 @@
+#include "Benchmark.hpp"
+
+#include "SceneManager.hpp"
+#include "Nodes/Rect.hpp"
+#include "Graphics/TextUtilities.hpp"
+#include "Utility/JobSystem.hpp"
+
+namespace
+{
+    // Builds a balanced tree, `fanout` children per node down to `depth` levels below the root.
+    void buildTree(ke::nodes::DefaultObject* parent, int fanout, int depth)
+    {
+        if(depth == 0) return;
+
+        for(int i = 0; i < fanout; i++)
+        {
+            ke::nodes::Rect2D* child = parent->createChild<ke::nodes::Rect2D>(i * 8, depth * 8, 8, 8);
+            buildTree(child, fanout, depth - 1);
+        }
+    }
+
+    void benchmarkTraversal(ke::bench::State& state, int fanout, int depth)
+    {
+        ke::nodes::SceneObject<ke::nodes::Node2D> scene("BenchScene");
+        buildTree(&scene, fanout, depth);
+
+        size_t nodeCount = 0;
+        while(state.keepRunning())
+        {
+            std::vector<ke::nodes::DefaultObject*> nodes = scene.gatherDescendants();
+            nodeCount = nodes.size();
+            ke::bench::doNotOptimize(nodes);
+        }
+
+        state.setItemsPerIteration(static_cast<double>(nodeCount));
+        state.setCounter("nodes", static_cast<double>(nodeCount));
+    }
+}
+
+KE_BENCHMARK(SceneTraversal_1K, Cpu)
+{
+    // 10 + 100 + 1000 nodes.
+    benchmarkTraversal(state, 10, 3);
+}
+
+KE_BENCHMARK(SceneTraversal_Deep, Cpu)
+{
+    benchmarkTraversal(state, 2, 12);
+}
+
+KE_BENCHMARK(NodeChurn_1K, Cpu)
+{
+    ke::nodes::SceneObject<ke::nodes::Node2D> scene("BenchScene");
+
+    while(state.keepRunning())
+    {
+        for(int i = 0; i < 1000; i++)
+            scene.createChild<ke::nodes::Rect2D>(i, i, 8, 8);
+
+        while(!scene.getChildren().empty())
+            scene.destroyChild(scene.getChildren().back().get());
+    }
+
+    state.setItemsPerIteration(1000.0);
+}
+
+KE_BENCHMARK(MeshObjParse, Cpu)
+{
+    size_t vertexCount = 0, indexCount = 0;
+    while(state.keepRunning())
+    {
+        std::vector<ke::util::str::Vertex3P3C2T> vertices;
+        std::vector<uint32_t> indices;
+        ke::util::loadObjGeometry("src/Models/viking_room.obj", vertices, indices);
+
+        vertexCount = vertices.size();
+        indexCount = indices.size();
+        ke::bench::doNotOptimize(vertices);
+    }
+
+    state.setCounter("vertices", static_cast<double>(vertexCount));
+    state.setCounter("indices", static_cast<double>(indexCount));
+}
+
+KE_BENCHMARK(MsdfGlyphRaster_Ascii, Cpu)
+{
+    msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
+    msdfgen::FontHandle* font = msdfgen::loadFont(ft, "src/Fonts/DejaVuSans.ttf");
+    if(!font)
+    {
+        msdfgen::deinitializeFreetype(ft);
+        return;
+    }
+
+    ke::Graphics::Text::TextUtils& textUtils = ke::Graphics::Text::TextUtils::getInstance();
+
+    while(state.keepRunning())
+    {
+        for(uint32_t cp = 32; cp < 128; cp++)
+        {
+            ke::Graphics::Text::GlyphInfo glyph = textUtils.rasterizeGlyph(font, cp);
+            ke::bench::doNotOptimize(glyph);
+        }
+    }
+    state.setItemsPerIteration(96.0);
+
+    msdfgen::destroyFont(font);
+    msdfgen::deinitializeFreetype(ft);
+}
+
+KE_BENCHMARK(MsdfGlyphRaster_AsciiParallel, Cpu)
+{
+    ke::Graphics::Text::TextUtils& textUtils = ke::Graphics::Text::TextUtils::getInstance();
+
+    while(state.keepRunning())
+    {
+        std::vector<ke::Graphics::Text::GlyphInfo> glyphs = textUtils.rasterizeGlyphs("src/Fonts/DejaVuSans.ttf", 32, 128);
+        ke::bench::doNotOptimize(glyphs);
+    }
+    state.setItemsPerIteration(96.0);
+    state.setCounter("workers", static_cast<double>(ke::util::JobSystem::getInstance().getWorkerCount()));
+}
+
+// Latin-1 through Cyrillic, the kind of range a localized UI needs, where the serial path stops being tolerable.
+KE_BENCHMARK(MsdfGlyphRaster_UnicodeParallel, Cpu)
+{
+    ke::Graphics::Text::TextUtils& textUtils = ke::Graphics::Text::TextUtils::getInstance();
+
+    while(state.keepRunning())
+    {
+        std::vector<ke::Graphics::Text::GlyphInfo> glyphs = textUtils.rasterizeGlyphs("src/Fonts/DejaVuSans.ttf", 0x20, 0x500);
+        ke::bench::doNotOptimize(glyphs);
+    }
+    state.setItemsPerIteration(static_cast<double>(0x500 - 0x20));
+    state.setCounter("workers", static_cast<double>(ke::util::JobSystem::getInstance().getWorkerCount()));
+}
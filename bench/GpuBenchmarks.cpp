@@ -0,0 +1,112 @@
+#include "Benchmark.hpp"
+
+#include "SceneManager.hpp"
+#include "Utility/XMLparser.hpp"
+#include "Utility/UILayout.hpp"
+#include "Graphics/TextUtilities.hpp"
+
+// These run from Application's init callback, so the renderer, fonts and UI are live.
+
+KE_BENCHMARK(XmlUiParse, Gpu)
+{
+    const char* files[] = {"src/UI/navbar.xml", "src/UI/explorer.xml", "src/UI/output.xml"};
+    // The headless default size, elements only get their rects from the first layout pass.
+    const glm::vec2 viewport(1280.0f, 720.0f);
+
+    size_t elementCount = 0;
+    uint32_t nodeCount = 0;
+    while(state.keepRunning())
+    {
+        std::vector<std::unique_ptr<ke::gui::Element>> elements;
+        std::unique_ptr<ke::gui::LayoutNode> layouts[std::size(files)];
+        nodeCount = 0;
+        for(size_t i = 0; i < std::size(files); i++)
+        {
+            ke::util::XML::getInstance().parseFile(files[i], elements, layouts[i]);
+            nodeCount += layouts[i]->layout(ke::gui::LayoutRect{0.0f, 0.0f, 1.0f, 1.0f}, viewport);
+        }
+        elementCount = elements.size();
+
+        // Element teardown frees GPU buffers and waits for the device, keep it out of the sample.
+        state.pause();
+        for(auto& layout : layouts)
+            layout.reset();
+        elements.clear();
+        state.resume();
+    }
+
+    state.setCounter("elements", static_cast<double>(elementCount));
+    state.setCounter("layoutNodes", static_cast<double>(nodeCount));
+}
+
+KE_BENCHMARK(TextInstanceLayout, Gpu)
+{
+    const std::string text = "The quick brown fox jumps over the lazy dog 0123456789 !?#%&";
+
+    while(state.keepRunning())
+    {
+        auto instance = std::make_unique<ke::Graphics::Text::TextInstance>(text, "DejaVuSans", 16, 16, glm::vec4(1.0f), 18);
+
+        state.pause();
+        instance.reset();
+        state.resume();
+    }
+
+    state.setItemsPerIteration(static_cast<double>(text.size()));
+}
+
+namespace
+{
+    void benchmarkUpload(ke::bench::State& state, size_t vertexCount)
+    {
+        ke::Graphics::Renderer& renderer = ke::Graphics::Renderer::getInstance();
+
+        std::vector<ke::util::str::Vertex3P3C2T> vertices(vertexCount);
+        std::vector<uint32_t> indices(vertexCount);
+        for(size_t i = 0; i < vertexCount; i++)
+        {
+            vertices[i].pos = glm::vec3(static_cast<float>(i), 0.0f, 0.0f);
+            indices[i] = static_cast<uint32_t>(i);
+        }
+
+        while(state.keepRunning())
+        {
+            ke::util::Buffer vertexBuffer(renderer.getDevice());
+            ke::util::Buffer indexBuffer(renderer.getDevice());
+
+            renderer.createVertexBuffer<ke::util::str::Vertex3P3C2T>(vertices, vertexBuffer.buffer, vertexBuffer.bufferMemory);
+            renderer.createIndexBuffer(indices, indexBuffer.buffer, indexBuffer.bufferMemory);
+
+            state.pause();
+            vertexBuffer.destroy();
+            indexBuffer.destroy();
+            state.resume();
+        }
+
+        double bytes = static_cast<double>(vertexCount * (sizeof(ke::util::str::Vertex3P3C2T) + sizeof(uint32_t)));
+        state.setItemsPerIteration(bytes);
+        state.setCounter("bytes", bytes);
+    }
+}
+
+KE_BENCHMARK(BufferUpload_4K, Gpu)
+{
+    benchmarkUpload(state, 4096);
+}
+
+KE_BENCHMARK(BufferUpload_256K, Gpu)
+{
+    benchmarkUpload(state, 256 * 1024);
+}
+
+KE_BENCHMARK(MeshImport, Gpu)
+{
+    while(state.keepRunning())
+    {
+        auto mesh = std::make_unique<ke::util::Mesh>(std::string("src/Models/viking_room.obj"));
+
+        state.pause();
+        mesh.reset();
+        state.resume();
+    }
+}
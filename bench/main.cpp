@@ -0,0 +1,100 @@
+#include "Benchmark.hpp"
+#include "Application.hpp"
+#include "Utility/FrameAllocator.hpp"
+#include "Utility/JobSystem.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+    ke::bench::Result summarizeFrames(const std::vector<ke::Graphics::FrameStats>& frames, uint32_t skip, const char* name, float ke::Graphics::FrameStats::*field, const char* unit = "ms")
+    {
+        std::vector<double> samples;
+        for(size_t i = skip; i < frames.size(); i++)
+            samples.push_back(frames[i].*field);
+
+        ke::bench::Result result;
+        result.name = name;
+        result.suite = "frame";
+        result.unit = unit;
+        result.iterations = static_cast<uint32_t>(samples.size());
+        result.stats = ke::bench::computeStatistics(std::move(samples));
+        return result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    ke::bench::Options options;
+    std::string outPath = "bench_results.json";
+    std::string frames = "300";
+    std::string size = "1280x720";
+    bool runGpu = true;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "--out" && hasValue) outPath = argv[++i];
+        else if(arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if(arg == "--iterations" && hasValue) options.iterations = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if(arg == "--warmup" && hasValue) options.warmup = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        else if(arg == "--frames" && hasValue) frames = argv[++i];
+        else if(arg == "--size" && hasValue) size = argv[++i];
+        else if(arg == "--cpu-only") runGpu = false;
+        else
+        {
+            std::cerr << "Usage: NewEngineBench [--out file.json] [--filter substring] [--iterations N] [--warmup N] [--frames N] [--size WxH] [--cpu-only]\n";
+            return 1;
+        }
+    }
+
+    // Started here so the CPU suite can measure parallel work too, the application's own init leaves it running.
+    ke::util::JobSystem::getInstance().init();
+
+    std::vector<ke::bench::Result> results;
+    ke::bench::runSuite(ke::bench::Suite::Cpu, options, results);
+
+    if(runGpu)
+    {
+        // The GPU benchmarks need the full engine, so they run inside a headless session which then renders the
+        // frame scenario as usual.
+        ke::Core::Application& app = ke::Core::Application::getInstance();
+        app.setOnInitialized([&options, &results]()
+        {
+            ke::bench::runSuite(ke::bench::Suite::Gpu, options, results);
+        });
+
+        std::string program = argv[0];
+        std::vector<std::string> appArgs = {program, "--headless", "--frames", frames, "--size", size};
+        std::vector<char*> appArgv;
+        for(std::string& appArg : appArgs)
+            appArgv.push_back(appArg.data());
+
+        try
+        {
+            app.Run(static_cast<int>(appArgv.size()), appArgv.data());
+        }
+        catch (std::runtime_error& e) { std::cerr << e.what() << std::endl; }
+
+        const std::vector<ke::Graphics::FrameStats>& frameStats = app.getHeadlessFrameStats();
+        if(options.filter.empty() || std::string("HeadlessFrame").find(options.filter) != std::string::npos)
+        {
+            results.push_back(summarizeFrames(frameStats, options.warmup, "HeadlessFrame_Cpu", &ke::Graphics::FrameStats::cpuTime));
+            results.push_back(summarizeFrames(frameStats, options.warmup, "HeadlessFrame_Gpu", &ke::Graphics::FrameStats::gpuTime));
+            results.push_back(summarizeFrames(frameStats, options.warmup, "HeadlessFrame_Total", &ke::Graphics::FrameStats::frameTime));
+            if(ke::util::isCountingHeapAllocations())
+                results.push_back(summarizeFrames(frameStats, options.warmup, "HeadlessFrame_HeapAllocations", &ke::Graphics::FrameStats::heapAllocations, "allocations"));
+        }
+    }
+
+    ke::util::JobSystem::getInstance().shutdown();
+
+    if(!ke::bench::writeJson(outPath, results, options)) return 1;
+
+    std::cout << "Wrote " << results.size() << " results to " << outPath << "\n";
+    return 0;
+}
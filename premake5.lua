@@ -1,3 +1,23 @@
+newoption {
+    trigger = "profile",
+    description = "Compile in CPU profiler zones (KE_PROFILE_ZONE) and Chrome trace capture"
+}
+
+newoption {
+    trigger = "log-level",
+    value = "LEVEL",
+    description = "Strip log calls below this level at compile time",
+    allowed = {
+        { "trace", "Trace" },
+        { "debug", "Debug" },
+        { "info", "Info" },
+        { "warn", "Warn" },
+        { "error", "Error" },
+        { "critical", "Critical" },
+        { "off", "Off" }
+    }
+}
+
 workspace "NewEngine"
     configurations { "Debug", "Release" }
     platforms { "x64" }
@@ -43,6 +63,10 @@ workspace "NewEngine"
         links "c++"
     filter {}
 
+    if _OPTIONS["log-level"] then
+        defines { "KE_LOG_ACTIVE_LEVEL=KE_LOG_LEVEL_" .. _OPTIONS["log-level"]:upper() }
+    end
+
 project "NewEngine"
     kind "ConsoleApp"
     language "C++"
@@ -50,7 +74,63 @@ project "NewEngine"
     targetdir "bin/%{cfg.buildcfg}"
 
     files { "**.h", "**.c", "**.cpp", "**.hpp" }
-    removefiles { "vendor/**" }
+    removefiles { "vendor/**", "bench/**", "tests/**" }
+    defines {"GLFW_INCLUDE_VULKAN", "STB_IMAGE_IMPLEMENTATION", "GLM_ENABLE_EXPERIMENTAL"}
+
+    filter "system:linux"
+        libdirs { "./vendor/lib", "/usr/local/lib" }
+        links { "glfw3", "vulkan", "pugixml", "dl", "pthread", "X11", "Xxf86vm", "Xrandr", "Xi", "openal", "msdfgen-ext", "msdfgen-core", "freetype", "png", "z", "bz2", "brotlidec" }
+    filter {}
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
+
+    filter "options:profile"
+        defines { "KE_PROFILE" }
+
+        
+
+project "NewEngineBench"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    targetdir "bin/%{cfg.buildcfg}"
+
+    files { "bench/**.cpp", "bench/**.hpp", "src/**.h", "src/**.c", "src/**.cpp", "src/**.hpp" }
+    removefiles { "src/main.cpp" }
+    includedirs { "src" }
+    defines {"GLFW_INCLUDE_VULKAN", "STB_IMAGE_IMPLEMENTATION", "GLM_ENABLE_EXPERIMENTAL"}
+
+    filter "system:linux"
+        libdirs { "./vendor/lib", "/usr/local/lib" }
+        links { "glfw3", "vulkan", "pugixml", "dl", "pthread", "X11", "Xxf86vm", "Xrandr", "Xi", "openal", "msdfgen-ext", "msdfgen-core", "freetype", "png", "z", "bz2", "brotlidec" }
+    filter {}
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG" }
+        optimize "On"
+
+    filter "options:profile"
+        defines { "KE_PROFILE" }
+
+project "NewEngineTests"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    targetdir "bin/%{cfg.buildcfg}"
+
+    files { "tests/**.cpp", "tests/**.hpp", "src/**.h", "src/**.c", "src/**.cpp", "src/**.hpp" }
+    removefiles { "src/main.cpp" }
+    includedirs { "src" }
     defines {"GLFW_INCLUDE_VULKAN", "STB_IMAGE_IMPLEMENTATION", "GLM_ENABLE_EXPERIMENTAL"}
 
     filter "system:linux"
@@ -66,4 +146,5 @@ project "NewEngine"
         defines { "NDEBUG" }
         optimize "On"
 
-        
\ No newline at end of file
+    filter "options:profile"
+        defines { "KE_PROFILE" }
@@ -13,14 +13,18 @@ layout(push_constant) uniform texturePC
 
 layout(set = 0, binding = 0) uniform sampler2D textures[];
 
+layout(constant_id = 0) const bool USE_TEXTURE = false;
+layout(constant_id = 1) const bool ALPHA_TEST = false;
+
 void main()
 {
-    if(tpc.textureIndex >= 0)
-    {
-        outColor = texture(textures[tpc.textureIndex], fragUV);
-    }
-    else
-    {
-        outColor = vec4(fragColor, 1.0);
-    }
+    vec4 color = vec4(fragColor, 1.0);
+
+    if(USE_TEXTURE)
+        color = texture(textures[tpc.textureIndex], fragUV);
+
+    if(ALPHA_TEST && color.a < 0.5)
+        discard;
+
+    outColor = color;
 }
\ No newline at end of file
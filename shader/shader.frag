@@ -13,14 +13,31 @@ layout(push_constant) uniform texturePC
 
 layout(set = 0, binding = 0) uniform sampler2D textures[];
 
+layout(constant_id = 0) const bool USE_TEXTURE = false;
+layout(constant_id = 1) const bool ALPHA_TEST = false;
+layout(constant_id = 2) const bool SDF = false;
+
+float median(float r, float g, float b)
+{
+    return max(min(r,g), min(max(r,g),b));
+}
+
 void main()
 {
-    if(tpc.textureIndex >= 0)
-    {
-        outColor = texture(textures[tpc.textureIndex], fragTex);
-    }
-    else
+    vec4 color = vec4(fragColor, 1.0);
+
+    if(USE_TEXTURE)
+        color = texture(textures[tpc.textureIndex], fragTex);
+
+    if(SDF)
     {
-        outColor = vec4(fragColor, 1.0);
+        float dist = median(color.r, color.g, color.b);
+        float width = fwidth(dist);
+        color = vec4(fragColor, smoothstep(0.5 - width, 0.5 + width, dist));
     }
+
+    if(ALPHA_TEST && color.a < 0.5)
+        discard;
+
+    outColor = color;
 }
\ No newline at end of file
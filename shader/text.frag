@@ -3,14 +3,10 @@
 
 layout(location = 0) in vec4 FragColor;
 layout(location = 1) in vec2 FragUV;
+layout(location = 2) flat in uvec2 FragAtlas;   // descriptor index, SDF atlases keep the distance in red only
 
 layout(location = 0) out vec4 outColor;
 
-layout(push_constant) uniform atlasPC
-{
-    int atlasIndex;
-} apc;
-
 layout(set = 0, binding = 1) uniform sampler2D atlases[];
 
 float median(float r, float g, float b)
@@ -21,8 +17,12 @@ float median(float r, float g, float b)
 void main()
 {
 
-    vec3 msdf = texture(atlases[apc.atlasIndex], FragUV).rgb;
-    float dist = median(msdf.r, msdf.g, msdf.b);
+    // Labels on different pages share one draw, so the index can change within it.
+    uint atlas = FragAtlas.x;
+    // Glyph UVs are in texels, atlas pages grow taller without their glyphs moving.
+    vec2 uv = FragUV / vec2(textureSize(atlases[nonuniformEXT(atlas)], 0));
+    vec4 texel = texture(atlases[nonuniformEXT(atlas)], uv);
+    float dist = FragAtlas.y != 0u ? texel.r : median(texel.r, texel.g, texel.b);
     float width = fwidth(dist);
     float alpha = smoothstep(0.5 - width, 0.5 + width, dist);
 
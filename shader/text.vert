@@ -4,9 +4,11 @@ layout(location = 0) in vec2 GlyphPosition;
 layout(location = 1) in vec2 GlyphSize;
 layout(location = 2) in vec4 GlyphUV;
 layout(location = 3) in vec4 GlyphColor;
+layout(location = 4) in uvec2 GlyphAtlas;
 
 layout(location = 0) out vec4 FragColor;
 layout(location = 1) out vec2 FragUV;
+layout(location = 2) flat out uvec2 FragAtlas;
 
 const vec2 corners[6] = 
 {
@@ -29,5 +31,6 @@ void main()
     
     FragUV = mix(GlyphUV.xy, GlyphUV.zw, corner);
     FragColor = GlyphColor;
+    FragAtlas = GlyphAtlas;
 
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #include "Application.hpp"
 #include "Nodes/Object.hpp"
 #include "Nodes/PhysicsObject.hpp"
+#include "Utility/Profiler.hpp"
+#include "Utility/TaskGraph.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
 
 ke::Core::Application& ke::Core::Application::getInstance()
 {
@@ -8,67 +13,236 @@ ke::Core::Application& ke::Core::Application::getInstance()
     return instance;
 }
 
-void ke::Core::Application::Run()
+void ke::Core::Application::Run(int argc, char** argv)
 {
+    parseArguments(argc, argv);
     init();
-    run();
+    if(mHeadless) runHeadless();
+    else run();
     terminate();
 }
 
+void ke::Core::Application::parseArguments(int argc, char **argv)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if(arg == "--frames-in-flight" && hasValue)
+            mRenderer.setFramesInFlight(static_cast<uint32_t>(std::atoi(argv[++i])));
+        else if(arg == "--present-mode" && hasValue)
+        {
+            std::string mode = argv[++i];
+            if(mode == "fifo") mRenderer.setPresentMode(Graphics::PresentMode::Fifo);
+            else if(mode == "fifo-relaxed") mRenderer.setPresentMode(Graphics::PresentMode::FifoRelaxed);
+            else if(mode == "mailbox") mRenderer.setPresentMode(Graphics::PresentMode::Mailbox);
+            else if(mode == "immediate") mRenderer.setPresentMode(Graphics::PresentMode::Immediate);
+            else std::cerr << "Unknown present mode " << mode << ", expected fifo, fifo-relaxed, mailbox or immediate.\n";
+        }
+        else if(arg == "--fps-cap" && hasValue)
+            mFramePacer.setTargetFrameRate(static_cast<float>(std::atof(argv[++i])));
+        else if(arg == "--no-pacing")
+            mFramePacer.setEnabled(false);
+        else if(arg == "--profiler-overlay")
+            mProfilerOverlay.setVisible(true);
+        else if(arg == "--trace" && hasValue)
+        {
+            mTracePath = argv[++i];
+            mTraceFromStart = true;
+#ifndef KE_PROFILE
+            std::cerr << "Built without --profile, the trace will only contain thread names.\n";
+#endif
+        }
+        else if(arg == "--headless")
+            mHeadless = true;
+        else if(arg == "--size" && hasValue)
+        {
+            int width = 0, height = 0;
+            if(std::sscanf(argv[++i], "%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+                mHeadlessSize = {width, height};
+            else
+                std::cerr << "Expected --size WIDTHxHEIGHT.\n";
+        }
+        else if(arg == "--frames" && hasValue)
+            mHeadlessFrames = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if(arg == "--dump-frames" && hasValue)
+            mDumpDirectory = argv[++i];
+        else if(arg == "--dump-interval" && hasValue)
+            mDumpInterval = static_cast<uint32_t>(std::max(1, std::atoi(argv[++i])));
+        else if(arg == "--timings" && hasValue)
+            mTimingsPath = argv[++i];
+        else if(arg == "--glyph-format" && hasValue)
+        {
+            std::string format = argv[++i];
+            if(format == "msdf") mTextUtils.setGlyphFormat(Graphics::Text::GlyphFormat::MSDF);
+            else if(format == "mtsdf") mTextUtils.setGlyphFormat(Graphics::Text::GlyphFormat::MTSDF);
+            else if(format == "sdf") mTextUtils.setGlyphFormat(Graphics::Text::GlyphFormat::SDF);
+            else std::cerr << "Unknown glyph format " << format << ", expected msdf, mtsdf or sdf.\n";
+        }
+        else
+            std::cerr << "Unknown argument " << arg << "\n";
+    }
+}
+
 void ke::Core::Application::init()
 {
     mLogger.initLoggers();
-    Graphics::Window::initGLFW();
-    mLogger.info("Initialized GLFW.");
-    mMonitor = glfwGetPrimaryMonitor();
-    const GLFWvidmode* videoMode = glfwGetVideoMode(mMonitor);
-    mWindow = std::make_unique<Graphics::Window>(videoMode->width, videoMode->height, "Knajp's Engine");
-    mWindow->setApplicationEventCallback(onEvent);
-    mLogger.info("Created window.");
+    mJobSystem.init();
+
+    // GLFW and the Vulkan queue stay on the main thread, the CPU-heavy loading runs on job workers meanwhile.
+    using util::JobAffinity;
+    util::TaskGraph startup("Startup");
 
-    std::future<void> audioFuture = std::async(std::launch::async, [this]()
+    // Headless runs never touch GLFW or OpenAL, so they work on machines without a display or sound card.
+    auto window = startup.add("Window", [this]()
     {
-        mAudioManager.init();
-    });
-    mLogger.trace("Requesting renderer init.");
-    mRenderer.init(mWindow->getWindowHandle());
-    mLogger.trace("Finished initializing renderer.");
+        if(mHeadless)
+        {
+            mRenderer.setHeadless(static_cast<uint32_t>(mHeadlessSize.x), static_cast<uint32_t>(mHeadlessSize.y));
+            mFramePacer.setEnabled(false);
+            mLogger.info("Running headless.");
+            return;
+        }
+
+        Graphics::Window::initGLFW();
+        mLogger.info("Initialized GLFW.");
+        mMonitor = glfwGetPrimaryMonitor();
+        const GLFWvidmode* videoMode = glfwGetVideoMode(mMonitor);
+        mWindow = std::make_unique<Graphics::Window>(videoMode->width, videoMode->height, "Knajp's Engine");
+        mWindow->setApplicationEventCallback(onEvent);
+        mLogger.info("Created window.");
+    }, {}, JobAffinity::MainThread);
+
+    auto shaders = startup.add("Shaders", []() {Graphics::ShaderLibrary::getInstance().init();});
+    auto fontRaster = startup.add("FontRaster", [this]() {mTextUtils.loadFonts();});
+    auto textureDecode = startup.add("TextureDecode", [this]() {mTextureManager.decodeTextures();});
+    auto uiParse = startup.add("UIParse", [this]() {mUIManager.preloadComponents();});
+
+    // The descriptor set layouts are built from shader reflection, and font and texture uploads need the sets.
+    auto device = startup.add("Device", [this]()
+    {
+        mRenderer.initDevice(mHeadless ? nullptr : mWindow->getWindowHandle());
+    }, {window, shaders}, JobAffinity::MainThread);
 
-    mLogger.trace("Requesting Text Utils init.");
-    mTextUtils.init();
-    mLogger.info("Finished loading text utils.");
+    auto pipelines = startup.add("Pipelines", [this]() {mRenderer.initPipelines();}, {device, shaders});
+    auto fontUpload = startup.add("FontUpload", [this]() {mTextUtils.uploadFonts();}, {device, fontRaster}, JobAffinity::MainThread);
+    auto textureUpload = startup.add("TextureUpload", [this]() {mTextureManager.uploadTextures();}, {device, textureDecode}, JobAffinity::MainThread);
 
-    mLogger.trace("Requesting UI manager load");
-    mUIManager.loadComponents(mWindow->getWindowHandle());
-    mLogger.info("Finished loading UI manager.");
+    auto ui = startup.add("UI", [this]()
+    {
+        mUIManager.loadComponents(getFramebufferSize());
+    }, {uiParse, fontUpload}, JobAffinity::MainThread);
 
-    mLogger.trace("Requesting Texture manager init.");
-    mTextureManager.init();
-    mLogger.info("Finished loading texture manager.");
-    
+    auto scene = startup.add("Scene", [this]()
+    {
+        mSceneManager.init(mUIManager.getSceneComponentPosition(), mUIManager.getSceneComponentExtent(), getFramebufferSize().y);
+    }, {ui}, JobAffinity::MainThread);
 
-    audioFuture.get();
+    startup.add("RenderGraph", [this]() {buildRenderGraph();}, {pipelines, textureUpload, scene}, JobAffinity::MainThread);
 
-    int width, height;
-    glfwGetFramebufferSize(mWindow->getWindowHandle(), &width, &height);
-    mSceneManager.init(mUIManager.getSceneComponentPosition(), mUIManager.getSceneComponentExtent(), height);
+    if(!mHeadless)
+    {
+        auto audio = startup.add("Audio", [this]() {mAudioManager.init();});
+        startup.add("AudioDecode", [this]()
+        {
+            mMusicIndex = mAudioManager.createAudio("src/Sounds/music.mp3", AL_TRUE, 1.0f, 1.0f, "music");
+        }, {audio});
+    }
+
+    startup.run();
+    startup.logTimeline();
 
     mLogger.info("Finished application initialization.");
+
+    if(mOnInitialized) mOnInitialized();
+}
+
+void ke::Core::Application::buildRenderGraph()
+{
+    mRenderGraph.init(mRenderer.getDevice(), mRenderer.getPhysicalDevice());
+
+    mBackbuffer = mRenderGraph.importImage("Backbuffer", VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, true);
+    mDepthBuffer = mRenderGraph.importImage("Depth", VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_LAYOUT_UNDEFINED);
+
+    mRenderGraph.setPassHooks([this](VkCommandBuffer, const std::string& name)
+    {
+        return mRenderer.beginGpuZone(name);
+    },
+    [this](VkCommandBuffer, uint32_t zone)
+    {
+        mRenderer.endGpuZone(zone);
+    });
+
+    mRenderGraph.addPass("UI", Graphics::PassType::Graphics, [this](Graphics::PassBuilder& builder)
+    {
+        builder.write(mBackbuffer, Graphics::ResourceAccess::ColorAttachment, mRenderer.getBackbufferLayout());
+        builder.write(mDepthBuffer, Graphics::ResourceAccess::DepthAttachment);
+    },
+    [this](VkCommandBuffer cb)
+    {
+        mRenderer.bindUIPipeline(cb);
+        mUIManager.drawComponents(cb);
+        mRenderer.endRenderPass();
+    });
+
+    mRenderGraph.addPass("Scene", Graphics::PassType::Graphics, [this](Graphics::PassBuilder& builder)
+    {
+        builder.read(mBackbuffer, Graphics::ResourceAccess::ColorAttachment);
+        builder.write(mBackbuffer, Graphics::ResourceAccess::ColorAttachment, mRenderer.getBackbufferLayout());
+        builder.write(mDepthBuffer, Graphics::ResourceAccess::DepthAttachment);
+    },
+    [this](VkCommandBuffer cb)
+    {
+        mRenderer.bindScenePipeline(cb, mSceneManager.getViewport(), mSceneManager.getScissor());
+        mSceneManager.drawScene();
+        mRenderer.endRenderPass();
+    });
+
+    mRenderGraph.addPass("Text", Graphics::PassType::Graphics, [this](Graphics::PassBuilder& builder)
+    {
+        builder.read(mBackbuffer, Graphics::ResourceAccess::ColorAttachment);
+        builder.write(mBackbuffer, Graphics::ResourceAccess::ColorAttachment, mRenderer.getBackbufferLayout());
+    },
+    [this](VkCommandBuffer cb)
+    {
+        mRenderer.bindFontPipeline(cb);
+        mUIManager.drawComponentTextLabels();
+        mProfilerOverlay.draw();
+        mRenderer.drawQueuedText();
+        mRenderer.endRenderPass();
+    });
+
+    mRenderGraph.compile();
 }
 
 void ke::Core::Application::run()
 {
     mLogger.info("Proceeding to main loop.");
+
+    KE_PROFILE_THREAD("Main");
+    if(mTraceFromStart) util::Profiler::getInstance().beginCapture();
     
-    uint16_t musicIndex = mAudioManager.createAudio("src/Sounds/music.mp3", AL_TRUE, 1.0f, 1.0f, "music");
-    mAudioManager.PlayAudio(musicIndex);
+    mAudioManager.PlayAudio(mMusicIndex);
 
     nodes::ISceneObject* pSceneObject = mSceneManager.getSceneObject();
     nodes::Rect2D* rect = pSceneObject->createChild<nodes::Rect2D>(0,0,500,500, "Hello!");
 
     while (!mWindow->shouldClose())
     {
-        
+        KE_PROFILE_ZONE("Frame");
+        {
+            KE_PROFILE_ZONE("PacerSleep");
+            mFramePacer.waitBeforeInput();
+        }
+        {
+            KE_PROFILE_ZONE("PollEvents");
+            Graphics::Window::pollEvents();
+        }
+        mFramePacer.beginFrame();
+        mJobSystem.runMainThreadJobs();
+        mTextUtils.update();
+
         mWindow->calculateAspectRatio();
         mRenderer.readyCanvas(mWindow->getWindowHandle());
         VkCommandBuffer cb = mRenderer.getCurrentCommandBuffer();
@@ -76,32 +250,126 @@ void ke::Core::Application::run()
         mRenderer.updateUIUniforms(mWindow->getAspectRatio());
         mRenderer.updateSceneUniforms(mSceneManager.getSceneAspectRatio());
 
-        mRenderer.bindUIPipeline(cb);
-        mLogger.trace("Drawing components");
+        mRenderer.updateFontUniforms();
 
-        mUIManager.drawComponents(cb);
-        mLogger.trace("Drew components");
-        
-        mRenderer.endRenderPass();
-        mRenderer.bindScenePipeline(cb, mSceneManager.getViewport(), mSceneManager.getScissor());
+        mRenderGraph.setImportedImage(mBackbuffer, mRenderer.getCurrentSwapchainImage());
+        mRenderGraph.setImportedImage(mDepthBuffer, mRenderer.getDepthImage());
+        {
+            KE_PROFILE_ZONE("RecordFrame");
+            mRenderGraph.execute(cb);
+        }
 
-        mSceneManager.drawScene();
+        mRenderer.finishDraw(mWindow->getWindowHandle());
+        mFramePacer.endFrame(mRenderer.getLastGpuTime(), mRenderer.getLastFenceWait());
 
-        mRenderer.endRenderPass();
-        mRenderer.bindFontPipeline(cb);
-        mRenderer.updateFontUniforms();
+        mProfilerOverlay.update(mRenderer.getGpuProfiler(), mFramePacer.getAverage(), mRenderer.getLastDrawCounters(), mRenderer.getSwapchainDimensions());
 
-        mUIManager.drawComponentTextLabels();
-        
-        mRenderer.endRenderPass();
-        mRenderer.finishDraw(mWindow->getWindowHandle());
-        Graphics::Window::pollEvents();
+        KE_PROFILE_COLLECT();
     }
+
+    util::Profiler::getInstance().endCapture(mTracePath);
     
-    mAudioManager.StopAudio(musicIndex);
+    mAudioManager.StopAudio(mMusicIndex);
     mLogger.info("Exit main loop.");
 }
 
+void ke::Core::Application::runHeadless()
+{
+    mLogger.info("Rendering {} headless frames at {}x{}.", mHeadlessFrames, mHeadlessSize.x, mHeadlessSize.y);
+
+    KE_PROFILE_THREAD("Main");
+    if(mTraceFromStart) util::Profiler::getInstance().beginCapture();
+
+    if(!mDumpDirectory.empty())
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(mDumpDirectory, ec);
+    }
+
+    glm::ivec2 framebufferSize = getFramebufferSize();
+    float aspectRatio = static_cast<float>(framebufferSize.x) / static_cast<float>(framebufferSize.y);
+
+    mHeadlessFrameStats.clear();
+    mHeadlessFrameStats.reserve(mHeadlessFrames);
+
+    for(uint32_t frame = 0; frame < mHeadlessFrames; frame++)
+    {
+        KE_PROFILE_ZONE("Frame");
+        mFramePacer.beginFrame();
+        mJobSystem.runMainThreadJobs();
+        mTextUtils.update();
+
+        mRenderer.readyCanvas(nullptr);
+        VkCommandBuffer cb = mRenderer.getCurrentCommandBuffer();
+
+        mRenderer.updateUIUniforms(aspectRatio);
+        mRenderer.updateSceneUniforms(mSceneManager.getSceneAspectRatio());
+        mRenderer.updateFontUniforms();
+
+        mRenderGraph.setImportedImage(mBackbuffer, mRenderer.getCurrentSwapchainImage());
+        mRenderGraph.setImportedImage(mDepthBuffer, mRenderer.getDepthImage());
+        {
+            KE_PROFILE_ZONE("RecordFrame");
+            mRenderGraph.execute(cb);
+        }
+
+        // Counted from the end so the final frame is always among the dumped ones.
+        if(!mDumpDirectory.empty() && (mHeadlessFrames - 1 - frame) % mDumpInterval == 0)
+            mRenderer.requestFrameCapture((mDumpDirectory / fmt::format("frame_{:05d}.png", frame)).string());
+
+        mRenderer.finishDraw(nullptr);
+        mFramePacer.endFrame(mRenderer.getLastGpuTime(), mRenderer.getLastFenceWait());
+        mHeadlessFrameStats.push_back(mFramePacer.getLastFrame());
+
+        KE_PROFILE_COLLECT();
+    }
+
+    util::Profiler::getInstance().endCapture(mTracePath);
+    reportFrameTimings(mHeadlessFrameStats);
+}
+
+void ke::Core::Application::reportFrameTimings(const std::vector<Graphics::FrameStats>& frames) const
+{
+    if(frames.empty()) return;
+
+    if(!mTimingsPath.empty())
+    {
+        std::ofstream file(mTimingsPath, std::ios::trunc);
+        file << "frame,cpu_ms,gpu_ms,fence_wait_ms,frame_ms,heap_allocations\n";
+        for(size_t i = 0; i < frames.size(); i++)
+            file << fmt::format("{},{:.4f},{:.4f},{:.4f},{:.4f},{:.0f}\n", i, frames[i].cpuTime, frames[i].gpuTime, frames[i].fenceWait, frames[i].frameTime, frames[i].heapAllocations);
+    }
+
+    // GPU times lag by the frames in flight, the first few frames are warm-up either way.
+    auto summarize = [&frames](float Graphics::FrameStats::*field)
+    {
+        std::vector<float> values;
+        for(const Graphics::FrameStats& stats : frames)
+            values.push_back(stats.*field);
+        std::sort(values.begin(), values.end());
+
+        float sum = 0.0f;
+        for(float value : values) sum += value;
+
+        auto at = [&values](float p) {return values[static_cast<size_t>(p * static_cast<float>(values.size() - 1))];};
+        return fmt::format("avg {:.3f} p50 {:.3f} p95 {:.3f} p99 {:.3f} ms", sum / static_cast<float>(values.size()), at(0.50f), at(0.95f), at(0.99f));
+    };
+
+    std::cout << "Headless run, " << frames.size() << " frames\n"
+              << "  frame " << summarize(&Graphics::FrameStats::frameTime) << "\n"
+              << "  cpu   " << summarize(&Graphics::FrameStats::cpuTime) << "\n"
+              << "  gpu   " << summarize(&Graphics::FrameStats::gpuTime) << "\n";
+}
+
+glm::ivec2 ke::Core::Application::getFramebufferSize() const
+{
+    if(mHeadless) return mRenderer.getSwapchainDimensions();
+
+    int width, height;
+    glfwGetFramebufferSize(mWindow->getWindowHandle(), &width, &height);
+    return {width, height};
+}
+
 void ke::Core::Application::terminate()
 {
     mLogger.trace("Proceeding to termination.");
@@ -118,22 +386,34 @@ void ke::Core::Application::terminate()
     mTextureManager.terminate();
     mLogger.info("Finished unloading textures.");
 
-    mLogger.info("Requesting audio termination.");
-    mAudioManager.terminate();
-    mLogger.info("Finished unloading audio.");
+    if(!mHeadless)
+    {
+        mLogger.info("Requesting audio termination.");
+        mAudioManager.terminate();
+        mLogger.info("Finished unloading audio.");
+    }
     
     mLogger.info("Requesting text termination.");
     mTextUtils.terminate();
     mLogger.info("Finished unloading text.");
     
+    mProfilerOverlay.clear();
+    mRenderGraph.destroy();
+
     mLogger.trace("Requesting renderer termination.");
     mRenderer.terminate();
     mLogger.trace("Finished terminating renderer.");
 
-    Graphics::Window::exitGLFW();
-    mLogger.info("Exit GLFW.");
+    mJobSystem.shutdown();
+
+    if(!mHeadless)
+    {
+        Graphics::Window::exitGLFW();
+        mLogger.info("Exit GLFW.");
+    }
     
     mLogger.info("Goodbye.");
+    util::Logger::flush();
 }
 
 
@@ -145,11 +425,25 @@ void ke::Core::Application::onEvent(Events::Event &ev)
     {
         Application& app = Application::getInstance();
 
-        if(app.mUIManager.processFunctionalKey(e.getKeyCode()))
+        if(app.mUIManager.processFunctionalKey(e.getKeyCode(), e.getMods()))
             return true;
+
+        // Held keys only repeat into text editing.
+        if(e.isRepeated()) return true;
         
         if(e.getKeyCode() == GLFW_KEY_Q && app.mWindow->isKeyPressed(GLFW_KEY_LEFT_CONTROL)) // LCTRL + Q = QUIT
             {app.mWindow->quit(); return true;}
+
+        if(e.getKeyCode() == GLFW_KEY_F3) // F3 = PROFILER OVERLAY
+            {app.mProfilerOverlay.toggle(); return true;}
+
+        if(e.getKeyCode() == GLFW_KEY_F4) // F4 = START / STOP CPU TRACE
+        {
+            util::Profiler& profiler = util::Profiler::getInstance();
+            if(profiler.isCapturing()) profiler.endCapture(app.mTracePath);
+            else profiler.beginCapture();
+            return true;
+        }
         
         return true;
     });
@@ -165,11 +459,9 @@ void ke::Core::Application::onEvent(Events::Event &ev)
         std::cout << "WINDOW RESIZED, width: " << e.getWidth() << ", height: " << e.getHeight() << "\n";
         app.mRenderer.signalWindowResize();
 
-        app.mUIManager.recreateSceneComponent(app.mWindow->getWindowHandle());
-
-        int x,y;
-        glfwGetFramebufferSize(app.mWindow->getWindowHandle(), &x, &y);
-        app.mSceneManager.recreateViewport(app.mUIManager.getSceneComponentPosition(), app.mUIManager.getSceneComponentExtent(), y);
+        glm::ivec2 framebufferSize = app.getFramebufferSize();
+        app.mUIManager.recreateSceneComponent(framebufferSize);
+        app.mSceneManager.recreateViewport(app.mUIManager.getSceneComponentPosition(), app.mUIManager.getSceneComponentExtent(), framebufferSize.y);
 
         return true;
     });
@@ -179,12 +471,24 @@ void ke::Core::Application::onEvent(Events::Event &ev)
 
         GLFWwindow* window = app.mWindow->getWindowHandle();
 
-        int wx, wy;
-        glfwGetFramebufferSize(window, &wx, &wy);
+        // The cursor is in window coordinates, which only match framebuffer pixels without display scaling.
+        int wx, wy, fx, fy;
+        glfwGetWindowSize(window, &wx, &wy);
+        glfwGetFramebufferSize(window, &fx, &fy);
 
         if(e.getButton() == GLFW_MOUSE_BUTTON_LEFT)
-            app.mUIManager.processMouseClick(e.getMouseX(), e.getMouseY(), wx, wy);
+            app.mUIManager.processMouseClick(e.getMouseX(), e.getMouseY(), wx, wy, fx);
+
+        return true;
+    });
+    dispatcher.Dispatch<Events::MouseMovedEvent>([](Events::MouseMovedEvent& e)
+    {
+        Application& app = Application::getInstance();
+
+        int wx, wy;
+        glfwGetWindowSize(app.mWindow->getWindowHandle(), &wx, &wy);
 
+        app.mUIManager.processMouseMove(e.getMouseX(), e.getMouseY(), wx, wy);
         return true;
     });
     dispatcher.Dispatch<Events::TextInputEvent>([](Events::TextInputEvent& e)
@@ -1,12 +1,17 @@
 #include "Graphics/Window.hpp"
 #include "Graphics/Renderer.hpp"
+#include "Graphics/RenderGraph.hpp"
+#include "Graphics/FramePacer.hpp"
+#include "Graphics/ProfilerOverlay.hpp"
 #include "InterfaceManager.hpp"
 #include "SceneManager.hpp"
 #include "Graphics/Texture.hpp"
 #include "Audio/AudioManager.hpp"
 #include "Events/event_pch.hpp"
+#include "Utility/JobSystem.hpp"
 #include <memory>
-#include <future>
+#include <filesystem>
+#include <functional>
 
 namespace ke
 {
@@ -17,7 +22,11 @@ namespace ke
 		public:
 			static Application& getInstance();
 
-			void Run();
+			void Run(int argc = 0, char** argv = nullptr);
+
+			// Called once every subsystem is up, before the first frame. Used by the benchmark target.
+			void setOnInitialized(std::function<void()> callback) {mOnInitialized = std::move(callback);}
+			const std::vector<Graphics::FrameStats>& getHeadlessFrameStats() const {return mHeadlessFrameStats;}
 		private:
 			Application() = default;
 
@@ -28,13 +37,38 @@ namespace ke
 			Graphics::Texture::TextureManager& mTextureManager = Graphics::Texture::TextureManager::getInstance();
 			Audio::AudioManager& mAudioManager = Audio::AudioManager::getInstance();
 			Graphics::Text::TextUtils& mTextUtils = Graphics::Text::TextUtils::getInstance();
+			util::JobSystem& mJobSystem = util::JobSystem::getInstance();
 			
 			util::Logger mLogger = util::Logger("Main Application Logger");
 
 			GLFWmonitor* mMonitor = nullptr;
 
+			Graphics::FramePacer mFramePacer;
+			Graphics::ProfilerOverlay mProfilerOverlay;
+			std::string mTracePath = "trace.json";
+			bool mTraceFromStart = false;
+
+			bool mHeadless = false;
+			glm::ivec2 mHeadlessSize = {1280, 720};
+			uint32_t mHeadlessFrames = 300;
+			uint32_t mDumpInterval = 1;
+			std::filesystem::path mDumpDirectory;
+			std::string mTimingsPath;
+			std::vector<Graphics::FrameStats> mHeadlessFrameStats;
+			std::function<void()> mOnInitialized;
+			uint16_t mMusicIndex = 0;
+
+			Graphics::RenderGraph mRenderGraph;
+			Graphics::ResourceHandle mBackbuffer;
+			Graphics::ResourceHandle mDepthBuffer;
+
+			void parseArguments(int argc, char** argv);
 			void init();
+			void buildRenderGraph();
 			void run();
+			void runHeadless();
+			void reportFrameTimings(const std::vector<Graphics::FrameStats>& frames) const;
+			glm::ivec2 getFramebufferSize() const;
 			void terminate();
 
 			static void onEvent(Events::Event& ev);
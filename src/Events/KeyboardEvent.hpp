@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+
 #include "Event.hpp"
 
 
@@ -23,14 +25,18 @@ namespace ke
         class KeyPressedEvent : public KeyEvent
         {
         public:
-            KeyPressedEvent(int _keycode, bool isRepeated)
-                : KeyEvent(_keycode), mIsRepeated(isRepeated) {}
+            KeyPressedEvent(int _keycode, bool isRepeated, int mods = 0)
+                : KeyEvent(_keycode), mIsRepeated(isRepeated), mMods(mods) {}
             
             EVENT_TYPE(KeyPressedEvent);
             EVENT_CATEGORY(KeyboardEvent);
 
+            bool isRepeated() const {return mIsRepeated;}
+            int getMods() const {return mMods;}
+
         private:
             bool mIsRepeated = false;
+            int mMods = 0;
         };
 
         class KeyReleasedEvent : public KeyEvent
@@ -50,12 +56,12 @@ namespace ke
             EVENT_CATEGORY(KeyboardEvent)
             EVENT_TYPE(TextInputEvent)
         
-            TextInputEvent(int codepoint)
+            TextInputEvent(uint32_t codepoint)
                 : Event(), mCodepoint(codepoint) {}
             
-            char getCodepoint() const {return mCodepoint;}
+            uint32_t getCodepoint() const {return mCodepoint;}
         private:
-            char mCodepoint;
+            uint32_t mCodepoint;
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include "EditableText.hpp"
+
+#include "Renderer.hpp"
+#include "../Utility/Utf8.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    bool isWhitespace(uint32_t codepoint)
+    {
+        return codepoint == ' ' || codepoint == '\t';
+    }
+}
+
+ke::Graphics::Text::EditableText::EditableText(const std::string& font, int x, int y, float pixelSize, glm::vec4 color)
+    : mFont(&TextUtils::getInstance().getFont(font)), mX(x), mY(y), mPixelSize(pixelSize), mColor(color)
+{
+    mFontVersion = mFont->getVersion();
+}
+
+void ke::Graphics::Text::EditableText::setText(const std::string& text)
+{
+    mCells.clear();
+    mInstances.clear();
+
+    for(size_t pos = 0; pos < text.size();)
+    {
+        mCaret = mAnchor = mCells.size();
+        insert(util::decodeUtf8(text, pos));
+    }
+
+    mCaret = mAnchor = mCells.size();
+}
+
+std::string ke::Graphics::Text::EditableText::getText() const
+{
+    std::string text;
+    for(const Cell& cell : mCells)
+        util::appendUtf8(text, cell.codepoint);
+    return text;
+}
+
+std::string ke::Graphics::Text::EditableText::getSelectedText() const
+{
+    std::string text;
+    for(size_t i = std::min(mCaret, mAnchor); i < std::max(mCaret, mAnchor); i++)
+        util::appendUtf8(text, mCells[i].codepoint);
+    return text;
+}
+
+float ke::Graphics::Text::EditableText::getPen(size_t index) const
+{
+    if(index == 0) return 0.0f;
+    return mCells[index - 1].x + mCells[index - 1].advance;
+}
+
+float ke::Graphics::Text::EditableText::place(size_t index) const
+{
+    float pen = getPen(index);
+    if(index > 0) pen += static_cast<float>(mFont->getKerning(mCells[index - 1].codepoint, mCells[index].codepoint)) * getScale();
+    return pen;
+}
+
+void ke::Graphics::Text::EditableText::reflow(size_t index)
+{
+    if(index >= mCells.size()) return;
+
+    // Only the pair at the edit changes kerning, everything after it moves by the same amount.
+    float delta = place(index) - mCells[index].x;
+    if(delta == 0.0f) return;
+
+    for(size_t i = index; i < mCells.size(); i++)
+    {
+        mCells[i].x += delta;
+        mInstances[i].position.x += delta;
+    }
+}
+
+void ke::Graphics::Text::EditableText::insert(uint32_t codepoint)
+{
+    if(!mFont || (codepoint < 0x20 && codepoint != '\t') || codepoint == 0x7F) return;
+
+    if(hasSelection()) eraseRange(std::min(mCaret, mAnchor), std::max(mCaret, mAnchor));
+
+    Cell cell{codepoint, 0.0f, static_cast<float>(mFont->getAdvance(codepoint)) * getScale()};
+    mCells.insert(mCells.begin() + mCaret, cell);
+    mInstances.insert(mInstances.begin() + mCaret, GlyphInstance{});
+
+    mCells[mCaret].x = place(mCaret);
+    writeInstance(mCaret);
+
+    mAnchor = ++mCaret;
+    reflow(mCaret);
+}
+
+void ke::Graphics::Text::EditableText::eraseRange(size_t first, size_t last)
+{
+    mCells.erase(mCells.begin() + first, mCells.begin() + last);
+    mInstances.erase(mInstances.begin() + first, mInstances.begin() + last);
+
+    mCaret = mAnchor = first;
+    reflow(first);
+}
+
+bool ke::Graphics::Text::EditableText::eraseBackward()
+{
+    if(hasSelection()) eraseRange(std::min(mCaret, mAnchor), std::max(mCaret, mAnchor));
+    else if(mCaret > 0) eraseRange(mCaret - 1, mCaret);
+    else return false;
+
+    return true;
+}
+
+bool ke::Graphics::Text::EditableText::eraseForward()
+{
+    if(hasSelection()) eraseRange(std::min(mCaret, mAnchor), std::max(mCaret, mAnchor));
+    else if(mCaret < mCells.size()) eraseRange(mCaret, mCaret + 1);
+    else return false;
+
+    return true;
+}
+
+void ke::Graphics::Text::EditableText::setCaret(size_t index, bool select)
+{
+    mCaret = std::min(index, mCells.size());
+    if(!select) mAnchor = mCaret;
+}
+
+void ke::Graphics::Text::EditableText::moveCaret(int delta, bool select)
+{
+    // Without shift an arrow first collapses the selection to the side it points at.
+    if(!select && hasSelection())
+    {
+        setCaret(delta < 0 ? std::min(mCaret, mAnchor) : std::max(mCaret, mAnchor));
+        return;
+    }
+
+    int64_t target = static_cast<int64_t>(mCaret) + delta;
+    setCaret(static_cast<size_t>(std::clamp<int64_t>(target, 0, static_cast<int64_t>(mCells.size()))), select);
+}
+
+void ke::Graphics::Text::EditableText::selectAll()
+{
+    mAnchor = 0;
+    mCaret = mCells.size();
+}
+
+void ke::Graphics::Text::EditableText::setPlacement(int x, int y, float pixelSize)
+{
+    glm::vec2 delta(static_cast<float>(x - mX), static_cast<float>(y - mY));
+    mX = x;
+    mY = y;
+
+    if(!mFont) return;
+
+    // Advances and kerning scale with the size, so every cell is placed again.
+    if(pixelSize != mPixelSize)
+    {
+        mPixelSize = pixelSize;
+        for(size_t i = 0; i < mCells.size(); i++)
+        {
+            mCells[i].advance = static_cast<float>(mFont->getAdvance(mCells[i].codepoint)) * getScale();
+            mCells[i].x = place(i);
+            writeInstance(i);
+        }
+        return;
+    }
+
+    for(GlyphInstance& instance : mInstances)
+        instance.position += delta;
+}
+
+size_t ke::Graphics::Text::EditableText::hitTest(float x) const
+{
+    float local = x - static_cast<float>(mX);
+    for(size_t i = 0; i < mCells.size(); i++)
+        if(local < mCells[i].x + mCells[i].advance * 0.5f) return i;
+
+    return mCells.size();
+}
+
+void ke::Graphics::Text::EditableText::writeInstance(size_t index) const
+{
+    const Cell& cell = mCells[index];
+    GlyphInstance& instance = mInstances[index];
+
+    const GlyphInfo* ginfo = isWhitespace(cell.codepoint) ? nullptr : mFont->findGlyph(cell.codepoint);
+    cell.resident = ginfo != nullptr;
+    cell.missing = !ginfo && !isWhitespace(cell.codepoint);
+
+    glm::vec2 origin(mX + cell.x, static_cast<float>(mY));
+    if(!ginfo)
+    {
+        instance = GlyphInstance{};
+        instance.position = origin;
+        return;
+    }
+
+    float glyphScale = mPixelSize / TextUtils::getRasterEmSize();
+    instance = GlyphInstance{
+        .position = {origin.x + ginfo->bearingX * glyphScale, origin.y + (ginfo->bearingY - (float)ginfo->height) * glyphScale},
+        .size = {ginfo->width * glyphScale, ginfo->height * glyphScale},
+        .uv = {ginfo->u0, ginfo->v0, ginfo->u1, ginfo->v1},
+        .color = mColor,
+        .atlas = {mFont->getDescriptorIndex(ginfo->page), mFont->getFormat() == GlyphFormat::SDF ? 1u : 0u},
+    };
+    cell.page = ginfo->page;
+    cell.generation = mFont->getPageGeneration(ginfo->page);
+}
+
+void ke::Graphics::Text::EditableText::refresh() const
+{
+    if(mFont->getVersion() == mFontVersion) return;
+    mFontVersion = mFont->getVersion();
+
+    // Glyphs arrived or a page was evicted, positions stay as they are.
+    for(size_t i = 0; i < mCells.size(); i++)
+    {
+        const Cell& cell = mCells[i];
+        if(cell.missing || (cell.resident && mFont->getPageGeneration(cell.page) != cell.generation))
+            writeInstance(i);
+    }
+}
+
+bool ke::Graphics::Text::EditableText::blockQuad(float x0, float x1, glm::vec4 color, GlyphInstance& instance) const
+{
+    const GlyphInfo* block = mFont->findGlyph(BLOCK_CODEPOINT);
+    if(!block || block->width <= 4 || block->height <= 4) return false;
+    mFont->touchPage(block->page);
+
+    float scale = getScale();
+    float top = static_cast<float>(mFont->getAscender()) * scale;
+    float bottom = static_cast<float>(mFont->getAscender() - mFont->getLineHeight()) * scale;
+
+    // Stretch the outline, without its 2 texel border, over the rectangle.
+    float scaleX = (x1 - x0) / static_cast<float>(block->width - 4);
+    float scaleY = (top - bottom) / static_cast<float>(block->height - 4);
+
+    instance = GlyphInstance{
+        .position = {mX + x0 - 2.0f * scaleX, mY + bottom - 2.0f * scaleY},
+        .size = {block->width * scaleX, block->height * scaleY},
+        .uv = {block->u0, block->v0, block->u1, block->v1},
+        .color = color,
+        .atlas = {mFont->getDescriptorIndex(block->page), mFont->getFormat() == GlyphFormat::SDF ? 1u : 0u},
+    };
+    return true;
+}
+
+void ke::Graphics::Text::EditableText::Draw() const
+{
+    static Renderer& rend = Renderer::getInstance();
+    if(!mFont) return;
+
+    refresh();
+
+    // Same draw as the glyphs, so the selection goes in first to end up underneath.
+    GlyphInstance quad;
+    if(hasSelection() && blockQuad(getPen(std::min(mCaret, mAnchor)), getPen(std::max(mCaret, mAnchor)), mSelectionColor, quad))
+        rend.queueText(&quad, 1);
+
+    for(const Cell& cell : mCells)
+        if(cell.resident) mFont->touchPage(cell.page);
+    rend.queueText(mInstances.data(), static_cast<uint32_t>(mInstances.size()));
+
+    if(mCaretVisible)
+    {
+        float caretWidth = std::max(1.0f, std::round(mPixelSize / 16.0f));
+        float x = getPen(mCaret);
+        if(blockQuad(x - caretWidth * 0.5f, x + caretWidth * 0.5f, mColor, quad))
+            rend.queueText(&quad, 1);
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "TextUtilities.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        namespace Text
+        {
+            // A single line of text that is edited in place. Every character keeps its own glyph instance, so an
+            // edit at the caret lays out just that character and shifts the ones after it, and typing or deleting
+            // at the end costs the same however long the line is. Nothing touches the GPU, the instances go into
+            // the frame's text batch on Draw.
+            class EditableText
+            {
+            public:
+                static constexpr uint32_t BLOCK_CODEPOINT = 0x2588;     // full block, stretched for the caret and selection
+
+                EditableText() = default;
+                // (x, y) is the start of the baseline.
+                EditableText(const std::string& font, int x, int y, float pixelSize, glm::vec4 color);
+
+                void setText(const std::string& text);
+                std::string getText() const;
+                size_t getLength() const {return mCells.size();}
+                bool empty() const {return mCells.empty();}
+
+                // Edits happen at the caret and replace the selection when there is one.
+                void insert(uint32_t codepoint);
+                bool eraseBackward();
+                bool eraseForward();
+
+                // With select the anchor stays where it is and the selection follows the caret.
+                void setCaret(size_t index, bool select = false);
+                void moveCaret(int delta, bool select = false);
+                size_t getCaret() const {return mCaret;}
+                void selectAll();
+                bool hasSelection() const {return mAnchor != mCaret;}
+                std::string getSelectedText() const;
+
+                // Moves the line to a new baseline start and size, the text, caret and selection stay as they are.
+                void setPlacement(int x, int y, float pixelSize);
+
+                // Character boundary closest to a framebuffer x in pixels.
+                size_t hitTest(float x) const;
+
+                void setCaretVisible(bool visible) {mCaretVisible = visible;}
+                void setSelectionColor(glm::vec4 color) {mSelectionColor = color;}
+
+                void Draw() const;
+            private:
+                struct Cell
+                {
+                    uint32_t codepoint;
+                    float x;            // pen at the glyph's origin, relative to mX
+                    float advance;
+
+                    mutable bool resident = false;
+                    mutable bool missing = false;   // requested from the font, not rasterized yet
+                    mutable uint16_t page = 0;
+                    mutable uint32_t generation = 0;
+                };
+
+                float getPen(size_t index) const;
+                float getScale() const {return mPixelSize / static_cast<float>(mFont->getEmSize());}
+                // Where the glyph at index starts given the one before it.
+                float place(size_t index) const;
+                // Moves everything from index on by the change in where index now starts.
+                void reflow(size_t index);
+                void eraseRange(size_t first, size_t last);
+
+                // Instances are patched per cell, glyphs still rasterizing get theirs once they arrive.
+                void writeInstance(size_t index) const;
+                void refresh() const;
+                bool blockQuad(float x0, float x1, glm::vec4 color, GlyphInstance& instance) const;
+
+                Font* mFont = nullptr;
+                int mX = 0, mY = 0;
+                float mPixelSize = 0.0f;
+                glm::vec4 mColor{1.0f};
+                glm::vec4 mSelectionColor{0.2f, 0.4f, 0.8f, 0.6f};
+
+                std::vector<Cell> mCells;
+                size_t mCaret = 0;
+                size_t mAnchor = 0;
+                bool mCaretVisible = false;
+
+                // One per cell, whitespace and glyphs that aren't resident yet have no size.
+                mutable std::vector<GlyphInstance> mInstances;
+                mutable uint64_t mFontVersion = 0;
+            };
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "FrameCapture.hpp"
+#include "../Utility/RenderUtil.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stb/stb_image_write.h>
+
+void ke::Graphics::FrameCapture::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameSlots)
+{
+    mDevice = device;
+    mPhysicalDevice = physicalDevice;
+    mSlots.assign(frameSlots, Slot{});
+}
+
+void ke::Graphics::FrameCapture::destroy()
+{
+    resolveAll();
+
+    util::JobSystem::getInstance().wait(mEncodes);
+    reportFailedEncodes();
+
+    for(Slot& slot : mSlots)
+        releaseBuffer(slot);
+    mSlots.clear();
+}
+
+void ke::Graphics::FrameCapture::record(VkCommandBuffer commandBuffer, uint32_t slot, VkImage image, VkImageLayout layout, VkExtent2D extent, VkFormat format, const std::string& path)
+{
+    if(slot >= mSlots.size()) return;
+
+    if(format != VK_FORMAT_B8G8R8A8_SRGB && format != VK_FORMAT_B8G8R8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB && format != VK_FORMAT_R8G8B8A8_UNORM)
+    {
+        mLogger.error("Frame capture only supports 8-bit RGBA/BGRA backbuffers!");
+        return;
+    }
+
+    Slot& target = mSlots[slot];
+    if(!ensureBuffer(target, static_cast<VkDeviceSize>(extent.width) * extent.height * 4)) return;
+
+    VkImageMemoryBarrier toTransfer{};
+    toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout = layout;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = image;
+    toTransfer.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {extent.width, extent.height, 1};
+
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target.buffer, 1, &region);
+
+    VkBufferMemoryBarrier toHost{};
+    toHost.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = target.buffer;
+    toHost.size = VK_WHOLE_SIZE;
+
+    VkImageMemoryBarrier restore = toTransfer;
+    restore.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    restore.dstAccessMask = 0;
+    restore.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    restore.newLayout = layout;
+
+    bool restoreLayout = layout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+        0, nullptr, 1, &toHost, restoreLayout ? 1 : 0, restoreLayout ? &restore : nullptr);
+
+    target.extent = extent;
+    target.format = format;
+    target.path = path;
+    target.pending = true;
+}
+
+void ke::Graphics::FrameCapture::resolve(uint32_t slot)
+{
+    if(slot >= mSlots.size() || !mSlots[slot].pending) return;
+
+    Slot& source = mSlots[slot];
+    source.pending = false;
+
+    uint32_t width = source.extent.width;
+    uint32_t height = source.extent.height;
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    memcpy(pixels.data(), source.mapped, pixels.size());
+
+    bool swizzle = source.format == VK_FORMAT_B8G8R8A8_SRGB || source.format == VK_FORMAT_B8G8R8A8_UNORM;
+    std::string path = source.path;
+
+    reportFailedEncodes();
+
+    util::JobSystem::getInstance().schedule([this, pixels = std::move(pixels), width, height, swizzle, path]() mutable
+    {
+        if(swizzle)
+            for(size_t i = 0; i < pixels.size(); i += 4)
+                std::swap(pixels[i], pixels[i + 2]);
+
+        if(stbi_write_png(path.c_str(), static_cast<int>(width), static_cast<int>(height), 4, pixels.data(), static_cast<int>(width * 4)) == 0)
+            mFailedEncodes.fetch_add(1, std::memory_order_relaxed);
+    }, {"EncodeCapture", &mEncodes});
+}
+
+void ke::Graphics::FrameCapture::reportFailedEncodes()
+{
+    // Encodes finish on job workers, their failures are logged from the render thread.
+    if(uint32_t failed = mFailedEncodes.exchange(0, std::memory_order_relaxed))
+        mLogger.error("Failed to write {} captured frame(s)!", failed);
+}
+
+void ke::Graphics::FrameCapture::resolveAll()
+{
+    for(uint32_t slot = 0; slot < mSlots.size(); slot++)
+        resolve(slot);
+}
+
+bool ke::Graphics::FrameCapture::ensureBuffer(Slot& slot, VkDeviceSize size)
+{
+    if(slot.buffer != VK_NULL_HANDLE && slot.size >= size) return true;
+
+    releaseBuffer(slot);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(mDevice, &bufferInfo, nullptr, &slot.buffer) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to create frame capture buffer!");
+        slot.buffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(mDevice, slot.buffer, &requirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = util::findMemoryType(mPhysicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    if(allocInfo.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(mDevice, &allocInfo, nullptr, &slot.memory) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to allocate frame capture memory!");
+        releaseBuffer(slot);
+        return false;
+    }
+
+    vkBindBufferMemory(mDevice, slot.buffer, slot.memory, 0);
+    vkMapMemory(mDevice, slot.memory, 0, size, 0, &slot.mapped);
+    slot.size = size;
+
+    return true;
+}
+
+void ke::Graphics::FrameCapture::releaseBuffer(Slot& slot)
+{
+    if(slot.memory != VK_NULL_HANDLE)
+    {
+        vkUnmapMemory(mDevice, slot.memory);
+        vkFreeMemory(mDevice, slot.memory, nullptr);
+    }
+    if(slot.buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(mDevice, slot.buffer, nullptr);
+
+    slot.buffer = VK_NULL_HANDLE;
+    slot.memory = VK_NULL_HANDLE;
+    slot.mapped = nullptr;
+    slot.size = 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "../Utility/Logger.hpp"
+#include "../Utility/JobSystem.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        // Copies a finished backbuffer into a host-visible buffer owned by the frame slot. The copy is picked up
+        // once the slot's fence has signaled and encoded to PNG off the render thread.
+        class FrameCapture
+        {
+        public:
+            FrameCapture() = default;
+
+            void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameSlots);
+            void destroy();
+
+            void record(VkCommandBuffer commandBuffer, uint32_t slot, VkImage image, VkImageLayout layout, VkExtent2D extent, VkFormat format, const std::string& path);
+            void resolve(uint32_t slot);
+            void resolveAll();
+        private:
+            struct Slot
+            {
+                VkBuffer buffer = VK_NULL_HANDLE;
+                VkDeviceMemory memory = VK_NULL_HANDLE;
+                void* mapped = nullptr;
+                VkDeviceSize size = 0;
+
+                VkExtent2D extent{};
+                VkFormat format = VK_FORMAT_UNDEFINED;
+                std::string path;
+                bool pending = false;
+            };
+
+            void reportFailedEncodes();
+            bool ensureBuffer(Slot& slot, VkDeviceSize size);
+            void releaseBuffer(Slot& slot);
+
+            util::Logger mLogger = util::Logger("Frame Capture Logger");
+
+            VkDevice mDevice = VK_NULL_HANDLE;
+            VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+
+            std::vector<Slot> mSlots;
+            util::JobCounter mEncodes;
+            std::atomic<uint32_t> mFailedEncodes{0};
+        };
+    }
+}
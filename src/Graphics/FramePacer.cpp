@@ -0,0 +1,117 @@
+#include "FramePacer.hpp"
+
+#include "../Utility/FrameAllocator.hpp"
+
+#include <algorithm>
+#include <thread>
+
+void ke::Graphics::FramePacer::setTargetFrameRate(float framesPerSecond)
+{
+    mTargetFrameTime = framesPerSecond > 0.0f ? 1000.0f / framesPerSecond : 0.0f;
+}
+
+void ke::Graphics::FramePacer::waitBeforeInput()
+{
+    Clock::time_point now = Clock::now();
+
+    mPacingSleep = mEnabled ? std::max(0.0f, mPredictedWait - SAFETY_MARGIN) : 0.0f;
+    float sleepTime = mPacingSleep;
+
+    if(mTargetFrameTime > 0.0f && mPreviousStart != Clock::time_point{})
+    {
+        float sinceStart = std::chrono::duration<float, std::milli>(now - mPreviousStart).count();
+        sleepTime = std::max(sleepTime, mTargetFrameTime - sinceStart);
+    }
+
+    if(sleepTime > 0.0f)
+        sleepFor(sleepTime);
+
+    mPendingSleep = sleepTime;
+}
+
+void ke::Graphics::FramePacer::beginFrame()
+{
+    mFrameStart = Clock::now();
+    mFrameStartAllocations = util::getHeapAllocationCount();
+}
+
+void ke::Graphics::FramePacer::endFrame(float gpuTime, float fenceWait)
+{
+    Clock::time_point now = Clock::now();
+
+    FrameStats& stats = mHistory[mFrameIndex];
+    stats.cpuTime = std::chrono::duration<float, std::milli>(now - mFrameStart).count();
+    stats.gpuTime = gpuTime;
+    stats.fenceWait = fenceWait;
+    stats.sleepTime = mPendingSleep;
+    stats.frameTime = mPreviousStart != Clock::time_point{} ? std::chrono::duration<float, std::milli>(mFrameStart - mPreviousStart).count() : 0.0f;
+    stats.heapAllocations = static_cast<float>(util::getHeapAllocationCount() - mFrameStartAllocations);
+
+    // The slack is what we slept plus whatever we still blocked on the fence afterwards.
+    // No fence wait at all means we may have overslept, so back off instead.
+    float observedSlack = mPacingSleep + fenceWait;
+    if(fenceWait < 0.05f) observedSlack = mPacingSleep * 0.9f;
+    mPredictedWait += (observedSlack - mPredictedWait) * SMOOTHING;
+
+    mPreviousStart = mFrameStart;
+    mFrameIndex = (mFrameIndex + 1) % HISTORY_SIZE;
+    mRecordedFrames = std::min(mRecordedFrames + 1, HISTORY_SIZE);
+
+    if(mLastSummary == Clock::time_point{}) mLastSummary = now;
+    if(now - mLastSummary > std::chrono::seconds(5))
+    {
+        logSummary();
+        mLastSummary = now;
+    }
+}
+
+ke::Graphics::FrameStats ke::Graphics::FramePacer::getAverage() const
+{
+    FrameStats average{};
+    if(mRecordedFrames == 0) return average;
+
+    for(uint32_t i = 0; i < mRecordedFrames; i++)
+    {
+        const FrameStats& stats = mHistory[(mFrameIndex + HISTORY_SIZE - 1 - i) % HISTORY_SIZE];
+        average.cpuTime += stats.cpuTime;
+        average.gpuTime += stats.gpuTime;
+        average.fenceWait += stats.fenceWait;
+        average.sleepTime += stats.sleepTime;
+        average.frameTime += stats.frameTime;
+        average.heapAllocations += stats.heapAllocations;
+    }
+
+    float count = static_cast<float>(mRecordedFrames);
+    average.cpuTime /= count;
+    average.gpuTime /= count;
+    average.fenceWait /= count;
+    average.sleepTime /= count;
+    average.frameTime /= count;
+    average.heapAllocations /= count;
+
+    return average;
+}
+
+void ke::Graphics::FramePacer::sleepFor(float milliseconds)
+{
+    Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(milliseconds));
+
+    // The OS sleep overshoots by up to a millisecond or so, spin the rest.
+    if(milliseconds > 2.0f)
+        std::this_thread::sleep_until(deadline - std::chrono::milliseconds(1));
+
+    while(Clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+void ke::Graphics::FramePacer::logSummary()
+{
+    FrameStats average = getAverage();
+
+    mLogger.info("Frame {:.2f} ms ({:.0f} fps) | CPU {:.2f} ms | GPU {:.2f} ms | fence wait {:.2f} ms | paced sleep {:.2f} ms",
+        average.frameTime, average.frameTime > 0.0f ? 1000.0f / average.frameTime : 0.0f, average.cpuTime, average.gpuTime, average.fenceWait, average.sleepTime);
+
+    if(util::isCountingHeapAllocations())
+        mLogger.info("Heap allocations per frame {:.1f} | frame arena high water {} KiB",
+            average.heapAllocations, util::FrameArena::getThreadArena().getHighWater() / 1024);
+}
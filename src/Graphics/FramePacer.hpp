@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "../Utility/Logger.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        struct FrameStats
+        {
+            float cpuTime = 0.0f;    // input poll to submit
+            float gpuTime = 0.0f;    // command buffer execution, from timestamps
+            float fenceWait = 0.0f;  // time spent blocked on the frame-in-flight fence
+            float sleepTime = 0.0f;  // time the pacer slept before polling input
+            float frameTime = 0.0f;  // start to start
+            float heapAllocations = 0.0f; // operator new calls between begin and end, only counted with --profile
+        };
+
+        // Sleeps before input is sampled instead of blocking on the fence after it,
+        // so the inputs that end up on screen are as fresh as the GPU allows.
+        class FramePacer
+        {
+        public:
+            FramePacer() = default;
+
+            void setEnabled(bool enabled) {mEnabled = enabled;}
+            void setTargetFrameRate(float framesPerSecond);
+
+            void waitBeforeInput();
+            void beginFrame();
+            void endFrame(float gpuTime, float fenceWait);
+
+            const FrameStats& getLastFrame() const {return mHistory[(mFrameIndex + HISTORY_SIZE - 1) % HISTORY_SIZE];}
+            FrameStats getAverage() const;
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr uint32_t HISTORY_SIZE = 240;
+            static constexpr float SAFETY_MARGIN = 1.0f; // ms left to the fence so a misprediction never misses a vblank
+            static constexpr float SMOOTHING = 0.1f;
+
+            void sleepFor(float milliseconds);
+            void logSummary();
+
+            util::Logger mLogger = util::Logger("Frame Pacer Logger");
+
+            bool mEnabled = true;
+            float mTargetFrameTime = 0.0f;
+            float mPredictedWait = 0.0f;
+
+            Clock::time_point mPreviousStart{};
+            Clock::time_point mFrameStart{};
+            uint64_t mFrameStartAllocations = 0;
+            Clock::time_point mLastSummary{};
+            float mPendingSleep = 0.0f;
+            float mPacingSleep = 0.0f;
+
+            std::array<FrameStats, HISTORY_SIZE> mHistory{};
+            uint32_t mFrameIndex = 0;
+            uint32_t mRecordedFrames = 0;
+        };
+    }
+}
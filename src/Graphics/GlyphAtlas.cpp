@@ -0,0 +1,275 @@
+#include "GlyphAtlas.hpp"
+
+#include "Renderer.hpp"
+#include "../Utility/Profiler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+const char* ke::Graphics::Text::getFormatName(GlyphFormat format)
+{
+    switch(format)
+    {
+        case GlyphFormat::MSDF: return "MSDF";
+        case GlyphFormat::MTSDF: return "MTSDF";
+        case GlyphFormat::SDF: return "SDF";
+        default: return "Unknown";
+    }
+}
+
+void ke::Graphics::Text::SkylinePacker::reset(uint32_t width, uint32_t height)
+{
+    mWidth = width;
+    mHeight = height;
+    mNodes.assign(1, Node{0, 0, width});
+    mUsedArea = 0;
+}
+
+void ke::Graphics::Text::SkylinePacker::setNodes(std::vector<Node> nodes, uint64_t usedArea)
+{
+    mNodes = std::move(nodes);
+    mUsedArea = usedArea;
+}
+
+bool ke::Graphics::Text::SkylinePacker::fit(size_t index, uint32_t width, uint32_t height, uint32_t& y) const
+{
+    if(mNodes[index].x + width > mWidth) return false;
+
+    // The rectangle rests on the highest segment it spans.
+    y = 0;
+    int64_t remaining = width;
+    for(size_t i = index; remaining > 0; i++)
+    {
+        if(i >= mNodes.size()) return false;
+
+        y = std::max(y, mNodes[i].y);
+        if(y + height > mHeight) return false;
+
+        remaining -= mNodes[i].width;
+    }
+
+    return true;
+}
+
+bool ke::Graphics::Text::SkylinePacker::pack(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y)
+{
+    size_t best = SIZE_MAX;
+    uint32_t bestTop = UINT32_MAX, bestWidth = UINT32_MAX, bestY = 0;
+
+    for(size_t i = 0; i < mNodes.size(); i++)
+    {
+        uint32_t nodeY;
+        if(!fit(i, width, height, nodeY)) continue;
+
+        uint32_t top = nodeY + height;
+        if(top < bestTop || (top == bestTop && mNodes[i].width < bestWidth))
+        {
+            best = i;
+            bestTop = top;
+            bestWidth = mNodes[i].width;
+            bestY = nodeY;
+        }
+    }
+
+    if(best == SIZE_MAX) return false;
+
+    x = mNodes[best].x;
+    y = bestY;
+    mNodes.insert(mNodes.begin() + best, Node{x, y + height, width});
+
+    // Cut the segments the new one now covers.
+    for(size_t i = best + 1; i < mNodes.size();)
+    {
+        uint32_t previousEnd = mNodes[i - 1].x + mNodes[i - 1].width;
+        if(mNodes[i].x >= previousEnd) break;
+
+        uint32_t overlap = previousEnd - mNodes[i].x;
+        if(mNodes[i].width <= overlap)
+        {
+            mNodes.erase(mNodes.begin() + i);
+            continue;
+        }
+
+        mNodes[i].x += overlap;
+        mNodes[i].width -= overlap;
+        break;
+    }
+
+    for(size_t i = 0; i + 1 < mNodes.size();)
+    {
+        if(mNodes[i].y == mNodes[i + 1].y)
+        {
+            mNodes[i].width += mNodes[i + 1].width;
+            mNodes.erase(mNodes.begin() + i + 1);
+        }
+        else i++;
+    }
+
+    mUsedArea += static_cast<uint64_t>(width) * height;
+    return true;
+}
+
+ke::Graphics::Text::GlyphAtlas::Page& ke::Graphics::Text::GlyphAtlas::addPage()
+{
+    Page& page = *mPages.emplace_back(std::make_unique<Page>());
+    page.packer.reset(PAGE_SIZE, page.height);
+    page.lastUsed = mFrame;
+    return page;
+}
+
+bool ke::Graphics::Text::GlyphAtlas::packGrowing(Page& page, uint32_t width, uint32_t height, AtlasRegion& region)
+{
+    while(!page.packer.pack(width, height, region.x, region.y))
+    {
+        if(page.height >= PAGE_SIZE) return false;
+
+        page.height *= 2;
+        page.packer.setHeight(page.height);
+    }
+
+    return true;
+}
+
+bool ke::Graphics::Text::GlyphAtlas::allocate(uint32_t width, uint32_t height, AtlasRegion& region, int32_t& evictedPage)
+{
+    evictedPage = -1;
+    region.width = width;
+    region.height = height;
+
+    // Free space in the pages as they are first, then taller pages, then more of them.
+    for(uint16_t i = 0; i < mPages.size(); i++)
+        if(mPages[i]->packer.pack(width, height, region.x, region.y))
+        {
+            region.page = i;
+            return true;
+        }
+
+    for(uint16_t i = 0; i < mPages.size(); i++)
+        if(packGrowing(*mPages[i], width, height, region))
+        {
+            region.page = i;
+            return true;
+        }
+
+    if(mPages.size() < MAX_PAGES)
+    {
+        region.page = static_cast<uint16_t>(mPages.size());
+        return packGrowing(addPage(), width, height, region);
+    }
+
+    // Never a page drawn in a frame the GPU may still be reading. Glyphs are packed before this frame's draws
+    // touch anything, so a page last used one frame ago is most likely about to be drawn again as well.
+    Page* victim = nullptr;
+    for(uint16_t i = 0; i < mPages.size(); i++)
+        if(mPages[i]->lastUsed + Renderer::MAXFRAMESINFLIGHT < mFrame && (!victim || mPages[i]->lastUsed < victim->lastUsed))
+        {
+            victim = mPages[i].get();
+            region.page = i;
+        }
+
+    if(!victim) return false;
+
+    // Keeps its height, the GPU image is already that size.
+    victim->packer.reset(PAGE_SIZE, victim->height);
+    victim->pending.clear();
+    victim->lastUsed = mFrame;
+    victim->generation++;
+    evictedPage = region.page;
+
+    return victim->packer.pack(width, height, region.x, region.y);
+}
+
+void ke::Graphics::Text::GlyphAtlas::write(const AtlasRegion& region, const uint8_t* pixels)
+{
+    Page& page = *mPages[region.page];
+    size_t texelBytes = getBytesPerTexel(mFormat);
+    size_t rowBytes = region.width * texelBytes;
+
+    if(page.resident)
+    {
+        page.pending.push_back(AtlasUpload{region.x, region.y, region.width, region.height, std::vector<uint8_t>(pixels, pixels + rowBytes * region.height)});
+        return;
+    }
+
+    // Rows are PAGE_SIZE wide whatever the height, so growing the page only appends rows.
+    if(page.pixels.empty() && page.borrowedPixels)
+    {
+        page.pixels.assign(page.borrowedPixels, page.borrowedPixels + static_cast<size_t>(PAGE_SIZE) * page.borrowedHeight * texelBytes);
+        page.borrowedPixels = nullptr;
+    }
+    page.pixels.resize(static_cast<size_t>(PAGE_SIZE) * page.height * texelBytes, 0);
+
+    for(uint32_t row = 0; row < region.height; row++)
+        memcpy(page.pixels.data() + ((static_cast<size_t>(region.y) + row) * PAGE_SIZE + region.x) * texelBytes, pixels + row * rowBytes, rowBytes);
+}
+
+void ke::Graphics::Text::GlyphAtlas::adoptPage(const uint8_t* pixels, uint32_t height, std::vector<SkylinePacker::Node> nodes, uint64_t usedArea)
+{
+    Page& page = addPage();
+    page.height = height;
+    page.packer.reset(PAGE_SIZE, height);
+    page.packer.setNodes(std::move(nodes), usedArea);
+    page.borrowedPixels = pixels;
+    page.borrowedHeight = height;
+}
+
+const uint8_t* ke::Graphics::Text::GlyphAtlas::getPixels(uint16_t page) const
+{
+    if(mPages[page]->resident) return nullptr;
+    return mPages[page]->pixels.empty() ? mPages[page]->borrowedPixels : mPages[page]->pixels.data();
+}
+
+ke::Graphics::Text::AtlasMemory ke::Graphics::Text::GlyphAtlas::getMemory() const
+{
+    AtlasMemory memory;
+    for(const auto& page : mPages)
+    {
+        memory.gpuBytes += static_cast<uint64_t>(PAGE_SIZE) * page->imageHeight * getBytesPerTexel(mFormat);
+        memory.cpuBytes += page->pixels.capacity();
+        for(const AtlasUpload& upload : page->pending)
+            memory.cpuBytes += upload.pixels.capacity();
+
+        memory.usedTexels += page->packer.getUsedArea();
+        memory.totalTexels += static_cast<uint64_t>(PAGE_SIZE) * page->height;
+    }
+
+    return memory;
+}
+
+void ke::Graphics::Text::GlyphAtlas::flush()
+{
+    KE_PROFILE_FUNCTION();
+    Renderer& rend = Renderer::getInstance();
+    VkFormat format = getTexelFormat(mFormat);
+
+    for(auto& page : mPages)
+    {
+        if(!page->resident)
+        {
+            const uint8_t* pixels = page->pixels.empty() ? page->borrowedPixels : page->pixels.data();
+
+            page->image.setDevice(rend.getDevice());
+            rend.createFontImage(pixels, PAGE_SIZE, page->height, format, page->image.image, page->image.imageMemory);
+            rend.createFontImageView(page->image, format);
+            page->descriptorIndex = rend.addFontToDescriptor(page->image);
+            page->imageHeight = page->height;
+            page->resident = true;
+
+            std::vector<uint8_t>().swap(page->pixels);
+            page->borrowedPixels = nullptr;
+            continue;
+        }
+
+        if(page->height > page->imageHeight)
+        {
+            rend.growFontImage(page->image, format, PAGE_SIZE, page->imageHeight, page->height, page->descriptorIndex);
+            page->imageHeight = page->height;
+        }
+
+        if(!page->pending.empty())
+        {
+            rend.updateFontImage(page->image.image, format, page->pending);
+            page->pending.clear();
+        }
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../Utility/RenderUtil.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        namespace Text
+        {
+            enum class GlyphFormat : uint8_t
+            {
+                MSDF,   // three distance channels, keeps corners sharp
+                MTSDF,  // MSDF plus the true distance in alpha, for outlines and glow
+                SDF     // one channel at a quarter of the memory, rounds corners off at large sizes
+            };
+
+            inline uint32_t getBytesPerTexel(GlyphFormat format) {return format == GlyphFormat::SDF ? 1 : 4;}
+            inline VkFormat getTexelFormat(GlyphFormat format) {return format == GlyphFormat::SDF ? VK_FORMAT_R8_UNORM : VK_FORMAT_B8G8R8A8_UNORM;}
+            const char* getFormatName(GlyphFormat format);
+
+            struct AtlasRegion
+            {
+                uint16_t page;
+                uint32_t x, y;
+                uint32_t width, height;
+            };
+
+            // Texels for one sub-rectangle of a page that is already on the GPU.
+            struct AtlasUpload
+            {
+                uint32_t x, y;
+                uint32_t width, height;
+                std::vector<uint8_t> pixels;
+            };
+
+            // Bottom-left skyline: the free space is the area above a list of horizontal segments, and every
+            // rectangle goes where its top edge ends up lowest.
+            class SkylinePacker
+            {
+            public:
+                struct Node
+                {
+                    uint32_t x, y, width;
+                };
+
+                void reset(uint32_t width, uint32_t height);
+                // Raising the height keeps everything packed so far where it is.
+                void setHeight(uint32_t height) {mHeight = height;}
+                bool pack(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+
+                const std::vector<Node>& getNodes() const {return mNodes;}
+                void setNodes(std::vector<Node> nodes, uint64_t usedArea);
+                uint64_t getUsedArea() const {return mUsedArea;}
+            private:
+                bool fit(size_t index, uint32_t width, uint32_t height, uint32_t& y) const;
+
+                uint32_t mWidth = 0;
+                uint32_t mHeight = 0;
+                std::vector<Node> mNodes;
+                uint64_t mUsedArea = 0;
+            };
+
+            struct AtlasMemory
+            {
+                uint64_t gpuBytes = 0;
+                uint64_t cpuBytes = 0;      // pages not uploaded yet and pending regions
+                uint64_t usedTexels = 0;
+                uint64_t totalTexels = 0;
+            };
+
+            // Pages of glyph texels. A page is composed on the CPU until its first flush, after that only the
+            // regions written since the last flush go up. Pages start short and double in height as glyphs need
+            // room, so a font that only uses a few glyphs only pays for those rows. When every page is full at
+            // PAGE_SIZE the least recently drawn one is cleared and reused, its owner drops the glyphs that lived there.
+            // Pages drawn within the last MAXFRAMESINFLIGHT frames are never picked.
+            class GlyphAtlas
+            {
+            public:
+                static const uint32_t PAGE_SIZE = 2048;
+                static const uint32_t MIN_PAGE_HEIGHT = 64;
+                static const uint32_t MAX_PAGES = 4;
+
+                explicit GlyphAtlas(GlyphFormat format = GlyphFormat::MSDF) : mFormat(format) {}
+                GlyphAtlas(const GlyphAtlas&) = delete;
+                GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+                // evictedPage is set to the page that was cleared to make room, or -1.
+                bool allocate(uint32_t width, uint32_t height, AtlasRegion& region, int32_t& evictedPage);
+                // pixels are width * height tightly packed texels of the atlas format
+                void write(const AtlasRegion& region, const uint8_t* pixels);
+                // Starts a page from finished texels, which are only borrowed until the next flush.
+                void adoptPage(const uint8_t* pixels, uint32_t height, std::vector<SkylinePacker::Node> nodes, uint64_t usedArea);
+                void flush();
+
+                void setFrame(uint64_t frame) {mFrame = frame;}
+                void touch(uint16_t page) {mPages[page]->lastUsed = mFrame;}
+
+                GlyphFormat getFormat() const {return mFormat;}
+                uint32_t getPageCount() const {return static_cast<uint32_t>(mPages.size());}
+                uint32_t getPageHeight(uint16_t page) const {return mPages[page]->height;}
+                AtlasMemory getMemory() const;
+                uint32_t getDescriptorIndex(uint16_t page) const {return mPages[page]->descriptorIndex;}
+                // Bumped when a page is evicted, so anything holding its UVs knows to look them up again.
+                uint32_t getGeneration(uint16_t page) const {return mPages[page]->generation;}
+                const SkylinePacker& getPacker(uint16_t page) const {return mPages[page]->packer;}
+                // CPU copy of a page that hasn't been flushed yet, nullptr once it lives on the GPU only.
+                const uint8_t* getPixels(uint16_t page) const;
+            private:
+                struct Page
+                {
+                    SkylinePacker packer;
+                    uint32_t height = MIN_PAGE_HEIGHT;
+                    util::Image image{};
+                    uint32_t imageHeight = 0;   // height of the GPU copy, lags behind until the next flush
+                    uint32_t descriptorIndex = 0;
+                    bool resident = false;
+                    std::vector<uint8_t> pixels;
+                    const uint8_t* borrowedPixels = nullptr;
+                    uint32_t borrowedHeight = 0;
+                    std::vector<AtlasUpload> pending;
+                    uint64_t lastUsed = 0;
+                    uint32_t generation = 0;
+                };
+
+                Page& addPage();
+                bool packGrowing(Page& page, uint32_t width, uint32_t height, AtlasRegion& region);
+
+                GlyphFormat mFormat;
+                std::vector<std::unique_ptr<Page>> mPages;
+                uint64_t mFrame = 0;
+            };
+        }
+    }
+}
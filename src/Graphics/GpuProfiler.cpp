@@ -0,0 +1,293 @@
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+
+void ke::Graphics::GpuProfiler::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t frameSlots, bool pipelineStatistics)
+{
+    mDevice = device;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    uint32_t validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+    if(validBits == 0)
+    {
+        mLogger.warn("Graphics queue doesn't support timestamps, GPU profiling is unavailable.");
+        return;
+    }
+
+    mTimestampPeriod = properties.limits.timestampPeriod;
+    mTimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    mSlots.assign(frameSlots, FrameSlot{});
+
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = frameSlots * MAX_ZONES * 2;
+
+    if(vkCreateQueryPool(mDevice, &poolInfo, nullptr, &mTimestampPool) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to create timestamp query pool!");
+        mTimestampPool = VK_NULL_HANDLE;
+        return;
+    }
+
+    poolInfo.queryCount = 2;
+    if(vkCreateQueryPool(mDevice, &poolInfo, nullptr, &mUploadPool) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to create upload query pool!");
+        mUploadPool = VK_NULL_HANDLE;
+    }
+
+    if(pipelineStatistics)
+    {
+        poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        poolInfo.queryCount = frameSlots * MAX_ZONES;
+        poolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+                                      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                                      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                                      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        if(vkCreateQueryPool(mDevice, &poolInfo, nullptr, &mStatisticsPool) != VK_SUCCESS)
+        {
+            mLogger.warn("Failed to create pipeline statistics query pool, continuing with timestamps only.");
+            mStatisticsPool = VK_NULL_HANDLE;
+        }
+    }
+
+    mLogger.info("Created GPU profiler ({} zones per frame, pipeline statistics {}).", MAX_ZONES, mStatisticsPool != VK_NULL_HANDLE ? "on" : "off");
+}
+
+void ke::Graphics::GpuProfiler::destroy()
+{
+    if(mTimestampPool != VK_NULL_HANDLE) vkDestroyQueryPool(mDevice, mTimestampPool, nullptr);
+    if(mStatisticsPool != VK_NULL_HANDLE) vkDestroyQueryPool(mDevice, mStatisticsPool, nullptr);
+    if(mUploadPool != VK_NULL_HANDLE) vkDestroyQueryPool(mDevice, mUploadPool, nullptr);
+
+    mTimestampPool = VK_NULL_HANDLE;
+    mStatisticsPool = VK_NULL_HANDLE;
+    mUploadPool = VK_NULL_HANDLE;
+}
+
+void ke::Graphics::GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t slot)
+{
+    if(!isAvailable()) return;
+
+    mCurrentSlot = slot;
+    mSlots[slot].zones.clear();
+    mSlots[slot].pending = false;
+
+    vkCmdResetQueryPool(commandBuffer, mTimestampPool, slot * MAX_ZONES * 2, MAX_ZONES * 2);
+    if(mStatisticsPool != VK_NULL_HANDLE)
+        vkCmdResetQueryPool(commandBuffer, mStatisticsPool, slot * MAX_ZONES, MAX_ZONES);
+
+    mRecording = true;
+    mStatisticsActive = false;
+    mFrameZone = INVALID_ZONE;
+    mFrameZone = beginZone(commandBuffer, FRAME_ZONE);
+}
+
+void ke::Graphics::GpuProfiler::endFrame(VkCommandBuffer commandBuffer)
+{
+    if(!mRecording) return;
+
+    endZone(commandBuffer, mFrameZone);
+    mRecording = false;
+}
+
+void ke::Graphics::GpuProfiler::markSubmitted()
+{
+    if(!isAvailable()) return;
+
+    mSlots[mCurrentSlot].pending = true;
+}
+
+void ke::Graphics::GpuProfiler::collect(uint32_t slot)
+{
+    if(!isAvailable() || !mSlots[slot].pending) return;
+
+    FrameSlot& frame = mSlots[slot];
+    frame.pending = false;
+
+    uint32_t zoneCount = static_cast<uint32_t>(frame.zones.size());
+    if(zoneCount == 0) return;
+
+    // No WAIT flag: the fence for this slot has already signaled, if anything is still missing we drop the frame.
+    std::vector<uint64_t> timestamps(zoneCount * 2);
+    VkResult result = vkGetQueryPoolResults(mDevice, mTimestampPool, slot * MAX_ZONES * 2, zoneCount * 2,
+        timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if(result != VK_SUCCESS) return;
+
+    for(uint32_t zone = 0; zone < zoneCount; zone++)
+    {
+        PipelineStatistics statistics{};
+        bool hasStatistics = false;
+
+        if(frame.zones[zone].statistics)
+        {
+            uint64_t values[STATISTIC_COUNT];
+            if(vkGetQueryPoolResults(mDevice, mStatisticsPool, slot * MAX_ZONES + zone, 1, sizeof(values), values, sizeof(values), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+            {
+                // Results come back in bit order of the enabled statistics.
+                statistics.inputVertices = values[0];
+                statistics.vertexInvocations = values[1];
+                statistics.clippingPrimitives = values[2];
+                statistics.fragmentInvocations = values[3];
+                hasStatistics = true;
+            }
+        }
+
+        addSample(frame.zones[zone].name, toMilliseconds(timestamps[zone * 2], timestamps[zone * 2 + 1]), hasStatistics ? &statistics : nullptr);
+    }
+}
+
+uint32_t ke::Graphics::GpuProfiler::beginZone(VkCommandBuffer commandBuffer, const std::string& name)
+{
+    if(!mRecording) return INVALID_ZONE;
+
+    FrameSlot& frame = mSlots[mCurrentSlot];
+    if(frame.zones.size() >= MAX_ZONES) return INVALID_ZONE;
+
+    uint32_t zone = static_cast<uint32_t>(frame.zones.size());
+
+    // Only one statistics query can be active at a time, nested zones and the frame zone get timestamps only.
+    bool statistics = mStatisticsPool != VK_NULL_HANDLE && !mStatisticsActive && mFrameZone != INVALID_ZONE;
+    frame.zones.push_back(ZoneRecord{name, statistics});
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mTimestampPool, (mCurrentSlot * MAX_ZONES + zone) * 2);
+    if(statistics)
+    {
+        vkCmdBeginQuery(commandBuffer, mStatisticsPool, mCurrentSlot * MAX_ZONES + zone, 0);
+        mStatisticsActive = true;
+    }
+
+    return zone;
+}
+
+void ke::Graphics::GpuProfiler::endZone(VkCommandBuffer commandBuffer, uint32_t zone)
+{
+    if(!mRecording || zone == INVALID_ZONE) return;
+
+    const ZoneRecord& record = mSlots[mCurrentSlot].zones[zone];
+    if(record.statistics)
+    {
+        vkCmdEndQuery(commandBuffer, mStatisticsPool, mCurrentSlot * MAX_ZONES + zone);
+        mStatisticsActive = false;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mTimestampPool, (mCurrentSlot * MAX_ZONES + zone) * 2 + 1);
+}
+
+void ke::Graphics::GpuProfiler::beginUpload(VkCommandBuffer commandBuffer)
+{
+    if(mUploadPool == VK_NULL_HANDLE || mUploadActive) return;
+
+    vkCmdResetQueryPool(commandBuffer, mUploadPool, 0, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mUploadPool, 0);
+    mUploadActive = true;
+}
+
+void ke::Graphics::GpuProfiler::endUpload(VkCommandBuffer commandBuffer)
+{
+    if(!mUploadActive) return;
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mUploadPool, 1);
+}
+
+void ke::Graphics::GpuProfiler::resolveUpload()
+{
+    if(!mUploadActive) return;
+    mUploadActive = false;
+
+    uint64_t timestamps[2];
+    if(vkGetQueryPoolResults(mDevice, mUploadPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+        addSample(UPLOAD_ZONE, toMilliseconds(timestamps[0], timestamps[1]), nullptr);
+}
+
+float ke::Graphics::GpuProfiler::getLast(const std::string& name) const
+{
+    auto it = mHistory.find(name);
+    if(it == mHistory.end() || it->second.count == 0) return 0.0f;
+
+    return it->second.samples[(it->second.next + HISTORY_SIZE - 1) % HISTORY_SIZE];
+}
+
+float ke::Graphics::GpuProfiler::getAverage(const std::string& name) const
+{
+    auto it = mHistory.find(name);
+    if(it == mHistory.end() || it->second.count == 0) return 0.0f;
+
+    float sum = 0.0f;
+    for(uint32_t i = 0; i < it->second.count; i++)
+        sum += it->second.samples[i];
+
+    return sum / static_cast<float>(it->second.count);
+}
+
+std::vector<ke::Graphics::GpuZoneStats> ke::Graphics::GpuProfiler::getZoneStats() const
+{
+    std::vector<GpuZoneStats> result;
+    result.reserve(mZoneOrder.size());
+
+    for(const std::string& name : mZoneOrder)
+    {
+        const ZoneHistory& history = mHistory.at(name);
+        if(history.count == 0) continue;
+
+        std::vector<float> sorted(history.samples.begin(), history.samples.begin() + history.count);
+        std::sort(sorted.begin(), sorted.end());
+
+        auto percentile = [&sorted](float p)
+        {
+            size_t rank = static_cast<size_t>(p * static_cast<float>(sorted.size() - 1) + 0.5f);
+            return sorted[std::min(rank, sorted.size() - 1)];
+        };
+
+        GpuZoneStats stats;
+        stats.name = name;
+        stats.last = getLast(name);
+        stats.average = getAverage(name);
+        stats.p50 = percentile(0.50f);
+        stats.p95 = percentile(0.95f);
+        stats.p99 = percentile(0.99f);
+        stats.samples = history.count;
+        stats.hasStatistics = history.hasStatistics;
+        stats.statistics = history.statistics;
+
+        result.push_back(stats);
+    }
+
+    return result;
+}
+
+void ke::Graphics::GpuProfiler::addSample(const std::string& name, float milliseconds, const PipelineStatistics* statistics)
+{
+    auto it = mHistory.find(name);
+    if(it == mHistory.end())
+    {
+        it = mHistory.emplace(name, ZoneHistory{}).first;
+        mZoneOrder.push_back(name);
+    }
+
+    ZoneHistory& history = it->second;
+    history.samples[history.next] = milliseconds;
+    history.next = (history.next + 1) % HISTORY_SIZE;
+    history.count = std::min(history.count + 1, HISTORY_SIZE);
+
+    if(statistics)
+    {
+        history.statistics = *statistics;
+        history.hasStatistics = true;
+    }
+}
+
+float ke::Graphics::GpuProfiler::toMilliseconds(uint64_t begin, uint64_t end) const
+{
+    uint64_t ticks = ((end & mTimestampMask) - (begin & mTimestampMask)) & mTimestampMask;
+    return static_cast<float>(ticks) * mTimestampPeriod / 1000000.0f;
+}
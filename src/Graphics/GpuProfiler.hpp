@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Utility/Logger.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        struct PipelineStatistics
+        {
+            uint64_t inputVertices = 0;
+            uint64_t vertexInvocations = 0;
+            uint64_t clippingPrimitives = 0;
+            uint64_t fragmentInvocations = 0;
+        };
+
+        struct GpuZoneStats
+        {
+            std::string name;
+            float last = 0.0f;
+            float average = 0.0f;
+            float p50 = 0.0f;
+            float p95 = 0.0f;
+            float p99 = 0.0f;
+            uint32_t samples = 0;
+            bool hasStatistics = false;
+            PipelineStatistics statistics{};
+        };
+
+        // Timestamp zones recorded into the frame's command buffer. Each frame in flight owns a slice of
+        // the query pools and is read back once its fence has signaled, so results lag by the frames in flight
+        // and reading them never stalls the CPU.
+        class GpuProfiler
+        {
+        public:
+            static constexpr uint32_t MAX_ZONES = 32;
+            static constexpr const char* FRAME_ZONE = "Frame";
+            static constexpr const char* UPLOAD_ZONE = "Upload";
+
+            GpuProfiler() = default;
+
+            void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, uint32_t frameSlots, bool pipelineStatistics);
+            void destroy();
+
+            bool isAvailable() const {return mTimestampPool != VK_NULL_HANDLE;}
+            bool hasPipelineStatistics() const {return mStatisticsPool != VK_NULL_HANDLE;}
+
+            void beginFrame(VkCommandBuffer commandBuffer, uint32_t slot);
+            void endFrame(VkCommandBuffer commandBuffer);
+            void markSubmitted();
+            void collect(uint32_t slot);
+
+            uint32_t beginZone(VkCommandBuffer commandBuffer, const std::string& name);
+            void endZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+            // Uploads go through their own command buffer and wait for the queue, so they resolve immediately.
+            void beginUpload(VkCommandBuffer commandBuffer);
+            void endUpload(VkCommandBuffer commandBuffer);
+            void resolveUpload();
+
+            float getLast(const std::string& name) const;
+            float getAverage(const std::string& name) const;
+            std::vector<GpuZoneStats> getZoneStats() const;
+        private:
+            static constexpr uint32_t HISTORY_SIZE = 256;
+            static constexpr uint32_t STATISTIC_COUNT = 4;
+            static constexpr uint32_t INVALID_ZONE = UINT32_MAX;
+
+            struct ZoneRecord
+            {
+                std::string name;
+                bool statistics;
+            };
+
+            struct FrameSlot
+            {
+                std::vector<ZoneRecord> zones;
+                bool pending = false;
+            };
+
+            struct ZoneHistory
+            {
+                std::array<float, HISTORY_SIZE> samples{};
+                uint32_t next = 0;
+                uint32_t count = 0;
+                bool hasStatistics = false;
+                PipelineStatistics statistics{};
+            };
+
+            void addSample(const std::string& name, float milliseconds, const PipelineStatistics* statistics);
+            float toMilliseconds(uint64_t begin, uint64_t end) const;
+
+            util::Logger mLogger = util::Logger("GPU Profiler Logger");
+
+            VkDevice mDevice = VK_NULL_HANDLE;
+            VkQueryPool mTimestampPool = VK_NULL_HANDLE;
+            VkQueryPool mStatisticsPool = VK_NULL_HANDLE;
+            VkQueryPool mUploadPool = VK_NULL_HANDLE;
+
+            float mTimestampPeriod = 0.0f;
+            uint64_t mTimestampMask = ~0ull;
+
+            std::vector<FrameSlot> mSlots;
+            uint32_t mCurrentSlot = 0;
+            uint32_t mFrameZone = INVALID_ZONE;
+            bool mRecording = false;
+            bool mStatisticsActive = false;
+            bool mUploadActive = false;
+
+            std::unordered_map<std::string, ZoneHistory> mHistory;
+            std::vector<std::string> mZoneOrder;
+        };
+    }
+}
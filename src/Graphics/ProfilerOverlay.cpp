@@ -0,0 +1,82 @@
+#include "ProfilerOverlay.hpp"
+#include "../Utility/FrameAllocator.hpp"
+
+#include <algorithm>
+
+void ke::Graphics::ProfilerOverlay::setVisible(bool visible)
+{
+    mVisible = visible;
+    mLastRefresh = Clock::time_point{};
+
+    if(!mVisible) clear();
+}
+
+void ke::Graphics::ProfilerOverlay::update(const GpuProfiler& profiler, const FrameStats& frame, const DrawCounters& draws, glm::ivec2 screenSize)
+{
+    if(!mVisible) return;
+
+    Clock::time_point now = Clock::now();
+    if(mLastRefresh != Clock::time_point{} && now - mLastRefresh < REFRESH_INTERVAL) return;
+    double interval = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - mLastRefresh).count());
+    bool hasInterval = mLastRefresh != Clock::time_point{};
+    mLastRefresh = now;
+
+    std::vector<std::string> text;
+    text.push_back(fmt::format("Frame {:.2f} ms ({:.0f} fps)  CPU {:.2f}  GPU {:.2f}  wait {:.2f}  sleep {:.2f}",
+        frame.frameTime, frame.frameTime > 0.0f ? 1000.0f / frame.frameTime : 0.0f, frame.cpuTime, frame.gpuTime, frame.fenceWait, frame.sleepTime));
+
+    text.push_back(fmt::format("Draw calls {}  pipeline binds {}  buffer binds {}", draws.drawCalls, draws.pipelineBinds, draws.bufferBinds));
+
+    if(util::isCountingHeapAllocations())
+        text.push_back(fmt::format("Heap allocations {:.1f} per frame", frame.heapAllocations));
+
+    std::vector<util::WorkerStats> jobStats = util::JobSystem::getInstance().getStats();
+    if(hasInterval && jobStats.size() == mLastJobStats.size() && !jobStats.empty())
+    {
+        uint64_t jobs = 0;
+        std::string perWorker;
+        for(size_t i = 0; i < jobStats.size(); i++)
+        {
+            jobs += jobStats[i].jobs - mLastJobStats[i].jobs;
+            double busy = static_cast<double>(jobStats[i].busyNanoseconds - mLastJobStats[i].busyNanoseconds) / interval;
+            perWorker += fmt::format(" {}{} {:.0f}%", i == 0 ? "M" : "W", i, std::min(busy, 1.0) * 100.0);
+        }
+        text.push_back(fmt::format("Jobs {:.0f}/s {}", static_cast<double>(jobs) * 1e9 / interval, perWorker));
+    }
+    mLastJobStats = std::move(jobStats);
+
+    if(!profiler.isAvailable())
+        text.push_back("GPU timestamps unavailable");
+
+    for(const GpuZoneStats& zone : profiler.getZoneStats())
+    {
+        std::string line = fmt::format("{:<8} avg {:.3f}  p50 {:.3f}  p95 {:.3f}  p99 {:.3f} ms", zone.name, zone.average, zone.p50, zone.p95, zone.p99);
+        if(zone.hasStatistics)
+            line += fmt::format("  vs {}  fs {}  prims {}", zone.statistics.vertexInvocations, zone.statistics.fragmentInvocations, zone.statistics.clippingPrimitives);
+
+        text.push_back(line);
+    }
+
+    mLines.clear();
+    mLines.reserve(text.size());
+
+    int lineHeight = PIXEL_SIZE + PIXEL_SIZE / 4;
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        int y = screenSize.y - MARGIN - static_cast<int>(i + 1) * lineHeight;
+        mLines.emplace_back(text[i], "DejaVuSans", MARGIN, y, glm::vec4(1.0f, 1.0f, 0.0f, 1.0f), PIXEL_SIZE);
+    }
+}
+
+void ke::Graphics::ProfilerOverlay::draw() const
+{
+    if(!mVisible) return;
+
+    for(const Text::TextInstance& line : mLines)
+        line.Draw();
+}
+
+void ke::Graphics::ProfilerOverlay::clear()
+{
+    mLines.clear();
+}
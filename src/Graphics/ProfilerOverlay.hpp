@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "TextUtilities.hpp"
+#include "GpuProfiler.hpp"
+#include "FramePacer.hpp"
+#include "Renderer.hpp"
+#include "../Utility/JobSystem.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        // Top-left text readout of the frame pacer and GPU profiler. The text is rebuilt at a fixed interval
+        // rather than every frame since each rebuild lays out and rasterizes new glyph runs.
+        class ProfilerOverlay
+        {
+        public:
+            ProfilerOverlay() = default;
+
+            void setVisible(bool visible);
+            void toggle() {setVisible(!mVisible);}
+            bool isVisible() const {return mVisible;}
+
+            void update(const GpuProfiler& profiler, const FrameStats& frame, const DrawCounters& draws, glm::ivec2 screenSize);
+            void draw() const;
+            void clear();
+        private:
+            using Clock = std::chrono::steady_clock;
+
+            static constexpr int PIXEL_SIZE = 16;
+            static constexpr int MARGIN = 10;
+            static constexpr std::chrono::milliseconds REFRESH_INTERVAL{500};
+
+            std::vector<Text::TextInstance> mLines;
+            std::vector<util::WorkerStats> mLastJobStats;   // to show utilization over the refresh interval only
+            Clock::time_point mLastRefresh{};
+            bool mVisible = false;
+        };
+    }
+}
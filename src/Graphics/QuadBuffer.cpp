@@ -0,0 +1,178 @@
+#include "QuadBuffer.hpp"
+
+#include "Renderer.hpp"
+#include "../Utility/RenderUtil.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+ke::Graphics::QuadBuffer::QuadBuffer(QuadBuffer&& other) noexcept
+    : mVertices(std::move(other.mVertices)), mSlots(std::move(other.mSlots))
+{
+    other.mSlots.clear();
+}
+
+ke::Graphics::QuadBuffer& ke::Graphics::QuadBuffer::operator=(QuadBuffer&& other) noexcept
+{
+    if(this != &other)
+    {
+        destroy();
+        mVertices = std::move(other.mVertices);
+        mSlots = std::move(other.mSlots);
+        other.mSlots.clear();
+    }
+    return *this;
+}
+
+void ke::Graphics::QuadBuffer::resize(uint32_t quadCount)
+{
+    uint32_t previous = getQuadCount();
+    mVertices.resize(static_cast<size_t>(quadCount) * 4, Vertex{});
+    if(quadCount > previous) markDirty(previous, quadCount);
+}
+
+void ke::Graphics::QuadBuffer::setQuad(uint32_t quad, const Quad& vertices)
+{
+    if(quad >= getQuadCount()) resize(quad + 1);
+
+    std::copy(vertices.begin(), vertices.end(), mVertices.begin() + static_cast<size_t>(quad) * 4);
+    markDirty(quad, quad + 1);
+}
+
+void ke::Graphics::QuadBuffer::markDirty(uint32_t first, uint32_t end)
+{
+    for(Slot& slot : mSlots)
+    {
+        if(slot.dirtyFirst == slot.dirtyEnd)
+        {
+            slot.dirtyFirst = first;
+            slot.dirtyEnd = end;
+            continue;
+        }
+
+        slot.dirtyFirst = std::min(slot.dirtyFirst, first);
+        slot.dirtyEnd = std::max(slot.dirtyEnd, end);
+    }
+}
+
+void ke::Graphics::QuadBuffer::sync(uint32_t slot)
+{
+    if(slot >= mSlots.size()) mSlots.resize(slot + 1);
+
+    Slot& target = mSlots[slot];
+    uint32_t quadCount = getQuadCount();
+
+    if(quadCount > target.capacity)
+    {
+        // The fence covering this slot has signaled, so its old buffer can go right away.
+        release(target);
+        if(!allocate(target, std::max(quadCount, 16u))) return;
+        target.dirtyFirst = 0;
+        target.dirtyEnd = quadCount;
+    }
+
+    if(target.dirtyFirst == target.dirtyEnd) return;
+
+    uint32_t end = std::min(target.dirtyEnd, quadCount);
+    if(target.dirtyFirst < end)
+    {
+        VkDeviceSize indexBytes = static_cast<VkDeviceSize>(target.capacity) * 6 * sizeof(uint32_t);
+        uint8_t* vertices = static_cast<uint8_t*>(target.mapped) + indexBytes;
+        size_t firstVertex = static_cast<size_t>(target.dirtyFirst) * 4;
+
+        memcpy(vertices + firstVertex * sizeof(Vertex), mVertices.data() + firstVertex, (static_cast<size_t>(end) * 4 - firstVertex) * sizeof(Vertex));
+    }
+
+    target.dirtyFirst = target.dirtyEnd = 0;
+}
+
+bool ke::Graphics::QuadBuffer::bind(VkCommandBuffer commandBuffer, uint32_t slot) const
+{
+    if(slot >= mSlots.size() || mSlots[slot].buffer == VK_NULL_HANDLE) return false;
+
+    const Slot& target = mSlots[slot];
+    VkDeviceSize vertexOffset = static_cast<VkDeviceSize>(target.capacity) * 6 * sizeof(uint32_t);
+
+    vkCmdBindIndexBuffer(commandBuffer, target.buffer, 0, VK_INDEX_TYPE_UINT32);
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &target.buffer, &vertexOffset);
+    return true;
+}
+
+void ke::Graphics::QuadBuffer::drawRange(VkCommandBuffer commandBuffer, uint32_t firstQuad, uint32_t quadCount) const
+{
+    if(quadCount == 0) return;
+
+    vkCmdDrawIndexed(commandBuffer, quadCount * 6, 1, firstQuad * 6, 0, 0);
+}
+
+bool ke::Graphics::QuadBuffer::allocate(Slot& slot, uint32_t capacity)
+{
+    Renderer& rend = Renderer::getInstance();
+    VkDevice device = rend.getDevice();
+
+    // Indices first, they never change after this, then the vertices.
+    VkDeviceSize indexBytes = static_cast<VkDeviceSize>(capacity) * 6 * sizeof(uint32_t);
+    VkDeviceSize size = indexBytes + static_cast<VkDeviceSize>(capacity) * 4 * sizeof(Vertex);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(device, &bufferInfo, nullptr, &slot.buffer) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to create UI quad buffer!");
+        slot.buffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, slot.buffer, &requirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = util::findMemoryType(rend.getPhysicalDevice(), requirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    if(allocInfo.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device, &allocInfo, nullptr, &slot.memory) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to allocate UI quad memory!");
+        release(slot);
+        return false;
+    }
+
+    vkBindBufferMemory(device, slot.buffer, slot.memory, 0);
+    vkMapMemory(device, slot.memory, 0, size, 0, &slot.mapped);
+    slot.capacity = capacity;
+
+    uint32_t* indices = static_cast<uint32_t*>(slot.mapped);
+    for(uint32_t quad = 0; quad < capacity; quad++)
+        for(uint32_t corner : {0u, 1u, 2u, 0u, 2u, 3u})
+            *indices++ = quad * 4 + corner;
+
+    return true;
+}
+
+void ke::Graphics::QuadBuffer::release(Slot& slot)
+{
+    VkDevice device = Renderer::getInstance().getDevice();
+
+    if(slot.memory != VK_NULL_HANDLE)
+    {
+        vkUnmapMemory(device, slot.memory);
+        vkFreeMemory(device, slot.memory, nullptr);
+    }
+    if(slot.buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(device, slot.buffer, nullptr);
+
+    slot = Slot{};
+}
+
+void ke::Graphics::QuadBuffer::destroy()
+{
+    for(Slot& slot : mSlots)
+        release(slot);
+    mSlots.clear();
+}
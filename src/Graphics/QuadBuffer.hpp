@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <array>
+#include <vector>
+
+#include "../Utility/Logger.hpp"
+#include "../Utility/structs.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        // UI quads in a host-visible buffer per frame in flight, mapped for as long as they live. A quad that changes
+        // is written to the CPU copy once and reaches each frame slot the next time that slot is drawn, so a UI that
+        // isn't changing costs nothing per frame beyond its draws. Ranges of it draw separately after a single bind.
+        class QuadBuffer
+        {
+        public:
+            using Vertex = util::str::Vertex2P3C2T;
+            using Quad = std::array<Vertex, 4>;
+
+            QuadBuffer() = default;
+            ~QuadBuffer() {destroy();}
+
+            QuadBuffer(const QuadBuffer&) = delete;
+            QuadBuffer& operator=(const QuadBuffer&) = delete;
+            QuadBuffer(QuadBuffer&& other) noexcept;
+            QuadBuffer& operator=(QuadBuffer&& other) noexcept;
+
+            // Quads already set keep their contents.
+            void resize(uint32_t quadCount);
+            void setQuad(uint32_t quad, const Quad& vertices);
+            uint32_t getQuadCount() const {return static_cast<uint32_t>(mVertices.size() / 4);}
+
+            // Copies the quads changed since the slot was last synced. The slot's fence must have signaled.
+            void sync(uint32_t slot);
+            // Binds the slot's vertices and indices once, for any number of drawRange calls after it.
+            bool bind(VkCommandBuffer commandBuffer, uint32_t slot) const;
+            void drawRange(VkCommandBuffer commandBuffer, uint32_t firstQuad, uint32_t quadCount) const;
+
+            // The GPU must be done with every slot, callers wait for the device before tearing UI down.
+            void destroy();
+        private:
+            struct Slot
+            {
+                VkBuffer buffer = VK_NULL_HANDLE;
+                VkDeviceMemory memory = VK_NULL_HANDLE;
+                void* mapped = nullptr;
+                uint32_t capacity = 0;      // in quads
+
+                // Quads [dirtyFirst, dirtyEnd) differ from the CPU copy.
+                uint32_t dirtyFirst = 0;
+                uint32_t dirtyEnd = 0;
+            };
+
+            bool allocate(Slot& slot, uint32_t capacity);
+            void release(Slot& slot);
+            void markDirty(uint32_t first, uint32_t end);
+
+            util::Logger mLogger = util::Logger("Quad Buffer Logger");
+
+            std::vector<Vertex> mVertices;
+            std::vector<Slot> mSlots;
+        };
+    }
+}
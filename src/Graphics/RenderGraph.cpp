@@ -0,0 +1,464 @@
+#include "RenderGraph.hpp"
+#include "../Utility/RenderUtil.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    struct AccessInfo
+    {
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        bool attachment;
+    };
+
+    AccessInfo getAccessInfo(ke::Graphics::ResourceAccess access, bool write, ke::Graphics::PassType type)
+    {
+        using ke::Graphics::ResourceAccess;
+
+        VkPipelineStageFlags shaderStage = type == ke::Graphics::PassType::Compute ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+        switch(access)
+        {
+        case ResourceAccess::ColorAttachment:
+            return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | (write ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0u), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true};
+        case ResourceAccess::DepthAttachment:
+            return {VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | (write ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : 0u), VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, true};
+        case ResourceAccess::SampledFragment:
+            return {VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+        case ResourceAccess::SampledCompute:
+            return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false};
+        case ResourceAccess::StorageRead:
+            return {shaderStage, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+        case ResourceAccess::StorageWrite:
+            return {shaderStage, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, false};
+        case ResourceAccess::TransferSrc:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false};
+        case ResourceAccess::TransferDst:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, false};
+        case ResourceAccess::Present:
+        default:
+            return {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false};
+        }
+    }
+}
+
+void ke::Graphics::PassBuilder::read(ResourceHandle resource, ResourceAccess access, VkImageLayout layoutAfter)
+{
+    mGraph.mPasses[mPass].uses.push_back({resource, access, layoutAfter, false});
+}
+
+void ke::Graphics::PassBuilder::write(ResourceHandle resource, ResourceAccess access, VkImageLayout layoutAfter)
+{
+    mGraph.mPasses[mPass].uses.push_back({resource, access, layoutAfter, true});
+}
+
+void ke::Graphics::PassBuilder::sideEffect()
+{
+    mGraph.mPasses[mPass].sideEffect = true;
+}
+
+void ke::Graphics::RenderGraph::init(VkDevice device, VkPhysicalDevice physicalDevice)
+{
+    mDevice = device;
+    mPhysicalDevice = physicalDevice;
+}
+
+void ke::Graphics::RenderGraph::destroy()
+{
+    releaseTransients();
+
+    mPasses.clear();
+    mResources.clear();
+    mSchedule.clear();
+    mCompiled = false;
+}
+
+ke::Graphics::ResourceHandle ke::Graphics::RenderGraph::importImage(const std::string &name, VkImageAspectFlags aspect, VkImageLayout initialLayout, bool output)
+{
+    Resource resource{};
+    resource.name = name;
+    resource.imported = true;
+    resource.output = output;
+    resource.aspect = aspect;
+    resource.initialLayout = initialLayout;
+
+    mResources.push_back(resource);
+    mCompiled = false;
+
+    return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+void ke::Graphics::RenderGraph::setImportedImage(ResourceHandle resource, VkImage image)
+{
+    mResources[resource].image = image;
+}
+
+ke::Graphics::ResourceHandle ke::Graphics::RenderGraph::createTransientImage(const std::string &name, const TransientImageDesc &desc)
+{
+    Resource resource{};
+    resource.name = name;
+    resource.imported = false;
+    resource.output = false;
+    resource.aspect = desc.aspect;
+    resource.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.desc = desc;
+
+    mResources.push_back(resource);
+    mCompiled = false;
+
+    return static_cast<ResourceHandle>(mResources.size() - 1);
+}
+
+VkImage ke::Graphics::RenderGraph::getImage(ResourceHandle resource) const
+{
+    return mResources[resource].image;
+}
+
+VkImageView ke::Graphics::RenderGraph::getImageView(ResourceHandle resource) const
+{
+    return mResources[resource].view;
+}
+
+void ke::Graphics::RenderGraph::addPass(const std::string &name, PassType type, const std::function<void(PassBuilder&)> &setup, std::function<void(VkCommandBuffer)> execute)
+{
+    Pass pass{};
+    pass.name = name;
+    pass.type = type;
+    pass.execute = std::move(execute);
+    mPasses.push_back(std::move(pass));
+
+    PassBuilder builder(*this, static_cast<uint32_t>(mPasses.size() - 1));
+    setup(builder);
+
+    mCompiled = false;
+}
+
+void ke::Graphics::RenderGraph::compile()
+{
+    releaseTransients();
+
+    cullPasses();
+    computeLifetimes();
+    allocateTransients();
+    computeBarriers();
+
+    size_t culled = std::count_if(mPasses.begin(), mPasses.end(), [](const Pass& pass) { return pass.culled; });
+    size_t barriers = 0;
+    for(const Step& step : mSchedule) barriers += step.barriers.size();
+    size_t transients = std::count_if(mResources.begin(), mResources.end(), [](const Resource& resource) { return !resource.imported && resource.image != VK_NULL_HANDLE; });
+
+    mLogger.info("Compiled render graph: {} passes ({} culled), {} barriers, {} transient images in {} allocations.",
+        mPasses.size(), culled, barriers, transients, mAliasGroups.size());
+
+    mCompiled = true;
+}
+
+void ke::Graphics::RenderGraph::execute(VkCommandBuffer commandBuffer)
+{
+    if(!mCompiled) compile();
+
+    for(const Step& step : mSchedule)
+    {
+        if(!step.barriers.empty())
+        {
+            std::vector<VkImageMemoryBarrier> imageBarriers;
+            VkPipelineStageFlags srcStage = 0;
+            VkPipelineStageFlags dstStage = 0;
+
+            for(const Barrier& barrier : step.barriers)
+            {
+                const Resource& resource = mResources[barrier.resource];
+                if(resource.image == VK_NULL_HANDLE) continue;
+
+                VkImageMemoryBarrier imageBarrier{};
+                imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                imageBarrier.srcAccessMask = barrier.srcAccess;
+                imageBarrier.dstAccessMask = barrier.dstAccess;
+                imageBarrier.oldLayout = barrier.oldLayout;
+                imageBarrier.newLayout = barrier.newLayout;
+                imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                imageBarrier.image = resource.image;
+                imageBarrier.subresourceRange.aspectMask = resource.aspect;
+                imageBarrier.subresourceRange.baseMipLevel = 0;
+                imageBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+                imageBarrier.subresourceRange.baseArrayLayer = 0;
+                imageBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+                imageBarriers.push_back(imageBarrier);
+                srcStage |= barrier.srcStage;
+                dstStage |= barrier.dstStage;
+            }
+
+            if(!imageBarriers.empty())
+                vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+        }
+
+        const Pass& pass = mPasses[step.pass];
+        uint32_t zone = mPassBegin ? mPassBegin(commandBuffer, pass.name) : 0;
+        pass.execute(commandBuffer);
+        if(mPassEnd) mPassEnd(commandBuffer, zone);
+    }
+}
+
+void ke::Graphics::RenderGraph::setPassHooks(PassBeginHook begin, PassEndHook end)
+{
+    mPassBegin = std::move(begin);
+    mPassEnd = std::move(end);
+}
+
+void ke::Graphics::RenderGraph::cullPasses()
+{
+    // Walk backwards from the outputs, a pass survives if something that survives consumes what it writes.
+    std::vector<bool> needed(mResources.size(), false);
+    for(size_t i = 0; i < mResources.size(); i++)
+        needed[i] = mResources[i].output;
+
+    for(size_t i = mPasses.size(); i-- > 0;)
+    {
+        Pass& pass = mPasses[i];
+
+        bool keep = pass.sideEffect;
+        for(const ResourceUse& use : pass.uses)
+            if(use.write && needed[use.resource]) keep = true;
+
+        pass.culled = !keep;
+        if(!keep) continue;
+
+        for(const ResourceUse& use : pass.uses)
+            if(!use.write) needed[use.resource] = true;
+    }
+}
+
+void ke::Graphics::RenderGraph::computeLifetimes()
+{
+    for(Resource& resource : mResources)
+    {
+        resource.firstUse = UINT32_MAX;
+        resource.lastUse = 0;
+    }
+
+    for(uint32_t i = 0; i < mPasses.size(); i++)
+    {
+        if(mPasses[i].culled) continue;
+
+        for(const ResourceUse& use : mPasses[i].uses)
+        {
+            Resource& resource = mResources[use.resource];
+            resource.firstUse = std::min(resource.firstUse, i);
+            resource.lastUse = std::max(resource.lastUse, i);
+        }
+    }
+}
+
+void ke::Graphics::RenderGraph::allocateTransients()
+{
+    std::vector<ResourceHandle> transients;
+    std::vector<VkMemoryRequirements> requirements(mResources.size());
+
+    for(ResourceHandle i = 0; i < mResources.size(); i++)
+    {
+        Resource& resource = mResources[i];
+        if(resource.imported || resource.firstUse == UINT32_MAX) continue;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = resource.desc.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = resource.desc.usage;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if(vkCreateImage(mDevice, &imageInfo, nullptr, &resource.image) != VK_SUCCESS)
+        {
+            mLogger.error("Failed to create transient image {}!", resource.name);
+            resource.image = VK_NULL_HANDLE;
+            continue;
+        }
+
+        vkGetImageMemoryRequirements(mDevice, resource.image, &requirements[i]);
+        transients.push_back(i);
+    }
+
+    // Greedy interval packing: a transient reuses the memory of any group whose members are all dead by its first use.
+    std::sort(transients.begin(), transients.end(), [&](ResourceHandle a, ResourceHandle b)
+    {
+        return mResources[a].firstUse < mResources[b].firstUse;
+    });
+
+    std::vector<uint32_t> groupLastUse;
+    std::vector<uint32_t> groupTypeBits;
+    std::vector<VkDeviceSize> groupSize;
+    std::vector<VkDeviceSize> groupAlignment;
+
+    for(ResourceHandle handle : transients)
+    {
+        Resource& resource = mResources[handle];
+        const VkMemoryRequirements& req = requirements[handle];
+
+        int32_t chosen = -1;
+        for(size_t g = 0; g < mAliasGroups.size(); g++)
+        {
+            if(groupLastUse[g] < resource.firstUse && (groupTypeBits[g] & req.memoryTypeBits) != 0)
+            {
+                chosen = static_cast<int32_t>(g);
+                break;
+            }
+        }
+
+        if(chosen < 0)
+        {
+            chosen = static_cast<int32_t>(mAliasGroups.size());
+            mAliasGroups.push_back({});
+            groupLastUse.push_back(0);
+            groupTypeBits.push_back(req.memoryTypeBits);
+            groupSize.push_back(0);
+            groupAlignment.push_back(1);
+        }
+
+        mAliasGroups[chosen].resources.push_back(handle);
+        groupLastUse[chosen] = resource.lastUse;
+        groupTypeBits[chosen] &= req.memoryTypeBits;
+        groupSize[chosen] = std::max(groupSize[chosen], req.size);
+        groupAlignment[chosen] = std::max(groupAlignment[chosen], req.alignment);
+        resource.aliasGroup = chosen;
+    }
+
+    for(size_t g = 0; g < mAliasGroups.size(); g++)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = groupSize[g];
+        allocInfo.memoryTypeIndex = util::findMemoryType(mPhysicalDevice, groupTypeBits[g], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if(allocInfo.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(mDevice, &allocInfo, nullptr, &mAliasGroups[g].memory) != VK_SUCCESS)
+        {
+            mLogger.error("Failed to allocate transient memory!");
+            continue;
+        }
+
+        for(ResourceHandle handle : mAliasGroups[g].resources)
+        {
+            Resource& resource = mResources[handle];
+            vkBindImageMemory(mDevice, resource.image, mAliasGroups[g].memory, 0);
+
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = resource.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = resource.desc.format;
+            viewInfo.subresourceRange.aspectMask = resource.aspect;
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if(vkCreateImageView(mDevice, &viewInfo, nullptr, &resource.view) != VK_SUCCESS)
+                mLogger.error("Failed to create view for transient image {}!", resource.name);
+        }
+    }
+}
+
+void ke::Graphics::RenderGraph::releaseTransients()
+{
+    if(mDevice == VK_NULL_HANDLE) return;
+
+    for(Resource& resource : mResources)
+    {
+        if(resource.imported) continue;
+
+        if(resource.view != VK_NULL_HANDLE) vkDestroyImageView(mDevice, resource.view, nullptr);
+        if(resource.image != VK_NULL_HANDLE) vkDestroyImage(mDevice, resource.image, nullptr);
+
+        resource.view = VK_NULL_HANDLE;
+        resource.image = VK_NULL_HANDLE;
+        resource.aliasGroup = -1;
+    }
+
+    for(AliasGroup& group : mAliasGroups)
+        if(group.memory != VK_NULL_HANDLE) vkFreeMemory(mDevice, group.memory, nullptr);
+
+    mAliasGroups.clear();
+}
+
+void ke::Graphics::RenderGraph::computeBarriers()
+{
+    struct State
+    {
+        VkPipelineStageFlags stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        VkAccessFlags access = 0;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        bool written = false;
+        bool attachment = false;
+    };
+
+    std::vector<State> states(mResources.size());
+    std::vector<State> groupStates(mAliasGroups.size());
+
+    for(size_t i = 0; i < mResources.size(); i++)
+        states[i].layout = mResources[i].initialLayout;
+
+    mSchedule.clear();
+
+    for(uint32_t p = 0; p < mPasses.size(); p++)
+    {
+        const Pass& pass = mPasses[p];
+        if(pass.culled) continue;
+
+        Step step{};
+        step.pass = p;
+
+        for(const ResourceUse& use : pass.uses)
+        {
+            const Resource& resource = mResources[use.resource];
+            State& state = states[use.resource];
+            AccessInfo info = getAccessInfo(use.access, use.write, pass.type);
+
+            // The previous owner of aliased memory has to be done with it before this image takes over.
+            if(resource.aliasGroup >= 0 && resource.firstUse == p)
+            {
+                const State& groupState = groupStates[resource.aliasGroup];
+                state.stage = groupState.stage;
+                state.access = groupState.access;
+                state.written = groupState.written;
+            }
+
+            // Render passes transition their own attachments and synchronize through their subpass dependencies.
+            VkImageLayout target = info.attachment && state.layout != VK_IMAGE_LAYOUT_UNDEFINED ? state.layout : info.layout;
+            bool layoutChange = target != state.layout;
+            bool hazard = state.written || use.write;
+            bool handledByRenderPass = info.attachment && (state.attachment || state.stage == VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+            if(!handledByRenderPass && (layoutChange || (hazard && state.stage != VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT)))
+            {
+                Barrier barrier{};
+                barrier.resource = use.resource;
+                barrier.srcStage = state.stage;
+                barrier.srcAccess = state.written ? state.access : 0;
+                barrier.dstStage = info.stage;
+                barrier.dstAccess = info.access;
+                barrier.oldLayout = state.layout;
+                barrier.newLayout = target;
+                step.barriers.push_back(barrier);
+            }
+
+            state.stage = info.stage;
+            state.access = info.access;
+            state.written = use.write;
+            state.attachment = info.attachment;
+            state.layout = use.layoutAfter != VK_IMAGE_LAYOUT_UNDEFINED ? use.layoutAfter : target;
+
+            if(resource.aliasGroup >= 0)
+                groupStates[resource.aliasGroup] = state;
+        }
+
+        mSchedule.push_back(std::move(step));
+    }
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../Utility/Logger.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        enum class ResourceAccess
+        {
+            ColorAttachment,
+            DepthAttachment,
+            SampledFragment,
+            SampledCompute,
+            StorageRead,
+            StorageWrite,
+            TransferSrc,
+            TransferDst,
+            Present
+        };
+
+        enum class PassType
+        {
+            Graphics,
+            Compute
+        };
+
+        using ResourceHandle = uint32_t;
+
+        struct TransientImageDesc
+        {
+            VkExtent2D extent;
+            VkFormat format;
+            VkImageUsageFlags usage;
+            VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        };
+
+        class RenderGraph;
+
+        class PassBuilder
+        {
+        public:
+            // Attachments are transitioned by the pass' own VkRenderPass, layoutAfter is what it leaves behind.
+            void read(ResourceHandle resource, ResourceAccess access, VkImageLayout layoutAfter = VK_IMAGE_LAYOUT_UNDEFINED);
+            void write(ResourceHandle resource, ResourceAccess access, VkImageLayout layoutAfter = VK_IMAGE_LAYOUT_UNDEFINED);
+            void sideEffect();
+        private:
+            friend class RenderGraph;
+            PassBuilder(RenderGraph& graph, uint32_t pass) : mGraph(graph), mPass(pass) {}
+
+            RenderGraph& mGraph;
+            uint32_t mPass;
+        };
+
+        class RenderGraph
+        {
+        public:
+            // Called around every scheduled pass outside its render pass, e.g. to open a GPU timing zone.
+            using PassBeginHook = std::function<uint32_t(VkCommandBuffer, const std::string&)>;
+            using PassEndHook = std::function<void(VkCommandBuffer, uint32_t)>;
+
+            RenderGraph() = default;
+
+            void init(VkDevice device, VkPhysicalDevice physicalDevice);
+            void destroy();
+
+            ResourceHandle importImage(const std::string& name, VkImageAspectFlags aspect, VkImageLayout initialLayout, bool output = false);
+            void setImportedImage(ResourceHandle resource, VkImage image);
+
+            ResourceHandle createTransientImage(const std::string& name, const TransientImageDesc& desc);
+            VkImage getImage(ResourceHandle resource) const;
+            VkImageView getImageView(ResourceHandle resource) const;
+
+            void addPass(const std::string& name, PassType type, const std::function<void(PassBuilder&)>& setup, std::function<void(VkCommandBuffer)> execute);
+
+            void compile();
+            void execute(VkCommandBuffer commandBuffer);
+            void setPassHooks(PassBeginHook begin, PassEndHook end);
+
+            bool isCompiled() const {return mCompiled;}
+            void invalidate() {mCompiled = false;}
+        private:
+            friend class PassBuilder;
+
+            struct ResourceUse
+            {
+                ResourceHandle resource;
+                ResourceAccess access;
+                VkImageLayout layoutAfter;
+                bool write;
+            };
+
+            struct Pass
+            {
+                std::string name;
+                PassType type;
+                std::vector<ResourceUse> uses;
+                std::function<void(VkCommandBuffer)> execute;
+                bool sideEffect = false;
+                bool culled = false;
+            };
+
+            struct Resource
+            {
+                std::string name;
+                bool imported;
+                bool output;
+                VkImageAspectFlags aspect;
+                VkImageLayout initialLayout;
+
+                TransientImageDesc desc{};
+                VkImage image = VK_NULL_HANDLE;
+                VkImageView view = VK_NULL_HANDLE;
+                int32_t aliasGroup = -1;
+
+                uint32_t firstUse = UINT32_MAX;
+                uint32_t lastUse = 0;
+            };
+
+            struct Barrier
+            {
+                ResourceHandle resource;
+                VkPipelineStageFlags srcStage;
+                VkAccessFlags srcAccess;
+                VkPipelineStageFlags dstStage;
+                VkAccessFlags dstAccess;
+                VkImageLayout oldLayout;
+                VkImageLayout newLayout;
+            };
+
+            struct Step
+            {
+                uint32_t pass;
+                std::vector<Barrier> barriers;
+            };
+
+            struct AliasGroup
+            {
+                std::vector<ResourceHandle> resources;
+                VkDeviceMemory memory = VK_NULL_HANDLE;
+            };
+
+            void cullPasses();
+            void computeLifetimes();
+            void assignAliasGroups();
+            void allocateTransients();
+            void releaseTransients();
+            void computeBarriers();
+
+            util::Logger mLogger = util::Logger("Render Graph Logger");
+
+            VkDevice mDevice = VK_NULL_HANDLE;
+            VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+
+            std::vector<Pass> mPasses;
+            std::vector<Resource> mResources;
+            std::vector<AliasGroup> mAliasGroups;
+            std::vector<Step> mSchedule;
+
+            PassBeginHook mPassBegin;
+            PassEndHook mPassEnd;
+
+            bool mCompiled = false;
+        };
+    }
+}
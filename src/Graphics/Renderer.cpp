@@ -1,5 +1,8 @@
 #include "Renderer.hpp"
+#include "../Utility/Profiler.hpp"
+#include "../Utility/FrameAllocator.hpp"
 #include <iostream>
+#include <map>
 #include <set>
 #include <vulkan/vulkan_core.h>
 #define GLM_FORCE_RADIANS
@@ -9,6 +12,8 @@
 #include <chrono>
 #include <type_traits>
 
+#include "../Utility/FileCache.hpp"
+
 #include <stb/stb_image.h>
 
 const std::vector<const char*> gValidationLayers = 
@@ -27,6 +32,33 @@ bool enableValidationLayers = true;
 bool enableValidationLayers = false;
 #endif
 
+// Written in front of the VkPipelineCache blob. The blob's own header carries vendor/device/UUID,
+// but not the driver version, and a driver update can silently invalidate the contents.
+struct PipelineCachePrefix
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t uuid[VK_UUID_SIZE];
+    uint64_t dataSize;
+    uint64_t dataHash;
+};
+
+static const uint32_t PIPELINE_CACHE_MAGIC = 0x4B45504C; // "KEPL"
+static const uint32_t PIPELINE_CACHE_VERSION = 1;
+
+static std::filesystem::path getPipelineCachePath()
+{
+    return ke::util::getCacheDirectory() / "pipeline_cache.bin";
+}
+
+static uint32_t getFontTexelSize(VkFormat format)
+{
+    return format == VK_FORMAT_R8_UNORM ? 1 : 4;
+}
+
 ke::Graphics::Renderer &ke::Graphics::Renderer::getInstance()
 {
     static Renderer instance;
@@ -35,21 +67,28 @@ ke::Graphics::Renderer &ke::Graphics::Renderer::getInstance()
 
 void ke::Graphics::Renderer::init(GLFWwindow* window)
 {
+    ShaderLibrary::getInstance().init();
+    initDevice(window);
+    initPipelines();
+}
+
+void ke::Graphics::Renderer::initDevice(GLFWwindow* window)
+{
+    KE_PROFILE_FUNCTION();
     mLogger.trace("Initializing renderer.");
     createVulkanInstance();
     setupDebugMessenger();
-    createWindowSurface(window);
+    if(!mHeadless) createWindowSurface(window);
     pickPhysicalDevice();
     createLogicalDevice();
-    createSwapchain(window);
+    if(mHeadless) createOffscreenTargets();
+    else createSwapchain(window);
     createSwapchainImageViews();
     createDepthResources();
     createRenderPass();
     createFontRenderPass();
     createSceneRenderPass();
     createDescriptorSetLayout();
-    createGraphicsPipeline();
-    createFontPipeline();
     createFramebuffers();
     createCommandPool();
     createTextureSampler();
@@ -59,14 +98,54 @@ void ke::Graphics::Renderer::init(GLFWwindow* window)
     createDescriptorSets();
     createCommandBuffer();
     createSyncObjects();
+    if(mHeadless) mFrameCapture.init(mDevice, mPhysicalDevice, MAXFRAMESINFLIGHT);
+    mGpuProfiler.init(mDevice, mPhysicalDevice, findQueueFamilyIndices(mPhysicalDevice).graphicsFamily.value(), MAXFRAMESINFLIGHT, mPipelineStatisticsSupported);
+    mTextBatcher.init(mDevice, mPhysicalDevice, MAXFRAMESINFLIGHT);
 
     mLogger.info("Initialized renderer.");
 }
 
+void ke::Graphics::Renderer::initPipelines()
+{
+    KE_PROFILE_FUNCTION();
+    createPipelineLayouts();
+
+    auto pipelineStart = std::chrono::high_resolution_clock::now();
+    createPipelineCache();
+    util::JobCounter fontPipelineBuild;
+    util::JobSystem::getInstance().schedule([this]()
+    {
+        createFontPipeline(mFontPipeline);
+    }, {"FontPipeline", &fontPipelineBuild});
+    createGraphicsVariants({VARIANT_NONE, VARIANT_TEXTURED}, mUIPipelines, mScenePipelines);
+    util::JobSystem::getInstance().wait(fontPipelineBuild);
+    float pipelineTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - pipelineStart).count();
+    mLogger.info("Created pipelines in {:.2f} ms ({} start).", pipelineTime, mPipelineCacheWarm ? "warm" : "cold");
+
+#ifdef DEBUG
+    ShaderLibrary::getInstance().startWatching();
+#endif
+}
+
 void ke::Graphics::Renderer::terminate()
 {
     vkDeviceWaitIdle(mDevice);
 
+    ShaderLibrary::getInstance().terminate();
+    util::JobSystem::getInstance().wait(mGraphicsRebuild);
+    util::JobSystem::getInstance().wait(mFontRebuild);
+    for(uint32_t variant = 0; variant < VARIANT_COUNT; variant++)
+    {
+        retirePipeline(mPendingUIPipelines[variant]);
+        retirePipeline(mPendingScenePipelines[variant]);
+        retirePipeline(mUIPipelines[variant]);
+        retirePipeline(mScenePipelines[variant]);
+    }
+    retirePipeline(mPendingFontPipeline);
+    destroyRetiredPipelines(true);
+
+    savePipelineCache();
+
     mDepthImage.destroy();
 
     vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
@@ -90,6 +169,10 @@ void ke::Graphics::Renderer::terminate()
     vkDestroyDescriptorSetLayout(mDevice, mDescriptorSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(mDevice, mFontSetLayout, nullptr);
 
+    mGpuProfiler.destroy();
+    mFrameCapture.destroy();
+    mTextBatcher.destroy();
+
     for(size_t i = 0; i < mSwapchainImages.size(); i++)
         vkDestroySemaphore(mDevice, mRenderFinishedSemaphores[i], nullptr);
     for(int i = 0; i < MAXFRAMESINFLIGHT; i++)
@@ -101,17 +184,17 @@ void ke::Graphics::Renderer::terminate()
     cleanupSwapchain();
 
     vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
-    vkDestroyPipeline(mDevice, mPipeline, nullptr);
-    vkDestroyPipeline(mDevice, mDisplayPipeline, nullptr);
     vkDestroyPipeline(mDevice, mFontPipeline, nullptr);
 
+    vkDestroyPipelineCache(mDevice, mPipelineCache, nullptr);
+
     vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
     vkDestroyPipelineLayout(mDevice, mFontPipelineLayout, nullptr);
     vkDestroyRenderPass(mDevice, mSceneRenderPass, nullptr);
     vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
     vkDestroyRenderPass(mDevice, mFontRenderPass, nullptr);
 
-    vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
+    if(!mHeadless) vkDestroySurfaceKHR(mInstance, mSurface, nullptr);
     vkDestroyDevice(mDevice, nullptr);
     DestroyDebugUtilsMessenger(mInstance, mDebugMessenger, nullptr);
     vkDestroyInstance(mInstance, nullptr);
@@ -119,15 +202,47 @@ void ke::Graphics::Renderer::terminate()
 
 void ke::Graphics::Renderer::readyCanvas(GLFWwindow *window)
 {
-    vkWaitForFences(mDevice, 1, &mInFlightFences[currentFrameInFlight], VK_TRUE, UINT64_MAX);
+    KE_PROFILE_FUNCTION();
+    util::FrameArena::beginFrame();
 
-    VkResult status = vkAcquireNextImageKHR(mDevice, mSwapchain, UINT64_MAX, mImageAvailableSemaphores[currentFrameInFlight], VK_NULL_HANDLE, &currentImageIndex);
+    auto waitStart = std::chrono::high_resolution_clock::now();
+    {
+        KE_PROFILE_ZONE("WaitForFence");
+        vkWaitForFences(mDevice, 1, &mInFlightFences[currentFrameInFlight], VK_TRUE, UINT64_MAX);
+    }
+    mLastFenceWait = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - waitStart).count();
+
+    mGpuProfiler.collect(currentFrameInFlight);
+    mTextBatcher.begin(currentFrameInFlight);
+    mLastDrawCounters = mDrawCounters;
+    mDrawCounters = DrawCounters{};
+    processShaderReloads();
+
+    if(mHeadless)
+    {
+        // One offscreen image per frame in flight, the fence above already covers reusing it.
+        mFrameCapture.resolve(currentFrameInFlight);
+        currentImageIndex = currentFrameInFlight;
+
+        vkResetFences(mDevice, 1, &mInFlightFences[currentFrameInFlight]);
+        vkResetCommandBuffer(mCommandBuffers[currentFrameInFlight], 0);
+
+        beginRecording(mCommandBuffers[currentFrameInFlight]);
+        vkCmdBindDescriptorSets(mCommandBuffers[currentFrameInFlight], VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 0, 1, &mTextureDescriptorSet, 0, nullptr);
+        return;
+    }
+
+    VkResult status;
+    {
+        KE_PROFILE_ZONE("AcquireImage");
+        status = vkAcquireNextImageKHR(mDevice, mSwapchain, UINT64_MAX, mImageAvailableSemaphores[currentFrameInFlight], VK_NULL_HANDLE, &currentImageIndex);
+    }
 
     if(status == VK_ERROR_OUT_OF_DATE_KHR)
     {
         recreateSwapchain(window);
 
-        currentFrameInFlight = (currentFrameInFlight + 1) % MAXFRAMESINFLIGHT;
+        currentFrameInFlight = (currentFrameInFlight + 1) % mFramesInFlight;
 
         return;
     }
@@ -187,6 +302,36 @@ void ke::Graphics::Renderer::updateFontUniforms()
 
 void ke::Graphics::Renderer::finishDraw(GLFWwindow *window)
 {
+    KE_PROFILE_FUNCTION();
+
+    if(mHeadless)
+    {
+        if(!mPendingCapturePath.empty())
+        {
+            mFrameCapture.record(mCommandBuffers[currentFrameInFlight], currentFrameInFlight, mSwapchainImages[currentImageIndex], mBackbufferLayout, mSwapchainExtent, mSwapchainFormat, mPendingCapturePath);
+            mPendingCapturePath.clear();
+        }
+
+        endRecording(mCommandBuffers[currentFrameInFlight]);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &mCommandBuffers[currentFrameInFlight];
+
+        {
+            KE_PROFILE_ZONE("QueueSubmit");
+            if(vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mInFlightFences[currentFrameInFlight]) != VK_SUCCESS)
+                mLogger.error("Failed to submit to graphics queue!");
+            else
+                mGpuProfiler.markSubmitted();
+        }
+
+        mFrameCounter++;
+        currentFrameInFlight = (currentFrameInFlight + 1) % mFramesInFlight;
+        return;
+    }
+
     endRecording(mCommandBuffers[currentFrameInFlight]);
 
     VkSubmitInfo submitInfo{};
@@ -204,8 +349,13 @@ void ke::Graphics::Renderer::finishDraw(GLFWwindow *window)
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if(vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mInFlightFences[currentFrameInFlight]) != VK_SUCCESS)
-        mLogger.error("Failed to submit to graphics queue!");
+    {
+        KE_PROFILE_ZONE("QueueSubmit");
+        if(vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mInFlightFences[currentFrameInFlight]) != VK_SUCCESS)
+            mLogger.error("Failed to submit to graphics queue!");
+        else
+            mGpuProfiler.markSubmitted();
+    }
 
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -217,14 +367,20 @@ void ke::Graphics::Renderer::finishDraw(GLFWwindow *window)
     presentInfo.pSwapchains = swapchains;
     presentInfo.pImageIndices = &currentImageIndex;
 
-    VkResult result = vkQueuePresentKHR(mPresentQueue, &presentInfo);
+    VkResult result;
+    {
+        KE_PROFILE_ZONE("QueuePresent");
+        result = vkQueuePresentKHR(mPresentQueue, &presentInfo);
+    }
+
+    mFrameCounter++;
 
     if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
     {
         recreateSwapchain(window);
         framebufferResized = false;
     }
-    currentFrameInFlight = (currentFrameInFlight + 1) % MAXFRAMESINFLIGHT;
+    currentFrameInFlight = (currentFrameInFlight + 1) % mFramesInFlight;
 }
 
 glm::ivec2 ke::Graphics::Renderer::getSwapchainDimensions() const
@@ -232,18 +388,33 @@ glm::ivec2 ke::Graphics::Renderer::getSwapchainDimensions() const
     return glm::ivec2(mSwapchainExtent.width, mSwapchainExtent.height);
 }
 
+ke::util::DecodedImage ke::Graphics::Renderer::decodeTextureImage(const std::string &filepath) const
+{
+    KE_PROFILE_FUNCTION();
+    util::DecodedImage decoded;
+
+    int numColCh;
+    decoded.pixels = {stbi_load(filepath.c_str(), &decoded.width, &decoded.height, &numColCh, STBI_rgb_alpha), stbi_image_free};
+
+    if(!decoded.pixels)
+        mLogger.error("Failed to load texture details!");
+
+    return decoded;
+}
+
 void ke::Graphics::Renderer::createTextureImage(const std::string &filepath, util::Image &image)
 {
-    int texWidth, texHeight, numColCh;
-    stbi_uc* pixels = stbi_load(filepath.c_str(), &texWidth, &texHeight, &numColCh, STBI_rgb_alpha);
+    createTextureImage(decodeTextureImage(filepath), image);
+}
+
+void ke::Graphics::Renderer::createTextureImage(const util::DecodedImage &decoded, util::Image &image)
+{
+    int texWidth = decoded.width, texHeight = decoded.height;
+    const stbi_uc* pixels = decoded.pixels.get();
     mMipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(texWidth, texHeight)))) + 1;
 
     VkDeviceSize imageSize = texWidth * texHeight * 4;
 
-    if(!pixels)
-        mLogger.error("Failed to load texture details!");
-
-    
     util::Buffer stagingBuffer(mDevice);
 
     createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, stagingBuffer.buffer, stagingBuffer.bufferMemory);
@@ -253,8 +424,6 @@ void ke::Graphics::Renderer::createTextureImage(const std::string &filepath, uti
         memcpy(data, pixels, imageSize);
     vkUnmapMemory(mDevice, stagingBuffer.bufferMemory);
 
-    stbi_image_free(pixels);
-
     createImage(texWidth, texHeight, mMipLevels, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image.image, image.imageMemory);
 
     transitionImageLayout(image.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mMipLevels);   
@@ -293,13 +462,13 @@ uint32_t ke::Graphics::Renderer::addTextureToDescriptor(const util::Image &image
     return rendererIndex++;
 }
 
-void ke::Graphics::Renderer::createFontImage(const std::unordered_map<uint32_t, ke::Graphics::Text::GlyphInfo> &glyphs, const unsigned int ATLAS_SIZE, VkImage& fontImage, VkDeviceMemory& fontImageMemory)
+void ke::Graphics::Renderer::createFontImage(const uint8_t* atlasPixels, uint32_t width, uint32_t height, VkFormat format, VkImage& fontImage, VkDeviceMemory& fontImageMemory)
 {
-    createImage(ATLAS_SIZE, ATLAS_SIZE, 1, VK_FORMAT_B8G8R8A8_UNORM, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, fontImage, fontImageMemory);
+    createImage(width, height, 1, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, fontImage, fontImageMemory);
 
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
-    VkDeviceSize stagingBufferSize = ATLAS_SIZE * ATLAS_SIZE * 4;
+    VkDeviceSize stagingBufferSize = static_cast<VkDeviceSize>(width) * height * getFontTexelSize(format);
 
     util::Buffer stagingBuffer(mDevice);
     createBuffer(stagingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer.buffer, stagingBuffer.bufferMemory);
@@ -307,38 +476,24 @@ void ke::Graphics::Renderer::createFontImage(const std::unordered_map<uint32_t,
     void* data;
     vkMapMemory(mDevice, stagingBuffer.bufferMemory, 0, stagingBufferSize, 0, &data);
     {
-        transitionImageLayout(fontImage, VK_FORMAT_B8G8R8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, commandBuffer);
-        VkDeviceSize stagingOffset = 0;
-        memset(data, 0, stagingBufferSize);
-
-        for (auto& [codepoint, glyph] : glyphs) 
-            for (int row = 0; row < (int)glyph.height; row++) {
-                uint8_t* dst = (uint8_t*)data + ((glyph.atlasY + row) * ATLAS_SIZE + glyph.atlasX) * 4;
-                
-                for (int x = 0; x < (int)glyph.width; x++) {
-                    
-                    int src = (row * glyph.width + x) * 4;
-                    dst[x*4+0] = (uint8_t)(glyph.pixels[src+2] * 255.0f);
-                    dst[x*4+1] = (uint8_t)(glyph.pixels[src+1] * 255.0f);
-                    dst[x*4+2] = (uint8_t)(glyph.pixels[src+0] * 255.0f);
-                    dst[x*4+3] = 255;
-                }
-            }
-        
+        transitionImageLayout(fontImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, commandBuffer);
+        // A page started at runtime has nothing in it yet.
+        if(atlasPixels) memcpy(data, atlasPixels, stagingBufferSize);
+        else memset(data, 0, stagingBufferSize);
 
         VkBufferImageCopy region{};
         region.bufferOffset      = 0;
-        region.bufferRowLength   = ATLAS_SIZE;
-        region.bufferImageHeight = ATLAS_SIZE;
+        region.bufferRowLength   = width;
+        region.bufferImageHeight = height;
         region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
         region.imageSubresource.baseArrayLayer = 0;
         region.imageSubresource.layerCount     = 1;
         region.imageSubresource.mipLevel       = 0;
         region.imageOffset = {0, 0, 0};
-        region.imageExtent = {ATLAS_SIZE, ATLAS_SIZE, 1};
+        region.imageExtent = {width, height, 1};
         vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, fontImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 
-        transitionImageLayout(fontImage, VK_FORMAT_B8G8R8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, commandBuffer);
+        transitionImageLayout(fontImage, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, commandBuffer);
     }
     vkUnmapMemory(mDevice, stagingBuffer.bufferMemory);
 
@@ -348,15 +503,93 @@ void ke::Graphics::Renderer::createFontImage(const std::unordered_map<uint32_t,
 
 }
 
-void ke::Graphics::Renderer::createFontImageView(util::Image &image)
+void ke::Graphics::Renderer::growFontImage(util::Image& image, VkFormat format, uint32_t width, uint32_t oldHeight, uint32_t newHeight, uint32_t descriptorIndex)
 {
-    image.imageView = createImageView(image.image, VK_FORMAT_B8G8R8A8_UNORM, 1, VK_IMAGE_ASPECT_COLOR_BIT);
+    util::Image grown{};
+    grown.setDevice(mDevice);
+    createImage(width, newHeight, 1, format, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, grown.image, grown.imageMemory);
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    transitionImageLayout(grown.image, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, commandBuffer);
+    transitionImageLayout(image.image, format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 1, commandBuffer);
+
+    // The new rows get sampled by filtering at glyph edges, so they start out empty rather than undefined.
+    VkClearColorValue clear{};
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    vkCmdClearColorImage(commandBuffer, grown.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &range);
+
+    VkImageCopy copy{};
+    copy.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    copy.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    copy.extent = {width, oldHeight, 1};
+    vkCmdCopyImage(commandBuffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, grown.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+    transitionImageLayout(grown.image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, commandBuffer);
+    endSingleTimeCommands(commandBuffer);
+
+    createFontImageView(grown, format);
+    writeFontDescriptor(descriptorIndex, grown);
+
+    image = std::move(grown);
+}
+
+void ke::Graphics::Renderer::updateFontImage(VkImage fontImage, VkFormat format, const std::vector<Text::AtlasUpload>& regions)
+{
+    VkDeviceSize stagingBufferSize = 0;
+    for(const Text::AtlasUpload& region : regions)
+        stagingBufferSize += region.pixels.size();
+    if(stagingBufferSize == 0) return;
+
+    util::Buffer stagingBuffer(mDevice);
+    createBuffer(stagingBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer.buffer, stagingBuffer.bufferMemory);
+
+    std::vector<VkBufferImageCopy> copies;
+    copies.reserve(regions.size());
+
+    void* data;
+    vkMapMemory(mDevice, stagingBuffer.bufferMemory, 0, stagingBufferSize, 0, &data);
+    VkDeviceSize offset = 0;
+    for(const Text::AtlasUpload& region : regions)
+    {
+        memcpy(static_cast<uint8_t*>(data) + offset, region.pixels.data(), region.pixels.size());
+
+        VkBufferImageCopy copy{};
+        copy.bufferOffset = offset;
+        copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.imageSubresource.layerCount = 1;
+        copy.imageOffset = {static_cast<int32_t>(region.x), static_cast<int32_t>(region.y), 0};
+        copy.imageExtent = {region.width, region.height, 1};
+        copies.push_back(copy);
+
+        offset += region.pixels.size();
+    }
+    vkUnmapMemory(mDevice, stagingBuffer.bufferMemory);
+
+    // The submit waits for the queue to idle, so no frame in flight is still sampling the page.
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    transitionImageLayout(fontImage, format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, commandBuffer);
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer.buffer, fontImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(copies.size()), copies.data());
+    transitionImageLayout(fontImage, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, commandBuffer);
+    endSingleTimeCommands(commandBuffer);
+
+    stagingBuffer.destroy();
+}
+
+void ke::Graphics::Renderer::createFontImageView(util::Image &image, VkFormat format)
+{
+    image.imageView = createImageView(image.image, format, 1, VK_IMAGE_ASPECT_COLOR_BIT);
 }
 
 uint32_t ke::Graphics::Renderer::addFontToDescriptor(const util::Image &image)
 {
     static uint32_t rendererIndex = 0;
 
+    writeFontDescriptor(rendererIndex, image);
+    return rendererIndex++;
+}
+
+void ke::Graphics::Renderer::writeFontDescriptor(uint32_t index, const util::Image& image)
+{
     VkDescriptorImageInfo imageInfo{};
     imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     imageInfo.imageView = image.imageView;
@@ -366,14 +599,27 @@ uint32_t ke::Graphics::Renderer::addFontToDescriptor(const util::Image &image)
     write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     write.descriptorCount = 1;
     write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    write.dstArrayElement = rendererIndex;
+    write.dstArrayElement = index;
     write.dstBinding = 1;
     write.dstSet = mFontDescriptorSet;
     write.pImageInfo = &imageInfo;
     
     vkUpdateDescriptorSets(mDevice, 1, &write, 0, nullptr);
+}
 
-    return rendererIndex++;
+void ke::Graphics::Renderer::setFramesInFlight(uint32_t count)
+{
+    // Slots above the new count simply stop being used, their fences have signaled or will on their own.
+    mFramesInFlight = std::clamp<uint32_t>(count, 1, MAXFRAMESINFLIGHT);
+    mLogger.info("Using {} frames in flight.", mFramesInFlight);
+}
+
+void ke::Graphics::Renderer::setPresentMode(PresentMode mode)
+{
+    if(mode == mPresentMode) return;
+
+    mPresentMode = mode;
+    framebufferResized = true; // picked up by the swapchain recreation at the end of the frame
 }
 
 void ke::Graphics::Renderer::signalWindowResize()
@@ -457,6 +703,8 @@ void ke::Graphics::Renderer::pickPhysicalDevice()
     
     vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &features2);
 
+    mPipelineStatisticsSupported = features2.features.pipelineStatisticsQuery == VK_TRUE;
+
     bool supportsBindless = v12.descriptorIndexing && v12.runtimeDescriptorArray && v12.descriptorBindingUpdateUnusedWhilePending && v12.shaderSampledImageArrayNonUniformIndexing && v12.descriptorBindingPartiallyBound && v12.descriptorBindingVariableDescriptorCount && v12.descriptorBindingSampledImageUpdateAfterBind;
 
     if(supportsBindless)
@@ -528,6 +776,7 @@ void ke::Graphics::Renderer::createLogicalDevice()
     deviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
     deviceFeatures2.pNext = &enabled12;
     deviceFeatures2.features.samplerAnisotropy = VK_TRUE;
+    deviceFeatures2.features.pipelineStatisticsQuery = mPipelineStatisticsSupported ? VK_TRUE : VK_FALSE;
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -535,8 +784,8 @@ void ke::Graphics::Renderer::createLogicalDevice()
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
     createInfo.pQueueCreateInfos = queueInfos.data();
     createInfo.pEnabledFeatures = nullptr;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(gDeviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = gDeviceExtensions.data();
+    createInfo.enabledExtensionCount = mHeadless ? 0 : static_cast<uint32_t>(gDeviceExtensions.size());
+    createInfo.ppEnabledExtensionNames = mHeadless ? nullptr : gDeviceExtensions.data();
     
     if(enableValidationLayers)
     {
@@ -565,6 +814,8 @@ void ke::Graphics::Renderer::createWindowSurface(GLFWwindow* window)
 
 bool ke::Graphics::Renderer::checkDeviceExtensionSupport(VkPhysicalDevice device)
 {
+    if(mHeadless) return true;
+
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
     std::vector<VkExtensionProperties> extensions(extensionCount);
@@ -598,10 +849,15 @@ ke::util::QueueFamilyIndices ke::Graphics::Renderer::findQueueFamilyIndices(VkPh
         if(prop.queueFlags & VK_QUEUE_TRANSFER_BIT)
             indices.transferFamily = i;
          
-        VkBool32 presentSupport = VK_FALSE;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, mSurface, &presentSupport);
+        if(mHeadless)
+            indices.presentFamily = indices.graphicsFamily;
+        else
+        {
+            VkBool32 presentSupport = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, mSurface, &presentSupport);
 
-        if(presentSupport) indices.presentFamily = i;
+            if(presentSupport) indices.presentFamily = i;
+        }
 
         if(indices.isComplete())
             break;
@@ -657,9 +913,18 @@ VkSurfaceFormatKHR ke::Graphics::Renderer::chooseSwapchainSurfaceFormat(const st
 
 VkPresentModeKHR ke::Graphics::Renderer::chooseSwapchainPresentMode(const std::vector<VkPresentModeKHR> &available)
 {
+    VkPresentModeKHR desired = VK_PRESENT_MODE_FIFO_KHR;
+    switch(mPresentMode)
+    {
+    case PresentMode::Fifo: desired = VK_PRESENT_MODE_FIFO_KHR; break;
+    case PresentMode::FifoRelaxed: desired = VK_PRESENT_MODE_FIFO_RELAXED_KHR; break;
+    case PresentMode::Mailbox: desired = VK_PRESENT_MODE_MAILBOX_KHR; break;
+    case PresentMode::Immediate: desired = VK_PRESENT_MODE_IMMEDIATE_KHR; break;
+    }
+
     for(const auto& mode : available)
     {
-        if(mode == VK_PRESENT_MODE_MAILBOX_KHR)
+        if(mode == desired)
             return mode;
     }
 
@@ -807,13 +1072,192 @@ void ke::Graphics::Renderer::cleanupSwapchain()
     for(auto view : mSwapchainImageViews)
         vkDestroyImageView(mDevice, view, nullptr);
     
-    vkDestroySwapchainKHR(mDevice, mSwapchain, nullptr);
+    if(mHeadless)
+    {
+        for(size_t i = 0; i < mSwapchainImages.size(); i++)
+        {
+            vkDestroyImage(mDevice, mSwapchainImages[i], nullptr);
+            vkFreeMemory(mDevice, mOffscreenMemory[i], nullptr);
+        }
+        mOffscreenMemory.clear();
+    }
+    else
+        vkDestroySwapchainKHR(mDevice, mSwapchain, nullptr);
+}
+
+void ke::Graphics::Renderer::createOffscreenTargets()
+{
+    // Same format the windowed path prefers, so pipelines and golden images match between the two.
+    mSwapchainFormat = VK_FORMAT_B8G8R8A8_SRGB;
+
+    mSwapchainImages.resize(mFramesInFlight);
+    mOffscreenMemory.resize(mFramesInFlight);
+
+    for(uint32_t i = 0; i < mFramesInFlight; i++)
+        createImage(mSwapchainExtent.width, mSwapchainExtent.height, 1, mSwapchainFormat, VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mSwapchainImages[i], mOffscreenMemory[i]);
+
+    mLogger.info("Created {} offscreen targets ({}x{}).", mFramesInFlight, mSwapchainExtent.width, mSwapchainExtent.height);
+}
+
+void ke::Graphics::Renderer::setHeadless(uint32_t width, uint32_t height)
+{
+    mHeadless = true;
+    mSwapchainExtent = {width, height};
+    mBackbufferLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+}
+
+void ke::Graphics::Renderer::requestFrameCapture(const std::string& path)
+{
+    if(!mHeadless)
+    {
+        mLogger.warn("Frame capture is only available in headless mode.");
+        return;
+    }
+
+    mPendingCapturePath = path;
+}
+
+void ke::Graphics::Renderer::createPipelineCache()
+{
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(mPhysicalDevice, &props);
+
+    std::vector<char> fileData;
+    std::vector<char> initialData;
+
+    if(util::readCacheFile(getPipelineCachePath(), fileData) && fileData.size() >= sizeof(PipelineCachePrefix))
+    {
+        PipelineCachePrefix prefix{};
+        memcpy(&prefix, fileData.data(), sizeof(prefix));
+
+        const char* payload = fileData.data() + sizeof(prefix);
+        size_t payloadSize = fileData.size() - sizeof(prefix);
+
+        bool valid = prefix.magic == PIPELINE_CACHE_MAGIC && prefix.version == PIPELINE_CACHE_VERSION
+            && prefix.vendorID == props.vendorID && prefix.deviceID == props.deviceID
+            && prefix.driverVersion == props.driverVersion
+            && memcmp(prefix.uuid, props.pipelineCacheUUID, VK_UUID_SIZE) == 0
+            && prefix.dataSize == payloadSize && prefix.dataHash == util::hashBytes(payload, payloadSize);
+
+        if(valid)
+            initialData.assign(payload, payload + payloadSize);
+        else
+            mLogger.warn("Pipeline cache on disk belongs to another device or driver, discarding it.");
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    if(vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mPipelineCache) != VK_SUCCESS)
+    {
+        mLogger.warn("Failed to create pipeline cache from disk data, starting with an empty one.");
+
+        initialData.clear();
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+
+        if(vkCreatePipelineCache(mDevice, &createInfo, nullptr, &mPipelineCache) != VK_SUCCESS)
+            mLogger.error("Failed to create pipeline cache!");
+    }
+
+    mPipelineCacheWarm = !initialData.empty();
+    mLogger.info(mPipelineCacheWarm ? "Loaded pipeline cache from disk." : "Created empty pipeline cache.");
+}
+
+void ke::Graphics::Renderer::savePipelineCache()
+{
+    if(mPipelineCache == VK_NULL_HANDLE) return;
+
+    size_t dataSize = 0;
+    if(vkGetPipelineCacheData(mDevice, mPipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+        return;
+
+    std::vector<char> fileData(sizeof(PipelineCachePrefix) + dataSize);
+    char* payload = fileData.data() + sizeof(PipelineCachePrefix);
+
+    if(vkGetPipelineCacheData(mDevice, mPipelineCache, &dataSize, payload) != VK_SUCCESS)
+    {
+        mLogger.warn("Failed to read back pipeline cache data.");
+        return;
+    }
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(mPhysicalDevice, &props);
+
+    PipelineCachePrefix prefix{};
+    prefix.magic = PIPELINE_CACHE_MAGIC;
+    prefix.version = PIPELINE_CACHE_VERSION;
+    prefix.vendorID = props.vendorID;
+    prefix.deviceID = props.deviceID;
+    prefix.driverVersion = props.driverVersion;
+    memcpy(prefix.uuid, props.pipelineCacheUUID, VK_UUID_SIZE);
+    prefix.dataSize = dataSize;
+    prefix.dataHash = util::hashBytes(payload, dataSize);
+    memcpy(fileData.data(), &prefix, sizeof(prefix));
+
+    if(util::writeCacheFile(getPipelineCachePath(), fileData.data(), sizeof(PipelineCachePrefix) + dataSize))
+        mLogger.info("Saved pipeline cache to disk.");
+    else
+        mLogger.warn("Failed to write pipeline cache to disk.");
+}
+
+void ke::Graphics::Renderer::createPipelineLayouts()
+{
+    VkDescriptorSetLayout dLayouts[] = {mTextureSetLayout, mDescriptorSetLayout};
+
+    VkPushConstantRange pushRange = reflectPushConstantRange({"shader.vert", "shader.frag", "scene.vert", "scene.frag"});
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 2;
+    layoutInfo.pSetLayouts = dLayouts;
+    layoutInfo.pushConstantRangeCount = pushRange.size ? 1 : 0;
+    layoutInfo.pPushConstantRanges = &pushRange;
+    
+    if(vkCreatePipelineLayout(mDevice, &layoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS)
+        mLogger.error("Failed to create a pipeline layout!");
+
+    VkDescriptorSetLayout setLayouts[] = {mFontSetLayout};
+
+    VkPushConstantRange pcRange = reflectPushConstantRange({"text.vert", "text.frag"});
+
+    VkPipelineLayoutCreateInfo fontLayoutInfo{};
+    fontLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    fontLayoutInfo.pushConstantRangeCount = pcRange.size ? 1 : 0;
+    fontLayoutInfo.pPushConstantRanges = &pcRange;
+    fontLayoutInfo.setLayoutCount = 1;
+    fontLayoutInfo.pSetLayouts = setLayouts;
+
+    if(vkCreatePipelineLayout(mDevice, &fontLayoutInfo, nullptr, &mFontPipelineLayout) != VK_SUCCESS)
+        mLogger.error("Failed to create font pipeline layout.");
+
+    // Remember what the layouts were built from, a reload that changes any of it can't reuse them.
+    for(const char* name : {"shader.vert", "shader.frag", "scene.vert", "scene.frag", "text.vert", "text.frag"})
+        mLayoutReflections[name] = ShaderLibrary::getInstance().getReflection(name);
 }
 
-void ke::Graphics::Renderer::createGraphicsPipeline()
+void ke::Graphics::Renderer::createGraphicsVariants(const std::vector<uint32_t>& variants, std::array<VkPipeline, VARIANT_COUNT>& uiPipelines, std::array<VkPipeline, VARIANT_COUNT>& scenePipelines)
 {
-    auto vertexCode = ke::util::readFile("./shader/bin/vert.spv");
-    auto fragCode = ke::util::readFile("./shader/bin/frag.spv");
+    util::JobCounter builds;
+    for(uint32_t variant : variants)
+        util::JobSystem::getInstance().schedule([&, variant]()
+        {
+            createGraphicsPipeline(variant, uiPipelines[variant], scenePipelines[variant]);
+        }, {"GraphicsPipeline", &builds});
+
+    util::JobSystem::getInstance().wait(builds);
+}
+
+void ke::Graphics::Renderer::createGraphicsPipeline(uint32_t variant, VkPipeline& uiPipeline, VkPipeline& scenePipeline)
+{
+    KE_PROFILE_FUNCTION();
+    ShaderLibrary& shaders = ShaderLibrary::getInstance();
+
+    auto vertexCode = shaders.getSpirv("shader.vert");
+    auto fragCode = shaders.getSpirv("shader.frag");
 
     VkShaderModule vertexModule = createShaderModule(vertexCode);
     VkShaderModule fragmentModule = createShaderModule(fragCode);
@@ -830,6 +1274,30 @@ void ke::Graphics::Renderer::createGraphicsPipeline()
     fragStageInfo.module = fragmentModule;
     fragStageInfo.pName = "main";
 
+    // Matches the constant_id declarations in shader.frag and scene.frag.
+    VkBool32 specializationData[] =
+    {
+        (variant & VARIANT_TEXTURED) ? VK_TRUE : VK_FALSE,
+        (variant & VARIANT_ALPHA_TEST) ? VK_TRUE : VK_FALSE,
+        (variant & VARIANT_SDF) ? VK_TRUE : VK_FALSE
+    };
+
+    std::array<VkSpecializationMapEntry, 3> specializationEntries{};
+    for(uint32_t i = 0; i < specializationEntries.size(); i++)
+    {
+        specializationEntries[i].constantID = i;
+        specializationEntries[i].offset = i * sizeof(VkBool32);
+        specializationEntries[i].size = sizeof(VkBool32);
+    }
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationEntries.size());
+    specializationInfo.pMapEntries = specializationEntries.data();
+    specializationInfo.dataSize = sizeof(specializationData);
+    specializationInfo.pData = specializationData;
+
+    fragStageInfo.pSpecializationInfo = &specializationInfo;
+
     VkPipelineShaderStageCreateInfo stageInfos[] = {vertStageInfo, fragStageInfo};
 
     std::vector<VkDynamicState> dynamicStates = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
@@ -900,26 +1368,8 @@ void ke::Graphics::Renderer::createGraphicsPipeline()
     depthStencil.depthTestEnable = VK_FALSE;
     depthStencil.stencilTestEnable = VK_FALSE;
 
-    VkDescriptorSetLayout dLayouts[] = {mTextureSetLayout, mDescriptorSetLayout};
-
-    VkPushConstantRange pushRange{};
-    pushRange.size = sizeof(int32_t);
-    pushRange.offset = 0;
-    pushRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    VkPipelineLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    layoutInfo.setLayoutCount = 2;
-    layoutInfo.pSetLayouts = dLayouts;
-    layoutInfo.pushConstantRangeCount = 1;
-    layoutInfo.pPushConstantRanges = &pushRange;
-    
-    if(vkCreatePipelineLayout(mDevice, &layoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS)
-        mLogger.error("Failed to create a pipeline layout!");
-
-
-    auto sceneVertexCode = ke::util::readFile("./shader/bin/scenevert.spv");
-    auto sceneFragmentCode = ke::util::readFile("./shader/bin/scenefrag.spv");
+    auto sceneVertexCode = shaders.getSpirv("scene.vert");
+    auto sceneFragmentCode = shaders.getSpirv("scene.frag");
 
     VkShaderModule sceneVertexModule = createShaderModule(sceneVertexCode);
     VkShaderModule sceneFragmentModule = createShaderModule(sceneFragmentCode);
@@ -935,6 +1385,7 @@ void ke::Graphics::Renderer::createGraphicsPipeline()
     sceneFragmentStage.module = sceneFragmentModule;
     sceneFragmentStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     sceneFragmentStage.pName = "main";
+    sceneFragmentStage.pSpecializationInfo = &specializationInfo;
 
     VkPipelineShaderStageCreateInfo sceneStages[] = {sceneVertexStage, sceneFragmentStage};
 
@@ -972,18 +1423,36 @@ void ke::Graphics::Renderer::createGraphicsPipeline()
     pipelineInfo.renderPass = mRenderPass;
     pipelineInfo.subpass = 0;
 
-    if(vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mPipeline) != VK_SUCCESS)
-        mLogger.critical("Failed to create a graphics pipeline!");
-    mLogger.info("Created UI pipeline!");
+    VkGraphicsPipelineCreateInfo scenePipelineInfo = pipelineInfo;
+    scenePipelineInfo.pStages = sceneStages;
+    scenePipelineInfo.pVertexInputState = &sceneVertexInput;
+    scenePipelineInfo.pDepthStencilState = &sceneDepthState;
+    scenePipelineInfo.renderPass = mSceneRenderPass;
 
-    pipelineInfo.pStages = sceneStages;
-    pipelineInfo.pVertexInputState = &sceneVertexInput;
-    pipelineInfo.pDepthStencilState = &sceneDepthState;
-    pipelineInfo.renderPass = mSceneRenderPass;
+    // The pipeline cache is internally synchronized, so both pipelines can compile at once.
+    VkResult uiPipelineResult = VK_NOT_READY;
+    util::JobCounter uiPipelineBuild;
+    util::JobSystem::getInstance().schedule([&]()
+    {
+        uiPipelineResult = vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &uiPipeline);
+    }, {"UIPipeline", &uiPipelineBuild});
 
-    if(vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mDisplayPipeline) != VK_SUCCESS)
+    if(vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &scenePipelineInfo, nullptr, &scenePipeline) != VK_SUCCESS)
+    {
         mLogger.critical("Failed to create a second pipeline!");
-    mLogger.info("Created scene pipeline!");
+        scenePipeline = VK_NULL_HANDLE;
+    }
+    else
+        mLogger.info("Created scene pipeline!");
+
+    util::JobSystem::getInstance().wait(uiPipelineBuild);
+    if(uiPipelineResult != VK_SUCCESS)
+    {
+        mLogger.critical("Failed to create a graphics pipeline!");
+        uiPipeline = VK_NULL_HANDLE;
+    }
+    else
+        mLogger.info("Created UI pipeline!");
 
     vkDestroyShaderModule(mDevice, vertexModule, nullptr);
     vkDestroyShaderModule(mDevice, fragmentModule, nullptr);
@@ -994,10 +1463,11 @@ void ke::Graphics::Renderer::createGraphicsPipeline()
     mLogger.info("Created graphics pipeline!");
 }
 
-void ke::Graphics::Renderer::createFontPipeline()
+void ke::Graphics::Renderer::createFontPipeline(VkPipeline& fontPipeline)
 {
-    auto vertexCode = ke::util::readFile("shader/bin/textvert.spv");
-    auto fragCode = ke::util::readFile("shader/bin/textfrag.spv");
+    KE_PROFILE_FUNCTION();
+    auto vertexCode = ShaderLibrary::getInstance().getSpirv("text.vert");
+    auto fragCode = ShaderLibrary::getInstance().getSpirv("text.frag");
     
     VkShaderModule vertexModule = createShaderModule(vertexCode);
     VkShaderModule fragModule = createShaderModule(fragCode);
@@ -1016,7 +1486,7 @@ void ke::Graphics::Renderer::createFontPipeline()
 
     VkPipelineShaderStageCreateInfo stageInfos[] = {vertexStageCreateInfo, fragmentStageCreateInfo};
 
-    std::array<VkVertexInputAttributeDescription, 4> glyphInstanceAttributeDescriptions = Text::GlyphInstance::getInputAttributeDescriptions();
+    std::array<VkVertexInputAttributeDescription, 5> glyphInstanceAttributeDescriptions = Text::GlyphInstance::getInputAttributeDescriptions();
     VkVertexInputBindingDescription glyphInstanceBindingDescription = Text::GlyphInstance::getInputBindingDescription();
 
     VkPipelineVertexInputStateCreateInfo vertexInput{};
@@ -1092,24 +1562,6 @@ void ke::Graphics::Renderer::createFontPipeline()
     dynamicState.dynamicStateCount = 2;
     dynamicState.pDynamicStates = dynamicStates;
 
-    VkDescriptorSetLayout setLayouts[] = {mFontSetLayout};
-
-    VkPushConstantRange pcRange{};
-    pcRange.offset = 0;
-    pcRange.size = sizeof(int);
-    pcRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    VkPipelineLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    layoutInfo.pushConstantRangeCount = 1;
-    layoutInfo.pPushConstantRanges = &pcRange;
-    layoutInfo.setLayoutCount = 1;
-    layoutInfo.pSetLayouts = setLayouts;
-
-    if(vkCreatePipelineLayout(mDevice, &layoutInfo, nullptr, &mFontPipelineLayout) != VK_SUCCESS)
-        mLogger.error("Failed to create font pipeline layout.");
-
-
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount = 2;
@@ -1126,8 +1578,11 @@ void ke::Graphics::Renderer::createFontPipeline()
     pipelineInfo.renderPass = mFontRenderPass;
     pipelineInfo.subpass = 0;
 
-    if(vkCreateGraphicsPipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mFontPipeline) != VK_SUCCESS)
+    if(vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, &pipelineInfo, nullptr, &fontPipeline) != VK_SUCCESS)
+    {
         mLogger.error("Failed to create font pipeline.");
+        fontPipeline = VK_NULL_HANDLE;
+    }
     
     
     
@@ -1149,6 +1604,128 @@ VkShaderModule ke::Graphics::Renderer::createShaderModule(const std::vector<char
     return shaderModule;
 }
 
+VkShaderModule ke::Graphics::Renderer::createShaderModule(const std::vector<uint32_t> &code)
+{
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size() * sizeof(uint32_t);
+    createInfo.pCode = code.data();
+    
+    VkShaderModule shaderModule;
+    if(vkCreateShaderModule(mDevice, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+        mLogger.error("Failed to create shader module!");
+
+    return shaderModule;
+}
+
+void ke::Graphics::Renderer::processShaderReloads()
+{
+    KE_PROFILE_FUNCTION();
+    destroyRetiredPipelines(false);
+
+    for(const std::string& name : ShaderLibrary::getInstance().consumeChangedShaders())
+    {
+        if(ShaderLibrary::getInstance().getReflection(name) != mLayoutReflections[name])
+        {
+            mLogger.warn("{} changed its descriptor or push constant layout, restart to apply it.", name);
+            continue;
+        }
+
+        if(name.rfind("text.", 0) == 0) mFontReloadQueued = true;
+        else mGraphicsReloadQueued = true;
+    }
+
+    if(mGraphicsReloadQueued && !mGraphicsRebuilding)
+    {
+        mGraphicsReloadQueued = false;
+        mGraphicsRebuilding = true;
+        util::JobSystem::getInstance().schedule([this]()
+        {
+            std::vector<uint32_t> variants;
+            for(uint32_t variant = 0; variant < VARIANT_COUNT; variant++)
+                if(mUIPipelines[variant] != VK_NULL_HANDLE) variants.push_back(variant);
+
+            createGraphicsVariants(variants, mPendingUIPipelines, mPendingScenePipelines);
+        }, {"GraphicsReload", &mGraphicsRebuild});
+    }
+
+    if(mFontReloadQueued && !mFontRebuilding)
+    {
+        mFontReloadQueued = false;
+        mFontRebuilding = true;
+        util::JobSystem::getInstance().schedule([this]()
+        {
+            createFontPipeline(mPendingFontPipeline);
+        }, {"FontReload", &mFontRebuild});
+    }
+
+    if(mGraphicsRebuilding && mGraphicsRebuild.isDone())
+    {
+        mGraphicsRebuilding = false;
+
+        bool complete = true;
+        for(uint32_t variant = 0; variant < VARIANT_COUNT; variant++)
+        {
+            bool wanted = mUIPipelines[variant] != VK_NULL_HANDLE;
+            if(wanted && (mPendingUIPipelines[variant] == VK_NULL_HANDLE || mPendingScenePipelines[variant] == VK_NULL_HANDLE))
+                complete = false;
+        }
+
+        for(uint32_t variant = 0; variant < VARIANT_COUNT; variant++)
+        {
+            if(complete && mPendingUIPipelines[variant] != VK_NULL_HANDLE)
+            {
+                retirePipeline(std::exchange(mUIPipelines[variant], mPendingUIPipelines[variant]));
+                retirePipeline(std::exchange(mScenePipelines[variant], mPendingScenePipelines[variant]));
+            }
+            else
+            {
+                retirePipeline(mPendingUIPipelines[variant]);
+                retirePipeline(mPendingScenePipelines[variant]);
+            }
+
+            mPendingUIPipelines[variant] = VK_NULL_HANDLE;
+            mPendingScenePipelines[variant] = VK_NULL_HANDLE;
+        }
+
+        if(complete) mLogger.info("Reloaded UI and scene pipelines.");
+    }
+
+    if(mFontRebuilding && mFontRebuild.isDone())
+    {
+        mFontRebuilding = false;
+
+        if(mPendingFontPipeline != VK_NULL_HANDLE)
+        {
+            retirePipeline(std::exchange(mFontPipeline, mPendingFontPipeline));
+            mLogger.info("Reloaded font pipeline.");
+        }
+
+        mPendingFontPipeline = VK_NULL_HANDLE;
+    }
+}
+
+void ke::Graphics::Renderer::retirePipeline(VkPipeline pipeline)
+{
+    if(pipeline == VK_NULL_HANDLE) return;
+
+    mRetiredPipelines.push_back({pipeline, mFrameCounter});
+}
+
+void ke::Graphics::Renderer::destroyRetiredPipelines(bool all)
+{
+    // A pipeline retired before frame N was recorded can only be referenced by frames older than N,
+    // and those are all finished once MAXFRAMESINFLIGHT more fences have been waited on.
+    auto it = std::remove_if(mRetiredPipelines.begin(), mRetiredPipelines.end(), [&](const RetiredPipeline& retired)
+    {
+        if(!all && mFrameCounter < retired.frame + MAXFRAMESINFLIGHT) return false;
+
+        vkDestroyPipeline(mDevice, retired.pipeline, nullptr);
+        return true;
+    });
+    mRetiredPipelines.erase(it, mRetiredPipelines.end());
+}
+
 void ke::Graphics::Renderer::createRenderPass()
 {
     VkAttachmentDescription colorAttachment{};
@@ -1159,7 +1736,7 @@ void ke::Graphics::Renderer::createRenderPass()
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = mBackbufferLayout;
 
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = findDepthFormat();
@@ -1217,8 +1794,8 @@ void ke::Graphics::Renderer::createFontRenderPass()
     colorAtt.samples = VK_SAMPLE_COUNT_1_BIT;
     colorAtt.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
     colorAtt.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAtt.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    colorAtt.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAtt.initialLayout = mBackbufferLayout;
+    colorAtt.finalLayout = mBackbufferLayout;
 
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = findDepthFormat();
@@ -1277,8 +1854,8 @@ void ke::Graphics::Renderer::createSceneRenderPass()
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.initialLayout = mBackbufferLayout;
+    colorAttachment.finalLayout = mBackbufferLayout;
 
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = findDepthFormat();
@@ -1412,6 +1989,16 @@ void ke::Graphics::Renderer::createSyncObjects()
     mLogger.info("Created sync objects.");
 }
 
+uint32_t ke::Graphics::Renderer::beginGpuZone(const std::string& name)
+{
+    return mGpuProfiler.beginZone(mCommandBuffers[currentFrameInFlight], name);
+}
+
+void ke::Graphics::Renderer::endGpuZone(uint32_t zone)
+{
+    mGpuProfiler.endZone(mCommandBuffers[currentFrameInFlight], zone);
+}
+
 void ke::Graphics::Renderer::beginRecording(VkCommandBuffer buffer)
 {
     VkCommandBufferBeginInfo beginInfo{};
@@ -1420,41 +2007,15 @@ void ke::Graphics::Renderer::beginRecording(VkCommandBuffer buffer)
     if(vkBeginCommandBuffer(buffer, &beginInfo) != VK_SUCCESS)
         mLogger.error("Failed to begin recording command buffer!");
 
-    VkRenderPassBeginInfo renderBegin{};
-    renderBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderBegin.renderPass = mRenderPass;
-    renderBegin.framebuffer = mSwapchainFramebuffers[currentImageIndex];
-    renderBegin.renderArea.offset = {0,0};
-    renderBegin.renderArea.extent = mSwapchainExtent;
-
-    std::array<VkClearValue, 2> clearValues{};
-    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-    clearValues[1].depthStencil = {1.0f, 0};
-
-    renderBegin.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderBegin.pClearValues = clearValues.data();
-
-    vkCmdBeginRenderPass(buffer, &renderBegin, VK_SUBPASS_CONTENTS_INLINE);
-
-    vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
-
-    VkViewport viewport{};
-    viewport.height = mSwapchainExtent.height;
-    viewport.width = mSwapchainExtent.width;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    vkCmdSetViewport(buffer, 0, 1, &viewport);
+    mGpuProfiler.beginFrame(buffer, currentFrameInFlight);
 
-    VkRect2D scissor{};
-    scissor.extent = mSwapchainExtent;
-    scissor.offset = {0, 0};
-    vkCmdSetScissor(buffer, 0, 1, &scissor);
+    mBoundPipeline = VK_NULL_HANDLE;
 }
 
 void ke::Graphics::Renderer::endRecording(VkCommandBuffer buffer)
 {
+    mGpuProfiler.endFrame(buffer);
+
     if(vkEndCommandBuffer(buffer) != VK_SUCCESS)
         mLogger.error("Failed to record command buffer!");
 }
@@ -1496,6 +2057,22 @@ void ke::Graphics::Renderer::transitionImageLayout(VkImage image, VkFormat forma
         srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
         dstStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
     }
+    else if(srcLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && dstLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+        srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    else if(srcLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && dstLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+    {
+        barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        srcStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
     else mLogger.warn("Unsupported layout transition requested.");
 
     vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
@@ -1541,13 +2118,15 @@ VkCommandBuffer ke::Graphics::Renderer::beginSingleTimeCommands()
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
     vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    mGpuProfiler.beginUpload(commandBuffer);
 
     return commandBuffer;
 }
 
 void ke::Graphics::Renderer::endSingleTimeCommands(VkCommandBuffer commandBuffer)
 {
-   vkEndCommandBuffer(commandBuffer);
+    mGpuProfiler.endUpload(commandBuffer);
+    vkEndCommandBuffer(commandBuffer);
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1556,6 +2135,7 @@ void ke::Graphics::Renderer::endSingleTimeCommands(VkCommandBuffer commandBuffer
 
     vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
     vkQueueWaitIdle(mGraphicsQueue);
+    mGpuProfiler.resolveUpload();
 
     vkFreeCommandBuffers(mDevice, mCommandPool, 1, &commandBuffer);
 }
@@ -1581,27 +2161,6 @@ void ke::Graphics::Renderer::createIndexBuffer(const std::vector<uint32_t>& indi
     vkFreeMemory(mDevice, stagingBufferMemory, nullptr);
 }
 
-void ke::Graphics::Renderer::createGlyphInstanceBuffer(const std::vector<Text::GlyphInstance> &instances, VkBuffer &targetBuffer, VkDeviceMemory &targetMemory)
-{
-    VkDeviceSize size = sizeof(instances[0]) * instances.size();
-
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(mDevice, stagingBufferMemory, 0, size, 0, &data);
-        memcpy(data, instances.data(), size);
-    vkUnmapMemory(mDevice, stagingBufferMemory);
-
-    createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, targetBuffer, targetMemory);
-
-    copyBuffer(stagingBuffer, targetBuffer, size);
-
-    vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
-    vkFreeMemory(mDevice, stagingBufferMemory, nullptr);
-}
-
 void ke::Graphics::Renderer::endRenderPass()
 {
     vkCmdEndRenderPass(mCommandBuffers[currentFrameInFlight]);
@@ -1609,7 +2168,25 @@ void ke::Graphics::Renderer::endRenderPass()
 
 void ke::Graphics::Renderer::bindUIPipeline(VkCommandBuffer buffer)
 {
-    vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline);
+    VkRenderPassBeginInfo renderBegin{};
+    renderBegin.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderBegin.renderPass = mRenderPass;
+    renderBegin.framebuffer = mSwapchainFramebuffers[currentImageIndex];
+    renderBegin.renderArea.offset = {0,0};
+    renderBegin.renderArea.extent = mSwapchainExtent;
+
+    std::array<VkClearValue, 2> clearValues{};
+    clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    clearValues[1].depthStencil = {1.0f, 0};
+
+    renderBegin.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderBegin.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass(buffer, &renderBegin, VK_SUBPASS_CONTENTS_INLINE);
+
+    pActiveVariants = &mUIPipelines;
+    mBoundPipeline = VK_NULL_HANDLE;
+    bindVariant(VARIANT_NONE);
 
     vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 1,1, &mUIDescriptorSets[currentFrameInFlight], 0, nullptr);
 
@@ -1647,7 +2224,9 @@ void ke::Graphics::Renderer::bindScenePipeline(VkCommandBuffer buffer, const VkV
     
     vkCmdBeginRenderPass(buffer, &renderBegin, VK_SUBPASS_CONTENTS_INLINE);
 
-    vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mDisplayPipeline);
+    pActiveVariants = &mScenePipelines;
+    mBoundPipeline = VK_NULL_HANDLE;
+    bindVariant(VARIANT_NONE);
     vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout, 1, 1, &mSceneDescriptorSets[currentFrameInFlight], 0, nullptr);
 
     vkCmdSetViewport(buffer, 0, 1, &viewport);
@@ -1673,6 +2252,7 @@ void ke::Graphics::Renderer::bindFontPipeline(VkCommandBuffer buffer)
     vkCmdBeginRenderPass(buffer, &renderBegin, VK_SUBPASS_CONTENTS_INLINE);
 
     vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mFontPipeline);
+    mDrawCounters.pipelineBinds++;
     vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mFontPipelineLayout, 0, 1, &mFontDescriptorSet, 0, nullptr);
 
     VkViewport viewport{};
@@ -1691,14 +2271,30 @@ void ke::Graphics::Renderer::bindFontPipeline(VkCommandBuffer buffer)
     vkCmdSetScissor(buffer, 0, 1, &scissor);
 }
 
-void ke::Graphics::Renderer::pickTextureIndex(int32_t index) const
+void ke::Graphics::Renderer::bindVariant(uint32_t variant)
 {
-    vkCmdPushConstants(mCommandBuffers[currentFrameInFlight], mPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(int32_t), &index);
+    VkPipeline& pipeline = (*pActiveVariants)[variant];
+
+    if(pipeline == VK_NULL_HANDLE)
+    {
+        // Not prebuilt, compile it now. This stalls the frame once, later binds hit the cache.
+        mLogger.warn("Building pipeline variant {} on first use.", variant);
+        createGraphicsPipeline(variant, mUIPipelines[variant], mScenePipelines[variant]);
+        if(pipeline == VK_NULL_HANDLE) return;
+    }
+
+    if(pipeline == mBoundPipeline) return;
+
+    vkCmdBindPipeline(mCommandBuffers[currentFrameInFlight], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    mBoundPipeline = pipeline;
+    mDrawCounters.pipelineBinds++;
 }
 
-void ke::Graphics::Renderer::pickFontIndex(int32_t index) const
+void ke::Graphics::Renderer::pickTextureIndex(int32_t index)
 {
-    vkCmdPushConstants(mCommandBuffers[currentFrameInFlight], mFontPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(int32_t), &index);
+    bindVariant(index >= 0 ? VARIANT_TEXTURED : VARIANT_NONE);
+
+    vkCmdPushConstants(mCommandBuffers[currentFrameInFlight], mPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(int32_t), &index);
 }
 
 void ke::Graphics::Renderer::drawBuffersIndexed(const util::Buffer& vertexBuffer, const util::Buffer& indexBuffer, uint32_t indexCount) const
@@ -1714,16 +2310,17 @@ void ke::Graphics::Renderer::drawBuffersIndexed(const util::Buffer& vertexBuffer
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.buffer, offsets);
 
     vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+    countDrawCall(2);
 }
 
-void ke::Graphics::Renderer::drawText(const util::Buffer& instanceBuffer, uint32_t instanceCount) const
+void ke::Graphics::Renderer::queueText(const Text::GlyphInstance* instances, uint32_t count)
 {
-    VkCommandBuffer commandBuffer = mCommandBuffers[currentFrameInFlight];
-
-    VkDeviceSize offsets[] = {0};
+    mTextBatcher.add(instances, count);
+}
 
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &instanceBuffer.buffer, offsets);
-    vkCmdDraw(commandBuffer, 6, instanceCount, 0, 0);
+void ke::Graphics::Renderer::drawQueuedText()
+{
+    if(mTextBatcher.record(mCommandBuffers[currentFrameInFlight])) countDrawCall(1);
 }
 
 VkDevice ke::Graphics::Renderer::getDevice() const
@@ -1731,19 +2328,27 @@ VkDevice ke::Graphics::Renderer::getDevice() const
     return mDevice;
 }
 
-uint32_t ke::Graphics::Renderer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+VkPhysicalDevice ke::Graphics::Renderer::getPhysicalDevice() const
 {
-    VkPhysicalDeviceMemoryProperties memProp;
-    vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &memProp);
+    return mPhysicalDevice;
+}
 
-    for(uint32_t i = 0; i < memProp.memoryTypeCount; i++)
-    {
-        if((typeFilter & (1 << i)) && (memProp.memoryTypes[i].propertyFlags & properties) == properties)
-            return i;
-    }
+VkImage ke::Graphics::Renderer::getCurrentSwapchainImage() const
+{
+    return mSwapchainImages[currentImageIndex];
+}
+
+VkImage ke::Graphics::Renderer::getDepthImage() const
+{
+    return mDepthImage.image;
+}
+
+uint32_t ke::Graphics::Renderer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+{
+    uint32_t memoryType = util::findMemoryType(mPhysicalDevice, typeFilter, properties);
+    if(memoryType == UINT32_MAX) mLogger.error("Failed to find suitable memory type!");
 
-    mLogger.error("Failed to find suitable memory type!");
-    return -1;
+    return memoryType;
 }
 
 void ke::Graphics::Renderer::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer &buffer, VkDeviceMemory &bufferMemory)
@@ -1952,80 +2557,91 @@ void ke::Graphics::Renderer::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer,
 
 void ke::Graphics::Renderer::createDescriptorSetLayout()
 {
-    VkDescriptorSetLayoutBinding uboLayoutBinding{};
-    uboLayoutBinding.binding = 0;
-    uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uboLayoutBinding.descriptorCount = 1;
-    uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    uboLayoutBinding.pImmutableSamplers = nullptr;
-
+    mDescriptorSetLayout = createReflectedSetLayout({"shader.vert", "shader.frag", "scene.vert", "scene.frag"}, 1, 0);
+    mTextureSetLayout = createReflectedSetLayout({"shader.vert", "shader.frag", "scene.vert", "scene.frag"}, 0, 4096);
+    mFontSetLayout = createReflectedSetLayout({"text.vert", "text.frag"}, 0, 64);
     
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings = &uboLayoutBinding;
+    mLogger.info("Created descriptor set layout.");
+}
 
-    if(vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mDescriptorSetLayout) != VK_SUCCESS)
-        mLogger.error("Failed to create descriptor set layout.");
+VkDescriptorSetLayout ke::Graphics::Renderer::createReflectedSetLayout(const std::vector<std::string>& shaders, uint32_t set, uint32_t runtimeArraySize)
+{
+    std::map<uint32_t, VkDescriptorSetLayoutBinding> merged;
+    std::map<uint32_t, VkDescriptorBindingFlags> mergedFlags;
 
+    for(const std::string& name : shaders)
+    {
+        for(const ReflectedBinding& reflected : ShaderLibrary::getInstance().getReflection(name).bindings)
+        {
+            if(reflected.set != set) continue;
 
-    VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-    samplerLayoutBinding.binding = 0;
-    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.descriptorCount = 4096;
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    samplerLayoutBinding.pImmutableSamplers = nullptr;
+            auto [it, inserted] = merged.try_emplace(reflected.binding);
+            VkDescriptorSetLayoutBinding& binding = it->second;
+
+            if(inserted)
+            {
+                binding.binding = reflected.binding;
+                binding.descriptorType = reflected.type;
+                binding.descriptorCount = reflected.count ? reflected.count : runtimeArraySize;
+                binding.pImmutableSamplers = nullptr;
+                mergedFlags[reflected.binding] = reflected.count ? 0 : VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+            }
+            else if(binding.descriptorType != reflected.type)
+                mLogger.error("{} disagrees on the type of set {} binding {}!", name, set, reflected.binding);
+
+            binding.stageFlags |= reflected.stages;
+        }
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    std::vector<VkDescriptorBindingFlags> bindingFlags;
+    bool updateAfterBind = false;
+
+    for(auto& [index, binding] : merged)
+    {
+        bindings.push_back(binding);
+        bindingFlags.push_back(mergedFlags[index]);
+        updateAfterBind |= mergedFlags[index] != 0;
+    }
+
+    // Only the highest binding of a set may have a variable count.
+    if(!bindingFlags.empty() && bindingFlags.back() != 0)
+        bindingFlags.back() |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
 
-    VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
     VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
     flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-    flagsInfo.bindingCount = 1;
-    flagsInfo.pBindingFlags = &bindingFlags;
-
-    VkDescriptorSetLayoutCreateInfo layoutInfo2{};
-    layoutInfo2.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo2.pNext = &flagsInfo;
-    layoutInfo2.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
-    layoutInfo2.bindingCount = 1;
-    layoutInfo2.pBindings = &samplerLayoutBinding;
-
-    if(vkCreateDescriptorSetLayout(mDevice, &layoutInfo2, nullptr, &mTextureSetLayout) != VK_SUCCESS)
-        mLogger.error("Failed to create texture set layout.");
-
-    VkDescriptorBindingFlags fontBindingFlags[] = {VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT, 0};
-
-    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo2{};
-    flagsInfo2.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-    flagsInfo2.bindingCount = 2;
-    flagsInfo2.pBindingFlags = fontBindingFlags;
-
-    VkDescriptorSetLayoutBinding fontSamplerLayoutBinding{};
-    fontSamplerLayoutBinding.binding = 1;
-    fontSamplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    fontSamplerLayoutBinding.descriptorCount = 64;
-    fontSamplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fontSamplerLayoutBinding.pImmutableSamplers = nullptr;
-
-    VkDescriptorSetLayoutBinding fontResolutionLayoutBinding{};
-    fontResolutionLayoutBinding.binding = 0;
-    fontResolutionLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    fontResolutionLayoutBinding.descriptorCount = 1;
-    fontResolutionLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    fontResolutionLayoutBinding.pImmutableSamplers = nullptr;
-
-    VkDescriptorSetLayoutBinding bindings[] = {fontSamplerLayoutBinding, fontResolutionLayoutBinding};
-
-    VkDescriptorSetLayoutCreateInfo layoutInfo3{};
-    layoutInfo3.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo3.pNext = &flagsInfo2;
-    layoutInfo3.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
-    layoutInfo3.bindingCount = 2;
-    layoutInfo3.pBindings = bindings;
-
-    if(vkCreateDescriptorSetLayout(mDevice, &layoutInfo3, nullptr, &mFontSetLayout) != VK_SUCCESS)
-        mLogger.error("Failed to create font set layout.");
-    
-    mLogger.info("Created descriptor set layout.");
+    flagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+    flagsInfo.pBindingFlags = bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = updateAfterBind ? &flagsInfo : nullptr;
+    layoutInfo.flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if(vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+        mLogger.error("Failed to create set layout {} from reflection.", set);
+
+    return layout;
+}
+
+VkPushConstantRange ke::Graphics::Renderer::reflectPushConstantRange(const std::vector<std::string>& shaders)
+{
+    VkPushConstantRange range{};
+    range.offset = 0;
+
+    for(const std::string& name : shaders)
+    {
+        ShaderReflection reflection = ShaderLibrary::getInstance().getReflection(name);
+        if(reflection.pushConstantSize == 0) continue;
+
+        range.size = std::max(range.size, reflection.pushConstantSize);
+        range.stageFlags |= reflection.stage;
+    }
+
+    return range;
 }
 
 void ke::Graphics::Renderer::createUniformBuffers()
@@ -2083,7 +2699,8 @@ void ke::Graphics::Renderer::createDescriptorPool()
 
 void ke::Graphics::Renderer::createDescriptorSets()
 {
-    std::vector<VkDescriptorSetLayout> layouts(MAXFRAMESINFLIGHT, mDescriptorSetLayout);
+    std::array<VkDescriptorSetLayout, MAXFRAMESINFLIGHT> layouts;
+    layouts.fill(mDescriptorSetLayout);
 
     VkDescriptorSetAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -2341,11 +2958,16 @@ VkResult ke::Graphics::Renderer::CreateDebugUtilsMessenger(VkInstance instance,
 
 std::vector<const char *> ke::Graphics::Renderer::getRequiredExtensions()
 {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char*> extensions;
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    if(!mHeadless)
+    {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if(enableValidationLayers)
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
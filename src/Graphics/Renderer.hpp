@@ -15,17 +15,52 @@
 #include "../Utility/RenderUtil.hpp"
 #include "../Utility/structs.hpp"
 #include "TextUtilities.hpp"
+#include "ShaderLibrary.hpp"
+#include "GpuProfiler.hpp"
+#include "FrameCapture.hpp"
+#include "TextBatcher.hpp"
+#include "../Utility/JobSystem.hpp"
 
 namespace ke
 {
     namespace Graphics
     {
+        // Commands recorded in one frame, for checking how well drawing batches.
+        struct DrawCounters
+        {
+            uint32_t drawCalls = 0;
+            uint32_t pipelineBinds = 0;
+            uint32_t bufferBinds = 0;
+        };
+
+        // Feature toggles baked into the UI/scene fragment shaders through specialization constants.
+        enum PipelineVariantFlags : uint32_t
+        {
+            VARIANT_NONE = 0,
+            VARIANT_TEXTURED = 1 << 0,
+            VARIANT_ALPHA_TEST = 1 << 1,
+            VARIANT_SDF = 1 << 2,
+            VARIANT_COUNT = 1 << 3
+        };
+
+        enum class PresentMode
+        {
+            Fifo,
+            FifoRelaxed,
+            Mailbox,
+            Immediate
+        };
+
         class Renderer
         {
         public:
             static Renderer& getInstance();
             
             void init(GLFWwindow* window);
+            // init split in two for the startup graph: everything but pipelines, then the pipelines. Both need the
+            // shader library loaded, the set layouts come from its reflection. Pipelines may build on a job worker.
+            void initDevice(GLFWwindow* window);
+            void initPipelines();
             void terminate();
 
             void readyCanvas(GLFWwindow* window);
@@ -37,16 +72,45 @@ namespace ke
 
             glm::ivec2 getSwapchainDimensions() const;
 
+            util::DecodedImage decodeTextureImage(const std::string& filepath) const;
+            void createTextureImage(const util::DecodedImage& decoded, util::Image& image);
             void createTextureImage(const std::string& filepath, util::Image& image);
             void createTextureImageView(util::Image& image);
             uint32_t addTextureToDescriptor(const util::Image& image);
 
-            void createFontImage(const std::unordered_map<uint32_t, ke::Graphics::Text::GlyphInfo>& glyphs, const unsigned int ATLAS_SIZE, VkImage& fontImage, VkDeviceMemory& fontImageMemory);
-            void createFontImageView(util::Image& image);
+            void createFontImage(const uint8_t* atlasPixels, uint32_t width, uint32_t height, VkFormat format, VkImage& fontImage, VkDeviceMemory& fontImageMemory);
+            // Writes the given regions into a font page that is already in use, pixels outside them are kept.
+            void updateFontImage(VkImage fontImage, VkFormat format, const std::vector<Text::AtlasUpload>& regions);
+            // Replaces a font page with a taller one holding the same texels, under the same descriptor index.
+            void growFontImage(util::Image& image, VkFormat format, uint32_t width, uint32_t oldHeight, uint32_t newHeight, uint32_t descriptorIndex);
+            void createFontImageView(util::Image& image, VkFormat format);
             uint32_t addFontToDescriptor(const util::Image& image);
 
             void signalWindowResize();
 
+            // Renders into offscreen images instead of a swapchain, window may be null. Call before init.
+            void setHeadless(uint32_t width, uint32_t height);
+            bool isHeadless() const {return mHeadless;}
+            VkImageLayout getBackbufferLayout() const {return mBackbufferLayout;}
+            void requestFrameCapture(const std::string& path);
+
+            // Per-frame resources are allocated for the upper bound, setFramesInFlight picks how many rotate.
+            static constexpr int MAXFRAMESINFLIGHT = 4;
+            void setFramesInFlight(uint32_t count);
+            uint32_t getFramesInFlight() const {return mFramesInFlight;}
+            uint32_t getCurrentFrameInFlight() const {return currentFrameInFlight;}
+            void setPresentMode(PresentMode mode);
+
+            float getLastGpuTime() const {return mGpuProfiler.getLast(GpuProfiler::FRAME_ZONE);}
+            float getLastFenceWait() const {return mLastFenceWait;}
+            // Counts for the last finished frame, anything recording draws directly reports them through countDrawCall.
+            const DrawCounters& getLastDrawCounters() const {return mLastDrawCounters;}
+            void countDrawCall(uint32_t bufferBinds = 0) const {mDrawCounters.drawCalls++; mDrawCounters.bufferBinds += bufferBinds;}
+
+            uint32_t beginGpuZone(const std::string& name);
+            void endGpuZone(uint32_t zone);
+            const GpuProfiler& getGpuProfiler() const {return mGpuProfiler;}
+
             template<typename T>
             void createVertexBuffer(const std::vector<T>& vertices, VkBuffer& targetBuffer, VkDeviceMemory& targetMemory)
             {
@@ -73,7 +137,6 @@ namespace ke
             }
 
             void createIndexBuffer(const std::vector<uint32_t>& indices, VkBuffer& targetBuffer, VkDeviceMemory& targetMemory);
-            void createGlyphInstanceBuffer(const std::vector<Text::GlyphInstance>& instances, VkBuffer& targetBuffer, VkDeviceMemory& targetMemory);
 
             void endRenderPass();
 
@@ -81,12 +144,17 @@ namespace ke
             void bindScenePipeline(VkCommandBuffer buffer, const VkViewport& viewport, const VkRect2D& scissor);
             void bindFontPipeline(VkCommandBuffer buffer);
 
-            void pickTextureIndex(int32_t index) const;
-            void pickFontIndex(int32_t index) const;
+            void bindVariant(uint32_t variant);
+            void pickTextureIndex(int32_t index);
             void drawBuffersIndexed(const util::Buffer& vertexBuffer, const util::Buffer& indexBuffer, uint32_t indexCount) const;
-            void drawText(const util::Buffer& instanceBuffer, uint32_t instanceCount) const;
+            // Glyphs are copied into this frame's text buffer and drawn together by drawQueuedText.
+            void queueText(const Text::GlyphInstance* instances, uint32_t count);
+            void drawQueuedText();
             
             VkDevice getDevice() const;
+            VkPhysicalDevice getPhysicalDevice() const;
+            VkImage getCurrentSwapchainImage() const;
+            VkImage getDepthImage() const;
 
             VkCommandBuffer getCurrentCommandBuffer();
         private:
@@ -108,10 +176,21 @@ namespace ke
             void createSwapchainImageViews();
             void recreateSwapchain(GLFWwindow* window);
             void cleanupSwapchain();
-
-            void createGraphicsPipeline();
-            void createFontPipeline();
+            void createOffscreenTargets();
+
+            void createPipelineCache();
+            void savePipelineCache();
+            void createPipelineLayouts();
+            void createGraphicsPipeline(uint32_t variant, VkPipeline& uiPipeline, VkPipeline& scenePipeline);
+            void createGraphicsVariants(const std::vector<uint32_t>& variants, std::array<VkPipeline, VARIANT_COUNT>& uiPipelines, std::array<VkPipeline, VARIANT_COUNT>& scenePipelines);
+            void createFontPipeline(VkPipeline& fontPipeline);
             VkShaderModule createShaderModule(const std::vector<char>& code);
+            VkShaderModule createShaderModule(const std::vector<uint32_t>& code);
+
+            void processShaderReloads();
+            void retirePipeline(VkPipeline pipeline);
+            void destroyRetiredPipelines(bool all);
+
             void createRenderPass();
             void createFontRenderPass();
             void createSceneRenderPass();
@@ -140,6 +219,8 @@ namespace ke
             void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
             
             void createDescriptorSetLayout();
+            VkDescriptorSetLayout createReflectedSetLayout(const std::vector<std::string>& shaders, uint32_t set, uint32_t runtimeArraySize);
+            VkPushConstantRange reflectPushConstantRange(const std::vector<std::string>& shaders);
             void createUniformBuffers();
             void createDescriptorPool();
             void createDescriptorSets();
@@ -151,6 +232,7 @@ namespace ke
 
             void createTextureSampler();
             void createFontSampler();
+            void writeFontDescriptor(uint32_t index, const util::Image& image);
 
             //DEBUG
             bool checkValidationLayerSupport();
@@ -177,19 +259,52 @@ namespace ke
             VkExtent2D mSwapchainExtent;
             std::vector<VkImageView> mSwapchainImageViews;
 
+            bool mHeadless = false;
+            VkImageLayout mBackbufferLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            std::vector<VkDeviceMemory> mOffscreenMemory;
+            FrameCapture mFrameCapture;
+            TextBatcher mTextBatcher;
+            std::string mPendingCapturePath;
+
             VkPipelineLayout mPipelineLayout;
             VkPipelineLayout mFontPipelineLayout;
 
-            VkPipeline mPipeline;
+            std::array<VkPipeline, VARIANT_COUNT> mUIPipelines{};
+            std::array<VkPipeline, VARIANT_COUNT> mScenePipelines{};
+            std::array<VkPipeline, VARIANT_COUNT>* pActiveVariants = &mUIPipelines;
+            VkPipeline mBoundPipeline = VK_NULL_HANDLE;
             VkPipeline mFontPipeline;
 
             VkRenderPass mRenderPass;
             VkRenderPass mSceneRenderPass;
             VkRenderPass mFontRenderPass;
 
-            VkPipeline mDisplayPipeline;
             VkPipeline mDisplayFontPipeline;
 
+            VkPipelineCache mPipelineCache = VK_NULL_HANDLE;
+            bool mPipelineCacheWarm = false;
+
+            // Hot reload: pipelines are rebuilt off-thread and swapped in at the start of a frame,
+            // the replaced ones live until every frame that could have recorded them has retired.
+            struct RetiredPipeline
+            {
+                VkPipeline pipeline;
+                uint64_t frame;
+            };
+
+            std::unordered_map<std::string, ShaderReflection> mLayoutReflections;
+            std::vector<RetiredPipeline> mRetiredPipelines;
+            util::JobCounter mGraphicsRebuild;
+            util::JobCounter mFontRebuild;
+            bool mGraphicsRebuilding = false;
+            bool mFontRebuilding = false;
+            std::array<VkPipeline, VARIANT_COUNT> mPendingUIPipelines{};
+            std::array<VkPipeline, VARIANT_COUNT> mPendingScenePipelines{};
+            VkPipeline mPendingFontPipeline = VK_NULL_HANDLE;
+            bool mGraphicsReloadQueued = false;
+            bool mFontReloadQueued = false;
+            uint64_t mFrameCounter = 0;
+
             VkCommandPool mCommandPool;
             std::vector<VkCommandBuffer> mCommandBuffers;
 
@@ -233,8 +348,16 @@ namespace ke
             VkSampler mTextureSampler;
             VkSampler mFontSampler;
 
-            const int MAXFRAMESINFLIGHT = 2;
+            uint32_t mFramesInFlight = 2;
             uint32_t currentFrameInFlight = 0;
+
+            PresentMode mPresentMode = PresentMode::Mailbox;
+
+            GpuProfiler mGpuProfiler;
+            bool mPipelineStatisticsSupported = false;
+            float mLastFenceWait = 0.0f;
+            mutable DrawCounters mDrawCounters;
+            DrawCounters mLastDrawCounters;
             uint32_t currentImageIndex = 0;
             bool framebufferResized = false;
         };
@@ -0,0 +1,428 @@
+#include "ShaderLibrary.hpp"
+#include "../Utility/FileCache.hpp"
+#include "../Utility/RenderUtil.hpp"
+#include "../Utility/JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    // SPIR-V opcodes and enums used by the reflector, see the SPIR-V specification, chapter 3.
+    enum SpvOp : uint32_t
+    {
+        OpEntryPoint = 15, OpTypeBool = 20, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23,
+        OpTypeMatrix = 24, OpTypeImage = 25, OpTypeSampler = 26, OpTypeSampledImage = 27,
+        OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30, OpTypePointer = 32,
+        OpConstant = 43, OpVariable = 59, OpDecorate = 71, OpMemberDecorate = 72
+    };
+
+    enum SpvDecoration : uint32_t
+    {
+        DecorationBlock = 2, DecorationBufferBlock = 3, DecorationArrayStride = 6,
+        DecorationMatrixStride = 7, DecorationBinding = 33, DecorationDescriptorSet = 34, DecorationOffset = 35
+    };
+
+    enum SpvStorageClass : uint32_t
+    {
+        StorageUniformConstant = 0, StorageUniform = 2, StoragePushConstant = 9, StorageStorageBuffer = 12
+    };
+
+    struct SpvId
+    {
+        uint32_t opcode = 0;
+        std::vector<uint32_t> operands;
+
+        uint32_t set = UINT32_MAX;
+        uint32_t binding = UINT32_MAX;
+        uint32_t arrayStride = 0;
+        bool block = false;
+        bool bufferBlock = false;
+
+        std::vector<uint32_t> memberOffsets;
+        std::vector<uint32_t> memberMatrixStrides;
+    };
+
+    uint32_t typeSize(const std::vector<SpvId>& ids, uint32_t typeId, uint32_t matrixStride = 0)
+    {
+        const SpvId& type = ids[typeId];
+
+        switch(type.opcode)
+        {
+        case OpTypeBool:
+            return 4;
+        case OpTypeInt:
+        case OpTypeFloat:
+            return type.operands[1] / 8;
+        case OpTypeVector:
+            return type.operands[2] * typeSize(ids, type.operands[1]);
+        case OpTypeMatrix:
+        {
+            uint32_t columnSize = matrixStride ? matrixStride : typeSize(ids, type.operands[1]);
+            return type.operands[2] * columnSize;
+        }
+        case OpTypeArray:
+        {
+            uint32_t length = ids[type.operands[2]].operands.size() > 2 ? ids[type.operands[2]].operands[2] : 0;
+            uint32_t stride = type.arrayStride ? type.arrayStride : typeSize(ids, type.operands[1]);
+            return length * stride;
+        }
+        case OpTypeStruct:
+        {
+            uint32_t size = 0;
+            for(size_t m = 1; m < type.operands.size(); m++)
+            {
+                uint32_t offset = m - 1 < type.memberOffsets.size() ? type.memberOffsets[m - 1] : 0;
+                uint32_t stride = m - 1 < type.memberMatrixStrides.size() ? type.memberMatrixStrides[m - 1] : 0;
+                size = std::max(size, offset + typeSize(ids, type.operands[m], stride));
+            }
+            return size;
+        }
+        default:
+            return 0;
+        }
+    }
+
+    VkShaderStageFlagBits executionModelToStage(uint32_t model)
+    {
+        switch(model)
+        {
+        case 0: return VK_SHADER_STAGE_VERTEX_BIT;
+        case 1: return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case 2: return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case 3: return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case 4: return VK_SHADER_STAGE_FRAGMENT_BIT;
+        case 5: return VK_SHADER_STAGE_COMPUTE_BIT;
+        default: return VK_SHADER_STAGE_ALL;
+        }
+    }
+
+    std::string glslcPath()
+    {
+        if(const char* sdk = std::getenv("VULKANSDK"); sdk && *sdk)
+            return std::string(sdk) + "/x86_64/bin/glslc";
+        return "glslc";
+    }
+}
+
+void ke::Graphics::ShaderLibrary::init()
+{
+    const char* shaders[][3] =
+    {
+        {"shader.vert", "shader/shader.vert", "shader/bin/vert.spv"},
+        {"shader.frag", "shader/shader.frag", "shader/bin/frag.spv"},
+        {"scene.vert", "shader/scene.vert", "shader/bin/scenevert.spv"},
+        {"scene.frag", "shader/scene.frag", "shader/bin/scenefrag.spv"},
+        {"text.vert", "shader/text.vert", "shader/bin/textvert.spv"},
+        {"text.frag", "shader/text.frag", "shader/bin/textfrag.spv"}
+    };
+
+    // A cold cache means one compiler process per shader, run them side by side.
+    util::JobCounter registrations;
+    for(auto& shader : shaders)
+        util::JobSystem::getInstance().schedule([this, &shader]()
+        {
+            registerShader(shader[0], shader[1], shader[2]);
+        }, {"RegisterShader", &registrations});
+
+    util::JobSystem::getInstance().wait(registrations);
+
+    mLogger.info("Loaded shader library.");
+}
+
+void ke::Graphics::ShaderLibrary::terminate()
+{
+    if(mWatching.exchange(false))
+    {
+        mWatchSignal.notify_all();
+        mWatcher.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mShaders.clear();
+    mChangedShaders.clear();
+}
+
+std::vector<uint32_t> ke::Graphics::ShaderLibrary::getSpirv(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mShaders.at(name).spirv;
+}
+
+ke::Graphics::ShaderReflection ke::Graphics::ShaderLibrary::getReflection(const std::string &name) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mShaders.at(name).reflection;
+}
+
+void ke::Graphics::ShaderLibrary::startWatching()
+{
+    if(mWatching.exchange(true)) return;
+
+    mWatcher = std::thread(&ShaderLibrary::watch, this);
+    mLogger.info("Watching shader sources for changes.");
+}
+
+std::vector<std::string> ke::Graphics::ShaderLibrary::consumeChangedShaders()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return std::exchange(mChangedShaders, {});
+}
+
+void ke::Graphics::ShaderLibrary::registerShader(const std::string &name, const std::filesystem::path &sourcePath, const std::filesystem::path &fallbackPath)
+{
+    ShaderEntry entry{};
+    entry.sourcePath = sourcePath;
+    entry.fallbackPath = fallbackPath;
+
+    std::error_code ec;
+    entry.lastWrite = std::filesystem::last_write_time(sourcePath, ec);
+
+    if(!compile(sourcePath, entry.spirv))
+    {
+        // No compiler around, use whatever compileshaders.sh produced last.
+        std::vector<char> code = util::readFile(fallbackPath.string());
+        entry.spirv.resize(code.size() / sizeof(uint32_t));
+        memcpy(entry.spirv.data(), code.data(), entry.spirv.size() * sizeof(uint32_t));
+        mLogger.warn("Using precompiled SPIR-V for {}.", name);
+    }
+
+    entry.reflection = reflect(entry.spirv);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mShaders[name] = std::move(entry);
+}
+
+bool ke::Graphics::ShaderLibrary::compile(const std::filesystem::path &sourcePath, std::vector<uint32_t> &spirv)
+{
+    std::vector<char> source;
+    if(!util::readCacheFile(sourcePath, source))
+    {
+        mLogger.error("Failed to read shader source {}!", sourcePath.string());
+        return false;
+    }
+
+    // glslc picks the stage from the extension, so it is part of the key as well.
+    std::string extension = sourcePath.extension().string();
+    uint64_t hash = util::hashBytes(source.data(), source.size());
+    hash = util::hashBytes(extension.data(), extension.size(), hash);
+
+    std::filesystem::path cacheDir = util::getCacheDirectory() / "shaders";
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    std::filesystem::path cachedPath = cacheDir / fmt::format("{:016x}.spv", hash);
+
+    std::vector<char> code;
+    if(!util::readCacheFile(cachedPath, code))
+    {
+        std::filesystem::path outputPath = cachedPath;
+        outputPath += ".tmp";
+
+        std::string command = fmt::format("\"{}\" \"{}\" -o \"{}\" 2>&1", glslcPath(), sourcePath.string(), outputPath.string());
+        FILE* pipe = popen(command.c_str(), "r");
+        if(!pipe)
+        {
+            mLogger.error("Failed to launch glslc!");
+            return false;
+        }
+
+        std::string output;
+        char buffer[256];
+        while(fgets(buffer, sizeof(buffer), pipe))
+            output += buffer;
+
+        if(pclose(pipe) != 0)
+        {
+            mLogger.error("Failed to compile {}:\n{}", sourcePath.string(), output);
+            std::filesystem::remove(outputPath, ec);
+            return false;
+        }
+
+        std::filesystem::rename(outputPath, cachedPath, ec);
+        if(ec || !util::readCacheFile(cachedPath, code))
+            return false;
+
+        mLogger.info("Compiled {}.", sourcePath.string());
+    }
+
+    if(code.size() < 5 * sizeof(uint32_t) || code.size() % sizeof(uint32_t) != 0)
+        return false;
+
+    spirv.resize(code.size() / sizeof(uint32_t));
+    memcpy(spirv.data(), code.data(), code.size());
+
+    return true;
+}
+
+void ke::Graphics::ShaderLibrary::watch()
+{
+    while(mWatching)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mWatchMutex);
+            mWatchSignal.wait_for(lock, std::chrono::milliseconds(250), [this]() { return !mWatching; });
+        }
+        if(!mWatching) break;
+
+        std::vector<std::pair<std::string, std::filesystem::path>> modified;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for(auto& [name, entry] : mShaders)
+            {
+                std::error_code ec;
+                auto lastWrite = std::filesystem::last_write_time(entry.sourcePath, ec);
+                if(ec || lastWrite == entry.lastWrite) continue;
+
+                entry.lastWrite = lastWrite;
+                modified.emplace_back(name, entry.sourcePath);
+            }
+        }
+
+        for(auto& [name, sourcePath] : modified)
+        {
+            std::vector<uint32_t> spirv;
+            if(!compile(sourcePath, spirv)) continue; // keep the last good version
+
+            ShaderReflection reflection = reflect(spirv);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            ShaderEntry& entry = mShaders.at(name);
+            entry.spirv = std::move(spirv);
+            entry.reflection = std::move(reflection);
+
+            if(std::find(mChangedShaders.begin(), mChangedShaders.end(), name) == mChangedShaders.end())
+                mChangedShaders.push_back(name);
+        }
+    }
+}
+
+ke::Graphics::ShaderReflection ke::Graphics::ShaderLibrary::reflect(const std::vector<uint32_t> &spirv)
+{
+    ShaderReflection reflection{};
+    if(spirv.size() < 5 || spirv[0] != 0x07230203) return reflection;
+
+    std::vector<SpvId> ids(spirv[3]);
+    std::vector<uint32_t> variables;
+
+    for(size_t i = 5; i < spirv.size();)
+    {
+        uint32_t wordCount = spirv[i] >> 16;
+        uint32_t opcode = spirv[i] & 0xFFFF;
+        if(wordCount == 0 || i + wordCount > spirv.size()) break;
+
+        const uint32_t* words = &spirv[i + 1];
+        uint32_t operandCount = wordCount - 1;
+
+        switch(opcode)
+        {
+        case OpEntryPoint:
+            reflection.stage = executionModelToStage(words[0]);
+            break;
+        case OpDecorate:
+        {
+            SpvId& target = ids[words[0]];
+            if(words[1] == DecorationBinding) target.binding = words[2];
+            else if(words[1] == DecorationDescriptorSet) target.set = words[2];
+            else if(words[1] == DecorationArrayStride) target.arrayStride = words[2];
+            else if(words[1] == DecorationBlock) target.block = true;
+            else if(words[1] == DecorationBufferBlock) target.bufferBlock = true;
+            break;
+        }
+        case OpMemberDecorate:
+        {
+            SpvId& target = ids[words[0]];
+            uint32_t member = words[1];
+            if(words[2] == DecorationOffset)
+            {
+                if(target.memberOffsets.size() <= member) target.memberOffsets.resize(member + 1, 0);
+                target.memberOffsets[member] = words[3];
+            }
+            else if(words[2] == DecorationMatrixStride)
+            {
+                if(target.memberMatrixStrides.size() <= member) target.memberMatrixStrides.resize(member + 1, 0);
+                target.memberMatrixStrides[member] = words[3];
+            }
+            break;
+        }
+        case OpTypeBool: case OpTypeInt: case OpTypeFloat: case OpTypeVector: case OpTypeMatrix:
+        case OpTypeImage: case OpTypeSampler: case OpTypeSampledImage: case OpTypeArray:
+        case OpTypeRuntimeArray: case OpTypeStruct: case OpTypePointer:
+            ids[words[0]].opcode = opcode;
+            ids[words[0]].operands.assign(words, words + operandCount);
+            break;
+        case OpConstant:
+            // result type, result id, value
+            ids[words[1]].opcode = opcode;
+            ids[words[1]].operands.assign(words, words + operandCount);
+            break;
+        case OpVariable:
+            ids[words[1]].opcode = opcode;
+            ids[words[1]].operands.assign(words, words + operandCount);
+            variables.push_back(words[1]);
+            break;
+        default:
+            break;
+        }
+
+        i += wordCount;
+    }
+
+    for(uint32_t varId : variables)
+    {
+        const SpvId& variable = ids[varId];
+        uint32_t storageClass = variable.operands[2];
+
+        const SpvId& pointer = ids[variable.operands[0]];
+        if(pointer.opcode != OpTypePointer) continue;
+        uint32_t typeId = pointer.operands[2];
+
+        if(storageClass == StoragePushConstant)
+        {
+            reflection.pushConstantSize = std::max(reflection.pushConstantSize, typeSize(ids, typeId));
+            continue;
+        }
+
+        if(storageClass != StorageUniformConstant && storageClass != StorageUniform && storageClass != StorageStorageBuffer)
+            continue;
+        if(variable.binding == UINT32_MAX) continue;
+
+        uint32_t count = 1;
+        if(ids[typeId].opcode == OpTypeArray)
+        {
+            const SpvId& lengthConstant = ids[ids[typeId].operands[2]];
+            count = lengthConstant.operands.size() > 2 ? lengthConstant.operands[2] : 1;
+            typeId = ids[typeId].operands[1];
+        }
+        else if(ids[typeId].opcode == OpTypeRuntimeArray)
+        {
+            count = 0;
+            typeId = ids[typeId].operands[1];
+        }
+
+        const SpvId& type = ids[typeId];
+        VkDescriptorType descriptorType;
+
+        if(type.opcode == OpTypeSampledImage)
+            descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        else if(type.opcode == OpTypeSampler)
+            descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+        else if(type.opcode == OpTypeImage)
+            descriptorType = type.operands[6] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        else if(type.opcode == OpTypeStruct && (storageClass == StorageStorageBuffer || type.bufferBlock))
+            descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        else if(type.opcode == OpTypeStruct)
+            descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        else continue;
+
+        reflection.bindings.push_back({variable.set == UINT32_MAX ? 0 : variable.set, variable.binding, descriptorType, count, static_cast<VkShaderStageFlags>(reflection.stage)});
+    }
+
+    std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ReflectedBinding& a, const ReflectedBinding& b)
+    {
+        return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+    });
+
+    return reflection;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../Utility/Logger.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        struct ReflectedBinding
+        {
+            uint32_t set;
+            uint32_t binding;
+            VkDescriptorType type;
+            uint32_t count; // 0 for runtime-sized arrays
+            VkShaderStageFlags stages;
+
+            bool operator==(const ReflectedBinding& other) const = default;
+        };
+
+        struct ShaderReflection
+        {
+            VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+            std::vector<ReflectedBinding> bindings;
+            uint32_t pushConstantSize = 0;
+
+            bool operator==(const ShaderReflection& other) const = default;
+        };
+
+        class ShaderLibrary
+        {
+        public:
+            static ShaderLibrary& getInstance()
+            {
+                static ShaderLibrary instance;
+                return instance;
+            }
+
+            void init();
+            void terminate();
+
+            std::vector<uint32_t> getSpirv(const std::string& name) const;
+            ShaderReflection getReflection(const std::string& name) const;
+
+            void startWatching();
+            std::vector<std::string> consumeChangedShaders();
+
+            static ShaderReflection reflect(const std::vector<uint32_t>& spirv);
+        private:
+            ShaderLibrary() = default;
+
+            struct ShaderEntry
+            {
+                std::filesystem::path sourcePath;
+                std::filesystem::path fallbackPath;
+                std::filesystem::file_time_type lastWrite;
+
+                std::vector<uint32_t> spirv;
+                ShaderReflection reflection;
+            };
+
+            void registerShader(const std::string& name, const std::filesystem::path& sourcePath, const std::filesystem::path& fallbackPath);
+            bool compile(const std::filesystem::path& sourcePath, std::vector<uint32_t>& spirv);
+            void watch();
+
+            util::Logger mLogger = util::Logger("Shader Logger");
+
+            mutable std::mutex mMutex;
+            std::unordered_map<std::string, ShaderEntry> mShaders;
+            std::vector<std::string> mChangedShaders;
+
+            std::thread mWatcher;
+            std::atomic<bool> mWatching = false;
+            std::mutex mWatchMutex;
+            std::condition_variable mWatchSignal;
+        };
+    }
+}
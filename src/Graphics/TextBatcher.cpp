@@ -0,0 +1,138 @@
+#include "TextBatcher.hpp"
+#include "../Utility/RenderUtil.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+void ke::Graphics::TextBatcher::init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameSlots)
+{
+    mDevice = device;
+    mPhysicalDevice = physicalDevice;
+    mSlots.assign(frameSlots, Slot{});
+    mCurrent = 0;
+}
+
+void ke::Graphics::TextBatcher::destroy()
+{
+    for(Slot& slot : mSlots)
+    {
+        release(slot.current);
+        for(Allocation& allocation : slot.retired)
+            release(allocation);
+    }
+    mSlots.clear();
+}
+
+void ke::Graphics::TextBatcher::begin(uint32_t slot)
+{
+    if(slot >= mSlots.size()) return;
+
+    mCurrent = slot;
+    Slot& target = mSlots[slot];
+    for(Allocation& allocation : target.retired)
+        release(allocation);
+    target.retired.clear();
+
+    target.count = 0;
+    target.recorded = 0;
+}
+
+void ke::Graphics::TextBatcher::add(const Text::GlyphInstance* instances, uint32_t count)
+{
+    if(mSlots.empty() || count == 0) return;
+
+    Slot& slot = mSlots[mCurrent];
+    if(!reserve(slot, slot.count + count)) return;
+
+    memcpy(slot.current.mapped + slot.count, instances, count * sizeof(Text::GlyphInstance));
+    slot.count += count;
+}
+
+bool ke::Graphics::TextBatcher::record(VkCommandBuffer commandBuffer)
+{
+    if(mSlots.empty()) return false;
+
+    Slot& slot = mSlots[mCurrent];
+    if(slot.count == slot.recorded) return false;
+
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &slot.current.buffer, offsets);
+    vkCmdDraw(commandBuffer, 6, slot.count - slot.recorded, 0, slot.recorded);
+    slot.recorded = slot.count;
+    return true;
+}
+
+bool ke::Graphics::TextBatcher::reserve(Slot& slot, uint32_t count)
+{
+    if(count <= slot.current.capacity) return true;
+
+    Allocation grown;
+    if(!allocate(grown, std::max({count, slot.current.capacity * 2, MIN_CAPACITY}))) return false;
+
+    if(slot.current.buffer != VK_NULL_HANDLE)
+    {
+        memcpy(grown.mapped, slot.current.mapped, slot.count * sizeof(Text::GlyphInstance));
+
+        // A draw recorded this frame may still read the old buffer.
+        if(slot.recorded > 0) slot.retired.push_back(slot.current);
+        else release(slot.current);
+    }
+
+    slot.current = grown;
+    return true;
+}
+
+bool ke::Graphics::TextBatcher::allocate(Allocation& allocation, uint32_t capacity)
+{
+    VkDeviceSize size = static_cast<VkDeviceSize>(capacity) * sizeof(Text::GlyphInstance);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if(vkCreateBuffer(mDevice, &bufferInfo, nullptr, &allocation.buffer) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to create text instance buffer!");
+        allocation.buffer = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(mDevice, allocation.buffer, &requirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = util::findMemoryType(mPhysicalDevice, requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    if(allocInfo.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(mDevice, &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS)
+    {
+        mLogger.error("Failed to allocate text instance memory!");
+        release(allocation);
+        return false;
+    }
+
+    vkBindBufferMemory(mDevice, allocation.buffer, allocation.memory, 0);
+
+    void* mapped;
+    vkMapMemory(mDevice, allocation.memory, 0, size, 0, &mapped);
+    allocation.mapped = static_cast<Text::GlyphInstance*>(mapped);
+    allocation.capacity = capacity;
+
+    return true;
+}
+
+void ke::Graphics::TextBatcher::release(Allocation& allocation)
+{
+    if(allocation.memory != VK_NULL_HANDLE)
+    {
+        vkUnmapMemory(mDevice, allocation.memory);
+        vkFreeMemory(mDevice, allocation.memory, nullptr);
+    }
+    if(allocation.buffer != VK_NULL_HANDLE)
+        vkDestroyBuffer(mDevice, allocation.buffer, nullptr);
+
+    allocation = Allocation{};
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+#include "TextUtilities.hpp"
+#include "../Utility/Logger.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        // Glyph instances of every label drawn this frame, appended into a persistently mapped host-visible buffer
+        // owned by the frame slot and drawn with one instanced call. The atlas each glyph samples travels in the
+        // instance, so labels on different fonts and pages still share the draw.
+        class TextBatcher
+        {
+        public:
+            static constexpr uint32_t MIN_CAPACITY = 4096;
+
+            TextBatcher() = default;
+
+            void init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t frameSlots);
+            void destroy();
+
+            // The slot's fence has signaled, so its buffer is free to overwrite.
+            void begin(uint32_t slot);
+            void add(const Text::GlyphInstance* instances, uint32_t count);
+            // Draws everything added since the last call, false if there was nothing.
+            bool record(VkCommandBuffer commandBuffer);
+
+            uint32_t getInstanceCount() const {return mSlots.empty() ? 0 : mSlots[mCurrent].count;}
+        private:
+            struct Allocation
+            {
+                VkBuffer buffer = VK_NULL_HANDLE;
+                VkDeviceMemory memory = VK_NULL_HANDLE;
+                Text::GlyphInstance* mapped = nullptr;
+                uint32_t capacity = 0;
+            };
+
+            struct Slot
+            {
+                Allocation current;
+                // Outgrown after part of the frame was already recorded from them, freed when the slot comes round.
+                std::vector<Allocation> retired;
+                uint32_t count = 0;
+                uint32_t recorded = 0;
+            };
+
+            bool reserve(Slot& slot, uint32_t count);
+            bool allocate(Allocation& allocation, uint32_t capacity);
+            void release(Allocation& allocation);
+
+            util::Logger mLogger = util::Logger("Text Batcher Logger");
+
+            VkDevice mDevice = VK_NULL_HANDLE;
+            VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+
+            std::vector<Slot> mSlots;
+            uint32_t mCurrent = 0;
+        };
+    }
+}
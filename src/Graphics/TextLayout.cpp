@@ -0,0 +1,183 @@
+#include "TextLayout.hpp"
+
+#include "TextUtilities.hpp"
+#include "../Utility/Profiler.hpp"
+#include "../Utility/Utf8.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+    struct Line
+    {
+        std::vector<ke::Graphics::Text::ShapedGlyph> glyphs;
+        float width = 0.0f;     // without trailing spaces
+    };
+
+    bool isSpace(uint32_t codepoint)
+    {
+        return codepoint == ' ' || codepoint == '\t';
+    }
+}
+
+size_t ke::Graphics::Text::TextLayout::KeyHash::operator()(const Key& key) const
+{
+    size_t hash = std::hash<std::string>()(key.text);
+    auto combine = [&hash](size_t value) {hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);};
+
+    combine(std::hash<const Font*>()(key.font));
+    combine(std::hash<float>()(key.style.pixelSize));
+    combine(std::hash<float>()(key.style.maxWidth));
+    combine(std::hash<float>()(key.style.lineSpacing));
+    combine(static_cast<size_t>(key.style.align));
+    return hash;
+}
+
+std::shared_ptr<const ke::Graphics::Text::ShapedRun> ke::Graphics::Text::TextLayout::shape(const std::string& text, Font& font, const TextStyle& style)
+{
+    Key key{text, &font, style};
+    auto it = mIndex.find(key);
+    if(it != mIndex.end())
+    {
+        mHits++;
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        return it->second->second;
+    }
+
+    mMisses++;
+    auto run = std::make_shared<const ShapedRun>(layout(text, font, style));
+
+    if(mEntries.size() >= CAPACITY)
+    {
+        mIndex.erase(mEntries.back().first);
+        mEntries.pop_back();
+    }
+
+    mEntries.emplace_front(std::move(key), run);
+    mIndex.emplace(mEntries.front().first, mEntries.begin());
+    return run;
+}
+
+ke::Graphics::Text::ShapedRun ke::Graphics::Text::TextLayout::layout(const std::string& text, Font& font, const TextStyle& style)
+{
+    KE_PROFILE_FUNCTION();
+    float scale = style.pixelSize / static_cast<float>(font.getEmSize());
+    bool wrap = style.maxWidth > 0.0f;
+
+    std::vector<Line> lines(1);
+    float penX = 0.0f;
+    uint32_t previous = 0;
+
+    // Where the current line can be broken: the first glyph after the last run of spaces, and the line's
+    // width before those spaces.
+    size_t breakGlyph = SIZE_MAX;
+    float breakWidth = 0.0f;
+
+    auto newLine = [&]()
+    {
+        lines.emplace_back();
+        penX = 0.0f;
+        previous = 0;
+        breakGlyph = SIZE_MAX;
+    };
+
+    for(size_t pos = 0; pos < text.size();)
+    {
+        uint32_t codepoint = util::decodeUtf8(text, pos);
+        if(codepoint == '\n')
+        {
+            newLine();
+            continue;
+        }
+        if(codepoint == '\r') continue;
+
+        float kerning = previous ? static_cast<float>(font.getKerning(previous, codepoint)) * scale : 0.0f;
+        float advance = static_cast<float>(font.getAdvance(codepoint)) * scale;
+        previous = codepoint;
+
+        if(isSpace(codepoint))
+        {
+            if(breakGlyph != lines.back().glyphs.size()) breakWidth = lines.back().width;
+            penX += kerning + advance;
+            breakGlyph = lines.back().glyphs.size();
+            continue;
+        }
+
+        float x = penX + kerning;
+        if(wrap && x + advance > style.maxWidth && !lines.back().glyphs.empty())
+        {
+            if(breakGlyph != SIZE_MAX && breakGlyph > 0 && breakGlyph < lines.back().glyphs.size())
+            {
+                // Move the word being typed down, the spaces before it disappear at the end of the line. Its
+                // first glyph now starts the line, so the kerning it had against the last space goes too.
+                Line& full = lines.back();
+                float shift = full.glyphs[breakGlyph].pen.x;
+
+                Line next;
+                next.glyphs.assign(full.glyphs.begin() + breakGlyph, full.glyphs.end());
+                for(ShapedGlyph& glyph : next.glyphs)
+                    glyph.pen.x -= shift;
+                next.width = full.width - shift;
+
+                full.glyphs.resize(breakGlyph);
+                full.width = breakWidth;
+
+                lines.push_back(std::move(next));
+                penX -= shift;
+                x = penX + kerning;
+                breakGlyph = SIZE_MAX;
+            }
+            else
+            {
+                // A single word wider than the line breaks between characters.
+                newLine();
+                x = 0.0f;
+            }
+        }
+
+        lines.back().glyphs.push_back(ShapedGlyph{codepoint, {x, 0.0f}});
+        penX = x + advance;
+        lines.back().width = penX;
+    }
+
+    ShapedRun run;
+    run.lineCount = static_cast<uint32_t>(lines.size());
+
+    float blockWidth = wrap ? style.maxWidth : 0.0f;
+    if(!wrap)
+        for(const Line& line : lines)
+            blockWidth = std::max(blockWidth, line.width);
+
+    float lineAdvance = static_cast<float>(font.getLineHeight()) * scale * style.lineSpacing;
+    float alignment = style.align == TextAlign::Center ? 0.5f : style.align == TextAlign::Right ? 1.0f : 0.0f;
+
+    size_t glyphCount = 0;
+    for(const Line& line : lines)
+        glyphCount += line.glyphs.size();
+    run.glyphs.reserve(glyphCount);
+
+    for(size_t i = 0; i < lines.size(); i++)
+    {
+        float offsetX = (blockWidth - lines[i].width) * alignment;
+        float baseline = -lineAdvance * static_cast<float>(i);
+        for(const ShapedGlyph& glyph : lines[i].glyphs)
+            run.glyphs.push_back(ShapedGlyph{glyph.codepoint, {glyph.pen.x + offsetX, baseline}});
+    }
+
+    run.size = {blockWidth, lineAdvance * static_cast<float>(lines.size())};
+    return run;
+}
+
+void ke::Graphics::Text::TextLayout::clear()
+{
+    mIndex.clear();
+    mEntries.clear();
+}
+
+void ke::Graphics::Text::TextLayout::logStats() const
+{
+    uint64_t lookups = mHits + mMisses;
+    mLogger.info("{} shaped runs cached, {} hits and {} misses ({:.0f}% hit rate).", mEntries.size(), mHits, mMisses,
+        lookups ? 100.0 * mHits / lookups : 0.0);
+}
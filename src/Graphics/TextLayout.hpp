@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../Utility/Logger.hpp"
+
+namespace ke
+{
+    namespace Graphics
+    {
+        namespace Text
+        {
+            class Font;
+
+            enum class TextAlign : uint8_t
+            {
+                Left,
+                Center,
+                Right
+            };
+
+            struct TextStyle
+            {
+                float pixelSize = 16.0f;        // em size in pixels
+                float maxWidth = 0.0f;          // lines wrap at spaces past this many pixels, 0 only breaks at '\n'
+                TextAlign align = TextAlign::Left;
+                float lineSpacing = 1.0f;       // multiple of the font's line height
+
+                bool operator==(const TextStyle&) const = default;
+            };
+
+            struct ShapedGlyph
+            {
+                uint32_t codepoint;
+                // Pen position in pixels relative to the first line's baseline at the left edge of the block,
+                // y up like the rest of the UI, so later lines are below zero.
+                glm::vec2 pen;
+            };
+
+            // Whitespace only moves the pen, it never becomes a glyph.
+            struct ShapedRun
+            {
+                std::vector<ShapedGlyph> glyphs;
+                glm::vec2 size{0.0f};
+                uint32_t lineCount = 0;
+            };
+
+            // Turns strings into positioned glyphs with fractional advances and FreeType kerning, then wraps and
+            // aligns the lines. Runs are cached by text, font and style, so a label that hasn't changed is never
+            // laid out twice. Main thread only, like the Font metrics it reads.
+            class TextLayout
+            {
+            public:
+                static TextLayout& getInstance()
+                {
+                    static TextLayout instance;
+                    return instance;
+                }
+
+                static const size_t CAPACITY = 512;
+
+                std::shared_ptr<const ShapedRun> shape(const std::string& text, Font& font, const TextStyle& style);
+                // Uncached, for text that changes every frame anyway.
+                static ShapedRun layout(const std::string& text, Font& font, const TextStyle& style);
+
+                // Fonts are keyed by address, so this has to run before any of them go away.
+                void clear();
+                void logStats() const;
+            private:
+                TextLayout() = default;
+
+                struct Key
+                {
+                    std::string text;
+                    const Font* font;
+                    TextStyle style;
+
+                    bool operator==(const Key&) const = default;
+                };
+
+                struct KeyHash
+                {
+                    size_t operator()(const Key& key) const;
+                };
+
+                using Entry = std::pair<Key, std::shared_ptr<const ShapedRun>>;
+
+                util::Logger mLogger = util::Logger("Text Layout Logger");
+
+                // Most recently used at the front.
+                std::list<Entry> mEntries;
+                std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> mIndex;
+                uint64_t mHits = 0;
+                uint64_t mMisses = 0;
+            };
+        }
+    }
+}
@@ -1,9 +1,61 @@
-#define STB_RECT_PACK_IMPLEMENTATION
 #include "TextUtilities.hpp"
 
 #include "Renderer.hpp"
+#include "../Utility/Profiler.hpp"
+#include "../Utility/Utf8.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace
+{
+    struct FontAtlasCacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t fontHash;
+        uint32_t first, last;
+        uint32_t glyphSize;
+        uint32_t atlasSize;
+        uint32_t atlasHeight;
+        uint32_t format;
+        uint32_t glyphCount;
+        uint32_t nodeCount;
+        uint64_t usedArea;
+        double emSize;
+        uint64_t pixelOffset;
+        uint64_t pixelSize;
+    };
+
+    struct CachedGlyph
+    {
+        uint32_t codepoint;
+        uint32_t atlasX, atlasY;
+        uint32_t width, height;
+        int32_t bearingX, bearingY;
+        float advance;
+        float u0, v0, u1, v1;
+    };
+
+    const uint32_t FONT_ATLAS_CACHE_MAGIC = 0x4B454641; // "KEFA"
+    const uint32_t FONT_ATLAS_CACHE_VERSION = 3;
+
+    uint8_t toUnorm(float value)
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f);
+    }
+}
+
 void ke::Graphics::Text::TextUtils::init()
 {
+    loadFonts();
+    uploadFonts();
+}
+
+void ke::Graphics::Text::TextUtils::loadFonts()
+{
+    KE_PROFILE_FUNCTION();
     ft = msdfgen::initializeFreetype();
 
     const std::filesystem::path targetPath("./src/Fonts");
@@ -14,23 +66,86 @@ void ke::Graphics::Text::TextUtils::init()
         {
             if(!std::filesystem::is_regular_file(direntry.path())) continue;
 
-            mFonts.emplace(direntry.path().filename().stem(), std::make_unique<Font>(direntry.path(), ft));
+            mFonts.emplace(direntry.path().filename().stem(), std::make_unique<Font>(direntry.path(), ft, mGlyphFormat));
         }
     }
     catch(const std::filesystem::filesystem_error& e)
     {
         std::cerr << e.what() << '\n';
     }
-    
+}
+
+void ke::Graphics::Text::TextUtils::uploadFonts()
+{
+    KE_PROFILE_FUNCTION();
+    for(auto& [name, font] : mFonts)
+        font->upload();
+
+    logMemoryReport();
+}
 
+void ke::Graphics::Text::TextUtils::logMemoryReport() const
+{
+    for(const auto& [name, font] : mFonts)
+        font->logMemoryReport();
+}
+
+void ke::Graphics::Text::TextUtils::update()
+{
+    KE_PROFILE_FUNCTION();
+    mFrame++;
+    for(auto& [name, font] : mFonts)
+        font->update(mFrame);
 }
 
 void ke::Graphics::Text::TextUtils::terminate()
 {
+    TextLayout::getInstance().logStats();
+    TextLayout::getInstance().clear();
     mFonts.clear();
 }
 
-ke::Graphics::Text::GlyphInfo ke::Graphics::Text::TextUtils::rasterizeGlyph(msdfgen::FontHandle *font, uint32_t codepoint)
+msdfgen::FontHandle* ke::Graphics::Text::TextUtils::getThreadFontHandle(const std::string& fontPath)
+{
+    struct ThreadFreetype
+    {
+        msdfgen::FreetypeHandle* library = msdfgen::initializeFreetype();
+        std::unordered_map<std::string, msdfgen::FontHandle*> fonts;
+
+        ~ThreadFreetype()
+        {
+            for(auto& [path, font] : fonts)
+                if(font) msdfgen::destroyFont(font);
+            msdfgen::deinitializeFreetype(library);
+        }
+    };
+    static thread_local ThreadFreetype freetype;
+
+    auto it = freetype.fonts.find(fontPath);
+    if(it != freetype.fonts.end()) return it->second;
+
+    return freetype.fonts[fontPath] = msdfgen::loadFont(freetype.library, fontPath.c_str());
+}
+
+std::vector<ke::Graphics::Text::GlyphInfo> ke::Graphics::Text::TextUtils::rasterizeGlyphs(const std::string& fontPath, uint32_t first, uint32_t last, GlyphFormat format)
+{
+    KE_PROFILE_FUNCTION();
+    std::vector<GlyphInfo> glyphs(last > first ? last - first : 0);
+
+    // Small batches, glyph cost varies a lot with outline complexity and stealing evens it out.
+    util::JobSystem::getInstance().parallelFor(static_cast<uint32_t>(glyphs.size()), 4, [&](uint32_t begin, uint32_t end)
+    {
+        msdfgen::FontHandle* font = getThreadFontHandle(fontPath);
+        if(!font) return;
+
+        for(uint32_t i = begin; i < end; i++)
+            glyphs[i] = rasterizeGlyph(font, first + i, format);
+    }, "RasterizeGlyphs");
+
+    return glyphs;
+}
+
+ke::Graphics::Text::GlyphInfo ke::Graphics::Text::TextUtils::rasterizeGlyph(msdfgen::FontHandle *font, uint32_t codepoint, GlyphFormat format)
 {
     msdfgen::Shape shape;
     double advance;
@@ -47,7 +162,7 @@ ke::Graphics::Text::GlyphInfo ke::Graphics::Text::TextUtils::rasterizeGlyph(msdf
 
     msdfgen::FontMetrics metrics;
     msdfgen::getFontMetrics(metrics, font);
-    double scale = (GLYPH_SIZE - 4) / metrics.emSize;
+    double scale = getRasterEmSize() / metrics.emSize;
 
     int width = (int)std::ceil((r - l) * scale) +4;
     int height = (int)std::ceil((t - b) * scale) + 4;
@@ -55,9 +170,7 @@ ke::Graphics::Text::GlyphInfo ke::Graphics::Text::TextUtils::rasterizeGlyph(msdf
     height = std::max(height, 1);
 
     msdfgen::Vector2 translate(-l + 2.0 / scale, -b + 2.0 / scale);
-    msdfgen::Bitmap<float, 3> bitmap(width, height);
-
-    msdfgen::generateMSDF(bitmap, shape, msdfgen::Projection(scale, translate), 64.0);
+    msdfgen::Projection projection(scale, translate);
 
     GlyphInfo info;
     info.width = width;
@@ -67,19 +180,49 @@ ke::Graphics::Text::GlyphInfo ke::Graphics::Text::TextUtils::rasterizeGlyph(msdf
     info.bearingY = (int)(bounds.t * scale) + 2;
     info.internalCodepoint = codepoint;
 
-    info.pixels.resize(info.width * info.height * 4); // RGBA across every pixel
+    // Quantized to the atlas texel format straight away, the float bitmap never outlives this call.
+    info.pixels.resize(static_cast<size_t>(width) * height * getBytesPerTexel(format));
+    uint8_t* texel = info.pixels.data();
 
-    for(int y = 0; y < info.height; y++)
-        for(int x = 0; x < info.width; x++)
-        {
-            const float* px = bitmap(x, y);
+    if(format == GlyphFormat::SDF)
+    {
+        msdfgen::Bitmap<float, 1> bitmap(width, height);
+        msdfgen::generateSDF(bitmap, shape, projection, 64.0);
 
-            int i = (y * info.width + x) * 4;
-            info.pixels[i + 0] = px[0];
-            info.pixels[i + 1] = px[1];
-            info.pixels[i + 2] = px[2];
-            info.pixels[i + 3] = 255;
-        }
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++)
+                *texel++ = toUnorm(*bitmap(x, y));
+    }
+    else if(format == GlyphFormat::MTSDF)
+    {
+        msdfgen::Bitmap<float, 4> bitmap(width, height);
+        msdfgen::generateMTSDF(bitmap, shape, projection, 64.0);
+
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++, texel += 4)
+            {
+                const float* px = bitmap(x, y);
+                texel[0] = toUnorm(px[2]);
+                texel[1] = toUnorm(px[1]);
+                texel[2] = toUnorm(px[0]);
+                texel[3] = toUnorm(px[3]);
+            }
+    }
+    else
+    {
+        msdfgen::Bitmap<float, 3> bitmap(width, height);
+        msdfgen::generateMSDF(bitmap, shape, projection, 64.0);
+
+        for(int y = 0; y < height; y++)
+            for(int x = 0; x < width; x++, texel += 4)
+            {
+                const float* px = bitmap(x, y);
+                texel[0] = toUnorm(px[2]);
+                texel[1] = toUnorm(px[1]);
+                texel[2] = toUnorm(px[0]);
+                texel[3] = 255;
+            }
+    }
 
     return info;
 }
@@ -89,18 +232,29 @@ ke::Graphics::Text::Font& ke::Graphics::Text::TextUtils::getFont(const std::stri
     return *mFonts[fontname];
 }
 
-ke::Graphics::Text::Font::Font(const std::string &filepath, msdfgen::FreetypeHandle* lib)
+ke::Graphics::Text::Font::Font(const std::string &filepath, msdfgen::FreetypeHandle* lib, GlyphFormat format)
+    : mAtlas(format)
 {
+    mPath = filepath;
+    mName = std::filesystem::path(filepath).filename().string();
     mFontHandle = msdfgen::loadFont(lib, filepath.c_str());
 
-    rasterizeGlyphs(32, 128);
+    msdfgen::FontMetrics metrics;
+    msdfgen::getFontMetrics(metrics, mFontHandle);
+    mEmSize = metrics.emSize;
+    mAscender = metrics.ascenderY;
+    mLineHeight = metrics.lineHeight;
 
-    
+    if(loadAtlasCache(32, 128)) return;
+
+    rasterizeGlyphs(32, 128);
+    saveAtlasCache(32, 128);
 }
 
 ke::Graphics::Text::Font::~Font()
 {
-    mImage.destroy();
+    // Outstanding rasterization jobs write into this font.
+    util::JobSystem::getInstance().wait(mRasterizing);
 }
 
 double ke::Graphics::Text::Font::getEmSize() const
@@ -108,92 +262,342 @@ double ke::Graphics::Text::Font::getEmSize() const
     return mEmSize;
 }
 
+double ke::Graphics::Text::Font::getAdvance(uint32_t codepoint)
+{
+    auto it = mAdvances.find(codepoint);
+    if(it != mAdvances.end()) return it->second;
+
+    // Loading the outline is the only way msdfgen hands out the advance, but nothing gets rasterized.
+    double advance = 0.0;
+    msdfgen::Shape shape;
+    msdfgen::GlyphIndex glyphIndex;
+    if(!msdfgen::getGlyphIndex(glyphIndex, mFontHandle, codepoint) || !msdfgen::loadGlyph(shape, mFontHandle, glyphIndex, &advance))
+        advance = 0.0;
+
+    mAdvances.emplace(codepoint, advance);
+    return advance;
+}
+
+double ke::Graphics::Text::Font::getKerning(uint32_t left, uint32_t right)
+{
+    uint64_t key = (static_cast<uint64_t>(left) << 32) | right;
+    auto it = mKerning.find(key);
+    if(it != mKerning.end()) return it->second;
+
+    double kerning = 0.0;
+    if(!msdfgen::getKerning(kerning, mFontHandle, left, right)) kerning = 0.0;
+
+    mKerning.emplace(key, kerning);
+    return kerning;
+}
+
 void ke::Graphics::Text::Font::rasterizeGlyphs(int min, int max)
 {
-    TextUtils& textutils = TextUtils::getInstance();
-    for(uint32_t cp = min; cp < max; cp++)
+    KE_PROFILE_FUNCTION();
+    std::vector<GlyphInfo> glyphs = TextUtils::getInstance().rasterizeGlyphs(mPath, min, max, getFormat());
+
+    // Tallest first keeps the skyline flat.
+    std::vector<uint32_t> order(glyphs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&glyphs](uint32_t a, uint32_t b) {return glyphs[a].height > glyphs[b].height;});
+
+    for(uint32_t index : order)
+        insertGlyph(std::move(glyphs[index]));
+}
+
+bool ke::Graphics::Text::Font::insertGlyph(GlyphInfo&& glyph)
+{
+    AtlasRegion region;
+    int32_t evictedPage;
+    if(!mAtlas.allocate(glyph.width, glyph.height, region, evictedPage))
     {
-        mGlyphs[cp] = textutils.rasterizeGlyph(mFontHandle, cp);
+        mLogger.warn("No atlas space for glyph U+{:04X}, every page is in use this frame.", glyph.internalCodepoint);
+        return false;
+    }
+    if(evictedPage >= 0) evictPage(static_cast<uint16_t>(evictedPage));
+
+    mAtlas.write(region, glyph.pixels.data());
+    mAtlas.touch(region.page);
+
+    glyph.page = region.page;
+    glyph.atlasX = region.x;
+    glyph.atlasY = region.y;
+    glyph.u0 = (float)region.x;
+    glyph.v0 = (float)region.y;
+    glyph.u1 = (float)(region.x + region.width);
+    glyph.v1 = (float)(region.y + region.height);
+    std::vector<uint8_t>().swap(glyph.pixels);
+
+    mGlyphs[glyph.internalCodepoint] = std::move(glyph);
+    return true;
+}
+
+void ke::Graphics::Text::Font::evictPage(uint16_t page)
+{
+    size_t evicted = std::erase_if(mGlyphs, [page](const auto& entry) {return entry.second.page == page;});
+    mLogger.info("Evicted atlas page {} of {} with {} glyphs.", page, mName, evicted);
+    mVersion++;
+}
 
+const ke::Graphics::Text::GlyphInfo* ke::Graphics::Text::Font::findGlyph(uint32_t codepoint)
+{
+    auto it = mGlyphs.find(codepoint);
+    if(it != mGlyphs.end())
+    {
+        mAtlas.touch(it->second.page);
+        return &it->second;
     }
 
-    msdfgen::FontMetrics metrics;
-    msdfgen::getFontMetrics(metrics, mFontHandle);
-    mEmSize = metrics.emSize;
-    
-    stbrp_context packCtx;
-    stbrp_node nodes[ATLAS_SIZE];
-    stbrp_init_target(&packCtx, ATLAS_SIZE, ATLAS_SIZE, nodes, ATLAS_SIZE);
+    if(!mRequested.insert(codepoint).second) return nullptr;
 
-    
-    std::vector<stbrp_rect> rects;
-    for(auto& [codepoint, glyph] : mGlyphs)
+    util::JobSystem::getInstance().schedule([this, codepoint]()
     {
-        rects.push_back({(int)codepoint, (int)glyph.width, (int)glyph.height});
+        msdfgen::FontHandle* font = TextUtils::getThreadFontHandle(mPath);
+        if(!font) return;
+
+        GlyphInfo glyph = TextUtils::getInstance().rasterizeGlyph(font, codepoint, getFormat());
+        std::lock_guard lock(mReadyMutex);
+        mReady.push_back(std::move(glyph));
+    }, {"RasterizeGlyph", &mRasterizing});
+
+    return nullptr;
+}
+
+void ke::Graphics::Text::Font::update(uint64_t frame)
+{
+    mAtlas.setFrame(frame);
+
+    std::vector<GlyphInfo> ready;
+    {
+        std::lock_guard lock(mReadyMutex);
+        ready.swap(mReady);
+    }
+    if(ready.empty()) return;
+
+    for(GlyphInfo& glyph : ready)
+    {
+        // Dropped from the requests either way, a glyph that didn't fit gets asked for again on its next use.
+        mRequested.erase(glyph.internalCodepoint);
+        insertGlyph(std::move(glyph));
+    }
+
+    mAtlas.flush();
+    mVersion++;
+}
+
+std::filesystem::path ke::Graphics::Text::Font::getAtlasCachePath(uint32_t first, uint32_t last)
+{
+    if(mFontHash == 0)
+    {
+        std::vector<char> fontData;
+        if(!util::readCacheFile(mPath, fontData)) return {};
+        mFontHash = util::hashBytes(fontData.data(), fontData.size());
     }
 
-    stbrp_pack_rects(&packCtx, rects.data(), rects.size());
+    uint32_t settings[] = {FONT_ATLAS_CACHE_VERSION, first, last, TextUtils::getGlyphSize(), GlyphAtlas::PAGE_SIZE, static_cast<uint32_t>(getFormat())};
+    uint64_t key = util::hashBytes(settings, sizeof(settings), mFontHash);
+
+    std::filesystem::path dir = util::getCacheDirectory() / "fonts";
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
 
-    for(auto& rect : rects)
+    return dir / fmt::format("{}-{:016x}.atlas", std::filesystem::path(mPath).stem().string(), key);
+}
+
+bool ke::Graphics::Text::Font::loadAtlasCache(uint32_t first, uint32_t last)
+{
+    KE_PROFILE_FUNCTION();
+    std::filesystem::path path = getAtlasCachePath(first, last);
+    if(path.empty() || !mAtlasCache.open(path)) return false;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(mAtlasCache.data());
+    FontAtlasCacheHeader header{};
+    if(mAtlasCache.size() >= sizeof(header)) memcpy(&header, bytes, sizeof(header));
+
+    size_t nodesStart = sizeof(header) + static_cast<size_t>(header.glyphCount) * sizeof(CachedGlyph);
+    size_t nodesEnd = nodesStart + static_cast<size_t>(header.nodeCount) * sizeof(SkylinePacker::Node);
+    bool valid = mAtlasCache.size() >= sizeof(header)
+        && header.magic == FONT_ATLAS_CACHE_MAGIC && header.version == FONT_ATLAS_CACHE_VERSION
+        && header.fontHash == mFontHash && header.first == first && header.last == last
+        && header.glyphSize == TextUtils::getGlyphSize() && header.atlasSize == GlyphAtlas::PAGE_SIZE
+        && header.format == static_cast<uint32_t>(getFormat())
+        && header.atlasHeight >= GlyphAtlas::MIN_PAGE_HEIGHT && header.atlasHeight <= GlyphAtlas::PAGE_SIZE
+        && header.pixelSize == static_cast<uint64_t>(GlyphAtlas::PAGE_SIZE) * header.atlasHeight * getBytesPerTexel(getFormat())
+        && header.pixelOffset >= nodesEnd && header.pixelOffset + header.pixelSize == mAtlasCache.size();
+
+    if(!valid)
     {
-        auto& glyph = mGlyphs[rect.id];
+        mLogger.warn("Font atlas cache {} is stale or damaged, rebuilding it.", path.filename().string());
+        mAtlasCache.close();
+        return false;
+    }
 
-        glyph.atlasX = rect.x;
-        glyph.atlasY = rect.y;
-        glyph.u0 = rect.x / (float)ATLAS_SIZE;
-        glyph.v0 = rect.y / (float)ATLAS_SIZE;
-        glyph.u1 = (rect.x + rect.w) / (float)ATLAS_SIZE;
-        glyph.v1 = (rect.y + rect.h) / (float)ATLAS_SIZE;
+    for(uint32_t i = 0; i < header.glyphCount; i++)
+    {
+        CachedGlyph cached;
+        memcpy(&cached, bytes + sizeof(header) + i * sizeof(CachedGlyph), sizeof(cached));
+
+        GlyphInfo& glyph = mGlyphs[cached.codepoint];
+        glyph.atlasX = cached.atlasX;
+        glyph.atlasY = cached.atlasY;
+        glyph.width = cached.width;
+        glyph.height = cached.height;
+        glyph.bearingX = cached.bearingX;
+        glyph.bearingY = cached.bearingY;
+        glyph.advance = cached.advance;
+        glyph.u0 = cached.u0;
+        glyph.v0 = cached.v0;
+        glyph.u1 = cached.u1;
+        glyph.v1 = cached.v1;
+        glyph.page = 0;
+        glyph.internalCodepoint = cached.codepoint;
     }
 
-    Renderer& rend = Renderer::getInstance();
-    mImage.setDevice(rend.getDevice());
-    rend.createFontImage(mGlyphs, ATLAS_SIZE, mImage.image, mImage.imageMemory);
-    rend.createFontImageView(mImage);
-    mDescriptorIndex = rend.addFontToDescriptor(mImage);
+    std::vector<SkylinePacker::Node> nodes(header.nodeCount);
+    memcpy(nodes.data(), bytes + nodesStart, nodes.size() * sizeof(SkylinePacker::Node));
+
+    mAtlas.adoptPage(bytes + header.pixelOffset, header.atlasHeight, std::move(nodes), header.usedArea);
+    mLogger.info("Loaded {} glyphs of {} from the atlas cache.", header.glyphCount, mName);
+
+    return true;
 }
 
-ke::Graphics::Text::GlyphInfo &ke::Graphics::Text::Font::getGlyphInfo(uint32_t codepoint)
+void ke::Graphics::Text::Font::saveAtlasCache(uint32_t first, uint32_t last)
 {
-    return mGlyphs.at(codepoint);
+    KE_PROFILE_FUNCTION();
+    // Only the single page the startup range normally fits in is worth keeping.
+    if(mAtlas.getPageCount() != 1 || !mAtlas.getPixels(0)) return;
+
+    std::filesystem::path path = getAtlasCachePath(first, last);
+    if(path.empty()) return;
+
+    const std::vector<SkylinePacker::Node>& nodes = mAtlas.getPacker(0).getNodes();
+
+    FontAtlasCacheHeader header{};
+    header.magic = FONT_ATLAS_CACHE_MAGIC;
+    header.version = FONT_ATLAS_CACHE_VERSION;
+    header.fontHash = mFontHash;
+    header.first = first;
+    header.last = last;
+    header.glyphSize = TextUtils::getGlyphSize();
+    header.atlasSize = GlyphAtlas::PAGE_SIZE;
+    header.atlasHeight = mAtlas.getPageHeight(0);
+    header.format = static_cast<uint32_t>(getFormat());
+    header.glyphCount = static_cast<uint32_t>(mGlyphs.size());
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.usedArea = mAtlas.getPacker(0).getUsedArea();
+    header.emSize = mEmSize;
+    // Page aligned, so the mapped pixels start on their own page.
+    header.pixelOffset = (sizeof(header) + mGlyphs.size() * sizeof(CachedGlyph) + nodes.size() * sizeof(SkylinePacker::Node) + 4095) & ~uint64_t(4095);
+    header.pixelSize = static_cast<uint64_t>(GlyphAtlas::PAGE_SIZE) * header.atlasHeight * getBytesPerTexel(getFormat());
+
+    std::vector<char> fileData(header.pixelOffset + header.pixelSize, 0);
+    memcpy(fileData.data(), &header, sizeof(header));
+
+    size_t offset = sizeof(header);
+    for(const auto& [codepoint, glyph] : mGlyphs)
+    {
+        CachedGlyph cached{codepoint, glyph.atlasX, glyph.atlasY, glyph.width, glyph.height, glyph.bearingX, glyph.bearingY, glyph.advance, glyph.u0, glyph.v0, glyph.u1, glyph.v1};
+        memcpy(fileData.data() + offset, &cached, sizeof(cached));
+        offset += sizeof(cached);
+    }
+    memcpy(fileData.data() + offset, nodes.data(), nodes.size() * sizeof(SkylinePacker::Node));
+    memcpy(fileData.data() + header.pixelOffset, mAtlas.getPixels(0), header.pixelSize);
+
+    if(!util::writeCacheFile(path, fileData.data(), fileData.size()))
+        mLogger.warn("Failed to write font atlas cache {}.", path.string());
+}
+
+void ke::Graphics::Text::Font::upload()
+{
+    mAtlas.flush();
+
+    // The first flush copied the mapped cache onto the GPU, it has no further use.
+    mAtlasCache.close();
 }
 
-uint32_t ke::Graphics::Text::Font::getDescriptorIndex() const
+void ke::Graphics::Text::Font::logMemoryReport() const
 {
-    return mDescriptorIndex;
+    AtlasMemory memory = mAtlas.getMemory();
+    size_t glyphBytes = mGlyphs.size() * (sizeof(GlyphInfo) + sizeof(uint32_t));
+
+    mLogger.info("{}: {} glyphs as {}, {} page(s), {} KiB VRAM, {} KiB CPU, {:.0f}% of the atlas packed",
+        mName, mGlyphs.size(), getFormatName(getFormat()), mAtlas.getPageCount(), memory.gpuBytes / 1024,
+        (memory.cpuBytes + glyphBytes) / 1024, memory.totalTexels ? 100.0 * memory.usedTexels / memory.totalTexels : 0.0);
+
+    for(uint16_t page = 0; page < mAtlas.getPageCount(); page++)
+        mLogger.info("  page {}: {}x{}", page, GlyphAtlas::PAGE_SIZE, mAtlas.getPageHeight(page));
 }
 
 ke::Graphics::Text::TextInstance::TextInstance(const std::string &text, const std::string &fontname, int x, int y, glm::vec4 color, int pixelSize)
+    : TextInstance(text, fontname, x, y, color, TextStyle{.pixelSize = static_cast<float>(pixelSize)})
 {
-    TextUtils& textutils = TextUtils::getInstance();
-    Font& font = textutils.getFont(fontname);
+}
 
-    float fontScale = pixelSize / (float) font.getEmSize();
+ke::Graphics::Text::TextInstance::TextInstance(const std::string &text, const std::string &fontname, int x, int y, glm::vec4 color, const TextStyle& style)
+    : mText(text), mFont(&TextUtils::getInstance().getFont(fontname)), mX(x), mY(y), mColor(color), mStyle(style)
+{
+    build();
+}
+
+bool ke::Graphics::Text::TextInstance::isStale() const
+{
+    if(mFont->getVersion() == mFontVersion) return false;
+    if(!mComplete) return true;
 
-    int cursorX = x;
-    for(char ch : text)
+    for(const PageUse& use : mPages)
+        if(mFont->getPageGeneration(use.page) != use.generation) return true;
+
+    mFontVersion = mFont->getVersion();
+    return false;
+}
+
+void ke::Graphics::Text::TextInstance::build() const
+{
+    KE_PROFILE_ZONE("TextInstance");
+    mFontVersion = mFont->getVersion();
+    mComplete = true;
+    mInstances.clear();
+    mPages.clear();
+
+    // Layout is cached, only the atlas lookups run again when glyphs arrive.
+    if(!mRun) mRun = TextLayout::getInstance().shape(mText, *mFont, mStyle);
+    float glyphScale = mStyle.pixelSize / TextUtils::getRasterEmSize();
+
+    uint32_t singleChannel = mFont->getFormat() == GlyphFormat::SDF ? 1 : 0;
+    for(const ShapedGlyph& shaped : mRun->glyphs)
     {
-        GlyphInfo& ginfo = font.getGlyphInfo((uint32_t)ch);
+        const GlyphInfo* ginfo = mFont->findGlyph(shaped.codepoint);
+        if(!ginfo)
+        {
+            mComplete = false;
+            continue;
+        }
 
+        glm::vec2 origin = glm::vec2(mX, mY) + shaped.pen;
         mInstances.push_back(GlyphInstance{
-            .position = { (float)(cursorX + ginfo.bearingX * fontScale), (float)(y + ginfo.bearingY * fontScale - ginfo.height * fontScale) },
-            .size = {ginfo.width * fontScale, ginfo.height * fontScale},
-            .uv = {ginfo.u0, ginfo.v0, ginfo.u1, ginfo.v1},
-            .color = color,
+            .position = {origin.x + ginfo->bearingX * glyphScale, origin.y + (ginfo->bearingY - (float)ginfo->height) * glyphScale},
+            .size = {ginfo->width * glyphScale, ginfo->height * glyphScale},
+            .uv = {ginfo->u0, ginfo->v0, ginfo->u1, ginfo->v1},
+            .color = mColor,
+            .atlas = {mFont->getDescriptorIndex(ginfo->page), singleChannel},
         });
-        cursorX += (int)ginfo.advance;
-    }
 
-    Renderer& rend = Renderer::getInstance();
-    mInstanceBuffer.setDevice(rend.getDevice());
-    rend.createGlyphInstanceBuffer(mInstances, mInstanceBuffer.buffer, mInstanceBuffer.bufferMemory);
-    mFontIndex = font.getDescriptorIndex();
+        if(std::none_of(mPages.begin(), mPages.end(), [ginfo](const PageUse& use) {return use.page == ginfo->page;}))
+            mPages.push_back(PageUse{ginfo->page, mFont->getPageGeneration(ginfo->page)});
+    }
 }
 
 void ke::Graphics::Text::TextInstance::Draw() const
 {
     static Renderer& rend = Renderer::getInstance();
-    
-    rend.pickFontIndex(mFontIndex);
-    rend.drawText(mInstanceBuffer, static_cast<uint32_t>(mInstances.size()));
+    if(!mFont) return;
+
+    if(isStale()) build();
+
+    for(const PageUse& use : mPages)
+        mFont->touchPage(use.page);
+
+    // Only queued here, the text pass draws every label in one call.
+    rend.queueText(mInstances.data(), static_cast<uint32_t>(mInstances.size()));
 }
@@ -6,9 +6,15 @@
 #include <msdfgen/msdfgen-ext.h>
 #include <iostream>
 #include <filesystem>
+#include <mutex>
 #include <unordered_map>
-#include <stb/stb_rect_pack.h>
+#include <unordered_set>
 #include "../Utility/RenderUtil.hpp"
+#include "../Utility/FileCache.hpp"
+#include "../Utility/JobSystem.hpp"
+#include "../Utility/Logger.hpp"
+#include "GlyphAtlas.hpp"
+#include "TextLayout.hpp"
 
 namespace ke
 {
@@ -24,9 +30,10 @@ namespace ke
                 uint32_t width, height;
                 int bearingX, bearingY;
                 float advance;
-                float u0, v0, u1, v1;
-                uint16_t internalCodepoint;
-                std::vector<float> pixels;
+                float u0, v0, u1, v1;       // in texels of the atlas page
+                uint16_t page = 0;
+                uint32_t internalCodepoint;
+                std::vector<uint8_t> pixels;    // texels in the font's GlyphFormat, only until the glyph is packed
             };
 
 
@@ -36,10 +43,11 @@ namespace ke
                 glm::vec2 size;
                 glm::vec4 uv;
                 glm::vec4 color;
+                glm::uvec2 atlas;   // descriptor index of the page, 1 if it is a single channel SDF
 
-                static std::array<VkVertexInputAttributeDescription, 4> getInputAttributeDescriptions()
+                static std::array<VkVertexInputAttributeDescription, 5> getInputAttributeDescriptions()
                 {
-                    std::array<VkVertexInputAttributeDescription, 4> descs;
+                    std::array<VkVertexInputAttributeDescription, 5> descs;
                     
                     descs[0].binding = 0;
                     descs[0].location = 0;
@@ -60,6 +68,11 @@ namespace ke
                     descs[3].location = 3;
                     descs[3].format = VK_FORMAT_R32G32B32A32_SFLOAT;
                     descs[3].offset = offsetof(GlyphInstance, color);
+
+                    descs[4].binding = 0;
+                    descs[4].location = 4;
+                    descs[4].format = VK_FORMAT_R32G32_UINT;
+                    descs[4].offset = offsetof(GlyphInstance, atlas);
                     
                     return descs;
                 }
@@ -80,21 +93,66 @@ namespace ke
                 friend class TextUtils;
             public:
                 Font() = default;
-                Font(const std::string& filepath, msdfgen::FreetypeHandle* lib);
+                Font(const std::string& filepath, msdfgen::FreetypeHandle* lib, GlyphFormat format = GlyphFormat::MSDF);
                 ~Font();
                 
                 double getEmSize() const;
+                // Layout metrics in the same font units as getEmSize(). They come from the font tables, so text
+                // can be laid out before its glyphs are rasterized. Main thread only.
+                double getAdvance(uint32_t codepoint);
+                double getKerning(uint32_t left, uint32_t right);
+                double getAscender() const {return mAscender;}
+                double getLineHeight() const {return mLineHeight;}
+                // Rasterizes [min, max) right away, used for the range every launch needs.
                 void rasterizeGlyphs(int min, int max);
-                GlyphInfo& getGlyphInfo(uint32_t codepoint);
-                uint32_t getDescriptorIndex() const;
+                void upload();
+
+                // nullptr until the glyph is resident. The first miss sends it off to be rasterized on a job
+                // worker, update() packs it into the atlas once it's done.
+                const GlyphInfo* findGlyph(uint32_t codepoint);
+                void update(uint64_t frame);
+
+                void touchPage(uint16_t page) {mAtlas.touch(page);}
+                uint32_t getDescriptorIndex(uint16_t page) const {return mAtlas.getDescriptorIndex(page);}
+                uint32_t getPageGeneration(uint16_t page) const {return mAtlas.getGeneration(page);}
+                // Changes whenever glyphs become resident or get evicted.
+                uint64_t getVersion() const {return mVersion;}
+                GlyphFormat getFormat() const {return mAtlas.getFormat();}
+
+                void logMemoryReport() const;
             private:
+                bool insertGlyph(GlyphInfo&& glyph);
+                void evictPage(uint16_t page);
+
+                // The first page after the startup range lives on disk keyed by the font's contents and the
+                // rasterization settings, a hit skips msdfgen and packing entirely.
+                std::filesystem::path getAtlasCachePath(uint32_t first, uint32_t last);
+                bool loadAtlasCache(uint32_t first, uint32_t last);
+                void saveAtlasCache(uint32_t first, uint32_t last);
+
+                util::Logger mLogger = util::Logger("Font Logger");
+
+                std::string mPath;
+                std::string mName;
                 msdfgen::FontHandle* mFontHandle = nullptr;
                 std::unordered_map<uint32_t, GlyphInfo> mGlyphs;
-                static const unsigned int ATLAS_SIZE = 2048;
-
-                double mEmSize;
-                util::Image mImage;
-                uint32_t mDescriptorIndex;
+                GlyphAtlas mAtlas;
+                uint64_t mVersion = 1;
+
+                // Requests are main thread only, finished glyphs come back from the workers through mReady.
+                std::unordered_set<uint32_t> mRequested;
+                std::mutex mReadyMutex;
+                std::vector<GlyphInfo> mReady;
+                util::JobCounter mRasterizing;
+
+                util::MappedFile mAtlasCache;
+                uint64_t mFontHash = 0;
+
+                double mEmSize = 0.0;
+                double mAscender = 0.0;
+                double mLineHeight = 0.0;
+                std::unordered_map<uint32_t, double> mAdvances;
+                std::unordered_map<uint64_t, double> mKerning;
             };
 
             
@@ -109,11 +167,28 @@ namespace ke
                 }
                 
                 void init();
+                // init in two halves: MSDF generation is CPU only, the atlas upload needs the render thread.
+                void loadFonts();
+                void uploadFonts();
+                // Once per frame on the main thread, brings glyphs rasterized since the last call into the atlases.
+                void update();
                 void terminate();
+
+                // Fonts loaded after this use the given format.
+                void setGlyphFormat(GlyphFormat format) {mGlyphFormat = format;}
+                void logMemoryReport() const;
                 
-                GlyphInfo rasterizeGlyph(msdfgen::FontHandle* font, uint32_t codepoint);
+                GlyphInfo rasterizeGlyph(msdfgen::FontHandle* font, uint32_t codepoint, GlyphFormat format = GlyphFormat::MSDF);
+                // Rasterizes [first, last) on the job workers, each through its own FreeType face.
+                std::vector<GlyphInfo> rasterizeGlyphs(const std::string& fontPath, uint32_t first, uint32_t last, GlyphFormat format = GlyphFormat::MSDF);
+
+                // FreeType isn't thread-safe, so every thread opens the fonts it rasterizes with its own library.
+                static msdfgen::FontHandle* getThreadFontHandle(const std::string& fontPath);
 
                 ke::Graphics::Text::Font& getFont(const std::string& fontname);
+                static unsigned int getGlyphSize() {return GLYPH_SIZE;}
+                // Pixels per em that glyphs are rasterized at, GlyphInfo metrics are in these pixels.
+                static float getRasterEmSize() {return static_cast<float>(GLYPH_SIZE - 4);}
             private:
                 TextUtils() = default;
 
@@ -122,6 +197,8 @@ namespace ke
 
                 std::unordered_map<std::string, std::unique_ptr<Font>> mFonts;
                 static const unsigned int GLYPH_SIZE = 32;
+                GlyphFormat mGlyphFormat = GlyphFormat::MSDF;
+                uint64_t mFrame = 0;
 
             };
 
@@ -129,14 +206,34 @@ namespace ke
             {
             public:
                 TextInstance(const std::string& text, const std::string& font, int x, int y, glm::vec4 color, int pixelSize);
+                // (x, y) is the start of the first line's baseline.
+                TextInstance(const std::string& text, const std::string& font, int x, int y, glm::vec4 color, const TextStyle& style);
                 TextInstance() = default;
                 
                 void Draw() const;
 
             private:
-                std::vector<GlyphInstance> mInstances;
-                util::Buffer mInstanceBuffer;
-                uint32_t mFontIndex;
+                struct PageUse
+                {
+                    uint16_t page;
+                    uint32_t generation;
+                };
+
+                bool isStale() const;
+                void build() const;
+
+                std::string mText;
+                Font* mFont = nullptr;
+                int mX = 0, mY = 0;
+                glm::vec4 mColor{};
+                TextStyle mStyle;
+
+                // Rebuilt from Draw when glyphs that were still rasterizing arrive or a page they used was evicted.
+                mutable std::shared_ptr<const ShapedRun> mRun;
+                mutable std::vector<GlyphInstance> mInstances;
+                mutable std::vector<PageUse> mPages;
+                mutable uint64_t mFontVersion = 0;
+                mutable bool mComplete = false;
             };
             
         }
@@ -1,34 +1,57 @@
 #include "Texture.hpp"
+#include "../Utility/JobSystem.hpp"
 #include <filesystem>
 
 void ke::Graphics::Texture::TextureManager::init()
+{
+    decodeTextures();
+    uploadTextures();
+}
+
+void ke::Graphics::Texture::TextureManager::decodeTextures()
 {
     const std::filesystem::path targetPath{"./src/Textures"};
 
+    std::vector<std::filesystem::path> paths;
     try
     {
         for(const auto& direntry : std::filesystem::directory_iterator(targetPath))
-        {
-            createTexture(direntry.path().filename().stem().string(), direntry.path());
-        }
+            paths.push_back(direntry.path());
     }catch(std::filesystem::filesystem_error& err) {std::cout << err.what() << std::endl;}
+
+    // Directory order, so texture indices stay the same as when they were loaded one by one.
+    mDecoded.resize(paths.size());
+    util::JobSystem::getInstance().parallelFor(static_cast<uint32_t>(paths.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for(uint32_t i = begin; i < end; i++)
+            mDecoded[i] = {paths[i].stem().string(), Renderer::getInstance().decodeTextureImage(paths[i].string())};
+    }, "DecodeTexture");
+}
+
+void ke::Graphics::Texture::TextureManager::uploadTextures()
+{
+    for(auto& [name, decoded] : mDecoded)
+        createTexture(name, decoded);
+    mDecoded.clear();
 }
 
 void ke::Graphics::Texture::TextureManager::createTexture(const std::string &name, const std::string &filepath)
+{
+    createTexture(std::filesystem::path(filepath).stem().string(), Renderer::getInstance().decodeTextureImage(filepath));
+}
+
+void ke::Graphics::Texture::TextureManager::createTexture(const std::string &name, const util::DecodedImage& decoded)
 {
     size_t textureIndex = mTextureList.size();
 
-    mTextureList.emplace_back(filepath);
+    mTextureList.emplace_back(decoded);
     
     ke::Graphics::Renderer& renderer = ke::Graphics::Renderer::getInstance();
 
     if(renderer.addTextureToDescriptor(mTextureList[textureIndex].getImage()) != textureIndex)
         std::cout << "Texture index mismatch!";
 
-    std::filesystem::path path(filepath);
-    std::string filename = path.stem().string();
-
-    mIndexMap[filename] = textureIndex;
+    mIndexMap[name] = textureIndex;
 }
 
 uint32_t ke::Graphics::Texture::TextureManager::getTextureIndex(std::string name) const
@@ -57,10 +80,15 @@ void ke::Graphics::Texture::TextureManager::terminate()
 }
 
 ke::Graphics::Texture::Texture::Texture(const std::string &filepath)
+    : Texture(ke::Graphics::Renderer::getInstance().decodeTextureImage(filepath))
+{
+}
+
+ke::Graphics::Texture::Texture::Texture(const util::DecodedImage& decoded)
 {
     ke::Graphics::Renderer& renderer = ke::Graphics::Renderer::getInstance();
 
-    renderer.createTextureImage(filepath, mImage);
+    renderer.createTextureImage(decoded, mImage);
     renderer.createTextureImageView(mImage);
 
     mImage.setDevice(renderer.getDevice());
@@ -14,6 +14,7 @@ namespace ke
             public:
                 Texture() = default;
                 Texture(const std::string& filepath);
+                Texture(const util::DecodedImage& decoded);
 
                 const util::Image& getImage() const;
                 VkImageView getImageView() const;
@@ -39,9 +40,12 @@ namespace ke
                 }
 
                 void init();
-
+                // init in two halves: decoding every file runs on job workers, the upload needs the render thread.
+                void decodeTextures();
+                void uploadTextures();
 
                 void createTexture(const std::string& name, const std::string& filepath);
+                void createTexture(const std::string& name, const util::DecodedImage& decoded);
                 uint32_t getTextureIndex(std::string name) const;
                 const Texture& getTexture(uint32_t index) const;
 
@@ -52,6 +56,7 @@ namespace ke
 
                 std::vector<Texture> mTextureList;
                 std::unordered_map<std::string, uint32_t> mIndexMap;
+                std::vector<std::pair<std::string, util::DecodedImage>> mDecoded;
                 
             };
         }
@@ -7,9 +7,9 @@ static void keyCallback(GLFWwindow* window, int key, int scancode, int action, i
 {
 	auto& self = *(ke::Graphics::Window*)glfwGetWindowUserPointer(window);
 	
-	if(action == GLFW_PRESS)
+	if(action == GLFW_PRESS || action == GLFW_REPEAT)
 	{
-		ke::Events::KeyPressedEvent event{key, false};
+		ke::Events::KeyPressedEvent event{key, action == GLFW_REPEAT, mods};
 		self.event(event);
 	}
 	else if(action == GLFW_RELEASE)
@@ -24,7 +24,7 @@ static void charCallback(GLFWwindow* window, unsigned int codepoint)
 {
 	auto& self = *(ke::Graphics::Window*)glfwGetWindowUserPointer(window);
 
-	ke::Events::TextInputEvent ev((char)codepoint);
+	ke::Events::TextInputEvent ev(codepoint);
 	self.event(ev);
 }
 
@@ -1,69 +1,26 @@
 #include "InterfaceManager.hpp"
 #include "SceneManager.hpp"
+#include "Utility/Profiler.hpp"
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tinyobjloader/tiny_obj_loader.h>
+#include <algorithm>
+#include <cmath>
 #include <filesystem>
 
 std::unordered_map<std::string, std::function<void()>> ke::gui::Component::mHandlers = 
 {
     
 };
-ke::gui::Component::Component(std::string filepath)
-    : mIndexBuffer(Graphics::Renderer::getInstance().getDevice()), mVertexBuffer(Graphics::Renderer::getInstance().getDevice())
+ke::gui::Component::Component(std::string filepath, glm::ivec2 framebufferSize)
 {
-    static util::XML parser = util::XML::getInstance();
+    static util::XML& parser = util::XML::getInstance();
 
-    parser.parseFile(filepath, mFrames);
+    parser.parseFile(filepath, mFrames, mLayout);
     
-    int indexAdvance = 0;
     for(const auto& obj : mFrames)
     {
-        float x = obj->x;
-        x *= 2.0f;
-        x -= 1.0f;
-        float y = obj->y;
-        y *= 2.0f;
-        y -= 1.0f;
-        float w = obj->w;
-        w *= 2.0f;
-        float h = obj->h;
-        h *= 2.0f;
-
-        mVertices.push_back({{x, y + h}, {obj->color.r, obj->color.g, obj->color.b}, {0.0f, 0.0f}});
-        mVertices.push_back({{x, y}, {obj->color.r, obj->color.g, obj->color.b}, {0.0f, 0.0f}});
-        mVertices.push_back({{x + w, y}, {obj->color.r, obj->color.g, obj->color.b}, {0.0f, 0.0f}});
-        mVertices.push_back({{x + w, y + h}, {obj->color.r, obj->color.g, obj->color.b}, {0.0f, 0.0f}});
-
-        mIndices.push_back(0 + indexAdvance);
-        mIndices.push_back(1 + indexAdvance);
-        mIndices.push_back(2 + indexAdvance);
-        mIndices.push_back(0 + indexAdvance);
-        mIndices.push_back(2 + indexAdvance);
-        mIndices.push_back(3 + indexAdvance);
-
-        indexAdvance += 4;
-
         if(obj->getType() == gui::InputField::getStaticType())
-        {
-            gui::InputField* field = dynamic_cast<gui::InputField*>(obj.get());
-
-            int pixelX, pixelY, pixelH;
-            
-            ke::Graphics::Renderer& rend = ke::Graphics::Renderer::getInstance();
-            glm::ivec2 dimensions = rend.getSwapchainDimensions();
-
-            pixelX = obj->x * dimensions.x + 5;
-            pixelH = obj->h * dimensions.y;
-            pixelY = obj->y * dimensions.y + pixelH * 0.3;
-
-
-            InputValue value = field->getValue();
-            ke::Graphics::Text::TextInstance textInstance = ke::Graphics::Text::TextInstance(value.val, "DejaVuSans", pixelX, pixelY, glm::vec4(value.color.r, value.color.g, value.color.b, 1.0f), pixelH);
-
-            field->setTextInstance(textInstance);
-
-            mInputFields.push_back(field);
-        }
+            mInputFields.push_back(dynamic_cast<gui::InputField*>(obj.get()));
 
         if(obj->getType() == gui::Button::getStaticType())
         {
@@ -80,61 +37,61 @@ ke::gui::Component::Component(std::string filepath)
             pExplorerElement = dynamic_cast<gui::Explorer*>(obj.get());
     }
 
-    
+    relayout(framebufferSize);
+}
 
-    VkDeviceSize verticesSize = sizeof(mVertices[0]) * mVertices.size();
-    VkDeviceSize indicesSize = sizeof(mIndices[0]) * mIndices.size();
+uint32_t ke::gui::Component::relayout(glm::ivec2 framebufferSize)
+{
+    if(!mLayout || framebufferSize.x <= 0 || framebufferSize.y <= 0) return 0;
 
-    Graphics::Renderer& rend = Graphics::Renderer::getInstance();
+    uint32_t visited = mLayout->layout(gui::LayoutRect{0.0f, 0.0f, 1.0f, 1.0f}, glm::vec2(framebufferSize));
 
-    rend.createVertexBuffer(mVertices, mVertexBuffer.buffer, mVertexBuffer.bufferMemory);
-    rend.createIndexBuffer(mIndices, mIndexBuffer.buffer, mIndexBuffer.bufferMemory);
-}
+    // Text is placed in pixels, so it follows the window even where the normalized rect stayed put.
+    for(gui::InputField* field : mInputFields)
+    {
+        int pixelX = field->x * framebufferSize.x + 5;
+        int pixelH = field->h * framebufferSize.y;
+        int pixelY = field->y * framebufferSize.y + pixelH * 0.3;
 
+        field->layoutText(pixelX, pixelY, pixelH);
+    }
 
-ke::gui::Component::~Component()
-{
+    return visited;
 }
 
-bool isBetween(int point, int bLimit, int tLimit)
+void ke::gui::Component::writeQuad(const gui::Element& element)
 {
-    return point > bLimit && point < tLimit;
-}
-bool ke::gui::Component::pollButtonClick(int mouseX, int mouseY, int windowX, int windowY) 
-{
-    for(auto& button : mButtons)
-    {
-        if(isBetween(mouseX, windowX * button->x, windowX * button->x + windowX * button->w) && isBetween(windowY - mouseY, windowY * button->y, windowY * button->y + windowY * button->h))
-        {
-            button->onClick();
-            return true;
-        }
-    }
-    return false;
+    float x = element.x * 2.0f - 1.0f;
+    float y = element.y * 2.0f - 1.0f;
+    float w = element.w * 2.0f;
+    float h = element.h * 2.0f;
+    glm::vec3 color = element.color;
+
+    pQuads->setQuad(mQuadBase + element.getQuad(), {
+        util::str::Vertex2P3C2T{{x, y + h}, color, {0.0f, 0.0f}},
+        util::str::Vertex2P3C2T{{x, y}, color, {0.0f, 0.0f}},
+        util::str::Vertex2P3C2T{{x + w, y}, color, {0.0f, 0.0f}},
+        util::str::Vertex2P3C2T{{x + w, y + h}, color, {0.0f, 0.0f}},
+    });
 }
 
-ke::gui::Element *ke::gui::Component::pollInputFocus(int mouseX, int mouseY, int windowX, int windowY)
+ke::gui::Component::~Component()
 {
-    for(auto& inputField : mInputFields)
-    {
-        if(isBetween(mouseX, windowX * inputField->x, windowX * inputField->x + windowX * inputField->w) && isBetween(windowY - mouseY, windowY * inputField->y, windowY * inputField->y + windowY * inputField->h))
-        {
-            return inputField;
-        }
-    }
-
-    return nullptr;
 }
 
 ke::gui::Component::Component(Component&& other) noexcept
     : mFrames(std::move(other.mFrames)),
       mButtons(std::move(other.mButtons)),
-      mIndexBuffer(std::move(other.mIndexBuffer)), 
-      mVertexBuffer(std::move(other.mVertexBuffer)),
-      mIndices(std::move(other.mIndices)),
-      mVertices(std::move(other.mVertices)),
+      mInputFields(std::move(other.mInputFields)),
+      mLayout(std::move(other.mLayout)),
+      pQuads(other.pQuads),
+      mQuadBase(other.mQuadBase),
+      mDirtyElements(std::move(other.mDirtyElements)),
+      pHitGrid(other.pHitGrid),
       pExplorerElement(other.pExplorerElement)
 {
+    for(uint32_t i = 0; i < mFrames.size(); i++)
+        mFrames[i]->setDirtyList(&mDirtyElements, i);
 }
 
 ke::gui::Component& ke::gui::Component::operator=(Component&& other) noexcept
@@ -143,29 +100,70 @@ ke::gui::Component& ke::gui::Component::operator=(Component&& other) noexcept
     {
         mFrames = std::move(other.mFrames);
         mButtons = std::move(other.mButtons);
-        mIndexBuffer = std::move(other.mIndexBuffer);
-        mVertexBuffer = std::move(other.mVertexBuffer);
-        mIndices = std::move(other.mIndices);
-        mVertices = std::move(other.mVertices);
+        mInputFields = std::move(other.mInputFields);
+        mLayout = std::move(other.mLayout);
+        pQuads = other.pQuads;
+        mQuadBase = other.mQuadBase;
+        mDirtyElements = std::move(other.mDirtyElements);
+        pHitGrid = other.pHitGrid;
         pExplorerElement = other.pExplorerElement;
+
+        for(uint32_t i = 0; i < mFrames.size(); i++)
+            mFrames[i]->setDirtyList(&mDirtyElements, i);
     }
     return *this;
 }
-void ke::gui::Component::Draw(VkCommandBuffer commandBuffer)
-{
-    ke::Graphics::Renderer::getInstance().pickTextureIndex(-1);
-    
-    VkBuffer vertexBuffers[] = {mVertexBuffer.buffer};
-    VkDeviceSize offsets[] = {0};
 
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+uint32_t ke::gui::Component::getQuadCount() const
+{
+    uint32_t count = static_cast<uint32_t>(mFrames.size());
+    if(pExplorerElement) count += pExplorerElement->getRowCapacity();
+    return count;
+}
 
-    vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer.buffer, 0, VK_INDEX_TYPE_UINT32);
+void ke::gui::Component::bindQuads(Graphics::QuadBuffer& quads, uint32_t base)
+{
+    pQuads = &quads;
+    mQuadBase = base;
 
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(mIndices.size()), 1, 0, 0, 0);
+    mDirtyElements.clear();
+    for(uint32_t i = 0; i < mFrames.size(); i++)
+    {
+        mFrames[i]->clearDirty();
+        mFrames[i]->setDirtyList(&mDirtyElements, i);
+        mFrames[i]->markDirty();
+    }
 
     if(pExplorerElement)
-        pExplorerElement->DrawGeometry();
+        pExplorerElement->bindQuads(quads, base + static_cast<uint32_t>(mFrames.size()));
+}
+
+bool ke::gui::Component::update()
+{
+    if(pQuads == nullptr) return false;
+
+    // Nothing to do here unless an element changed since the last update.
+    for(gui::Element* element : mDirtyElements)
+    {
+        writeQuad(*element);
+        element->clearDirty();
+        if(pHitGrid) pHitGrid->update(element);
+        if(element->getType() == gui::Explorer::getStaticType())
+            dynamic_cast<gui::Explorer*>(element)->invalidateGeometry();
+    }
+    mDirtyElements.clear();
+
+    return pExplorerElement == nullptr || pExplorerElement->update();
+}
+
+void ke::gui::Component::registerHitTargets(HitGrid& grid)
+{
+    pHitGrid = &grid;
+
+    for(gui::Button* button : mButtons)
+        grid.insert(button);
+    for(gui::InputField* field : mInputFields)
+        grid.insert(field);
 }
 
 void ke::gui::Component::DrawText()
@@ -188,8 +186,24 @@ bool ke::gui::Component::getInputFieldValue(const std::string &name, std::string
     return false;
 }
 
-void ke::gui::UImanager::loadComponents(GLFWwindow* window)
+void ke::gui::UImanager::preloadComponents()
+{
+    KE_PROFILE_FUNCTION();
+    const std::filesystem::path targetPath{"./src/UI/"};
+
+    // Only the XML parse, building the components creates GPU buffers and is left to loadComponents.
+    try
+    {
+        for(auto const& direntry : std::filesystem::directory_iterator{targetPath})
+            if(std::filesystem::is_regular_file(direntry.path()))
+                util::XML::getInstance().preloadFile(direntry.path().string());
+    }catch(std::filesystem::filesystem_error const& err)
+        {std::cout << "Error while reading directory: " << err.what() << std::endl;}
+}
+
+void ke::gui::UImanager::loadComponents(glm::ivec2 framebufferSize)
 {   
+    KE_PROFILE_FUNCTION();
     const std::filesystem::path targetPath{"./src/UI/"};
 
     try
@@ -199,29 +213,71 @@ void ke::gui::UImanager::loadComponents(GLFWwindow* window)
             if(!std::filesystem::is_regular_file(direntry.path())) continue;
 
             if(direntry.path().filename().string() != "scene.xml")
-                mComponents.push_back(std::make_unique<Component>(direntry.path().string()));
+                mComponents.push_back(std::make_unique<Component>(direntry.path().string(), framebufferSize));
             else
             {
                 sceneComponentFilepath = direntry.path().string();
-                mSceneComponent = SceneComponent(sceneComponentFilepath, window);
+                mSceneComponent = SceneComponent(sceneComponentFilepath, framebufferSize);
             }
                 
         }
     }catch(std::filesystem::filesystem_error const& err)
         {std::cout << "Error while reading directory: " << err.what() << std::endl;}
-    
+
+    mRepack = true;
+
+    mHitGrid.clear();
+    for(auto& comp : mComponents)
+        comp->registerHitTargets(mHitGrid);
+}
+
+void ke::gui::UImanager::packComponents()
+{
+    uint32_t base = 0;
+    for(auto& comp : mComponents)
+    {
+        comp->bindQuads(mQuads, base);
+        base += comp->getQuadCount();
+    }
+
+    mQuads.resize(base);
+    mRepack = false;
+
+    mLogger.info("Packed {} components into {} quads.", mComponents.size(), base);
 }
 
 void ke::gui::UImanager::drawComponents(VkCommandBuffer commandBuffer)
 {
+    KE_PROFILE_FUNCTION();
+    ke::Graphics::Renderer& rend = ke::Graphics::Renderer::getInstance();
+
+    if(mRepack) packComponents();
+
+    bool fits = true;
     for(auto& comp : mComponents)
+        fits = comp->update() && fits;
+
+    // A component grew past its range, lay everything out again. Rebinding rewrites every quad.
+    if(!fits)
     {
-        comp->Draw(commandBuffer);
+        packComponents();
+        for(auto& comp : mComponents)
+            comp->update();
     }
+
+    uint32_t slot = rend.getCurrentFrameInFlight();
+    mQuads.sync(slot);
+    if(mQuads.getQuadCount() == 0 || !mQuads.bind(commandBuffer, slot)) return;
+
+    // Frames are flat colored quads, so every component shares the untextured pipeline and one draw.
+    rend.pickTextureIndex(-1);
+    mQuads.drawRange(commandBuffer, 0, mQuads.getQuadCount());
+    rend.countDrawCall(2);
 }
 
 void ke::gui::UImanager::drawComponentTextLabels()
 {
+    KE_PROFILE_FUNCTION();
     for(auto& comp : mComponents)
     {
         comp->DrawText();
@@ -232,11 +288,29 @@ void ke::gui::UImanager::unloadComponents()
 {
     vkDeviceWaitIdle(Graphics::Renderer::getInstance().getDevice());
     mComponents.clear();
+    mHitGrid.clear();
+    pHoveredButton = nullptr;
+    pFocusedElement = nullptr;
+    mFocused = false;
+    mQuads.destroy();
+    mQuads.resize(0);
+    mRepack = true;
 }
 
-void ke::gui::UImanager::recreateSceneComponent(GLFWwindow *window)
+void ke::gui::UImanager::recreateSceneComponent(glm::ivec2 framebufferSize)
 {
-    mSceneComponent = SceneComponent(sceneComponentFilepath, window);
+    KE_PROFILE_FUNCTION();
+    mSceneComponent.relayout(framebufferSize);
+
+    uint32_t visited = 0;
+    size_t total = 0;
+    for(auto& comp : mComponents)
+    {
+        visited += comp->relayout(framebufferSize);
+        total += comp->getLayoutNodeCount();
+    }
+
+    mLogger.debug("Relayout visited {} of {} nodes.", visited, total);
 }
 
 glm::ivec2 ke::gui::UImanager::getSceneComponentPosition() const
@@ -249,89 +323,93 @@ glm::ivec2 ke::gui::UImanager::getSceneComponentExtent() const
     return mSceneComponent.extent;
 }
 
-void ke::gui::UImanager::processMouseClick(int mouseX, int mouseY, int windowX, int windowY)
+void ke::gui::UImanager::processMouseClick(int mouseX, int mouseY, int windowX, int windowY, int framebufferX)
 {
-    bool changedFocus = false;
-    for(auto& component : mComponents)
+    if(windowX <= 0 || windowY <= 0) return;
+
+    float x = static_cast<float>(mouseX) / windowX;
+    float y = static_cast<float>(windowY - mouseY) / windowY;
+
+    gui::Element* button = mHitGrid.pick(x, y, gui::Button::getStaticType());
+    if(button)
     {
-        component->pollButtonClick(mouseX, mouseY, windowX, windowY);
-        if(!changedFocus)
-        {
-            pFocusedElement = component->pollInputFocus(mouseX, mouseY, windowX, windowY);
-            if(pFocusedElement != nullptr) changedFocus = true;
-        }
+        gui::Button* pressed = dynamic_cast<gui::Button*>(button);
+        if(pressed->onClick) pressed->onClick();
     }
 
-    if(pFocusedElement == nullptr) mFocused = false;
-    else mFocused = true;
-}
+    gui::Element* previous = pFocusedElement;
+    pFocusedElement = mHitGrid.pick(x, y, gui::InputField::getStaticType());
 
-void ke::gui::UImanager::processKeyboardInput(char codepoint)
-{
-    static ke::Graphics::Renderer& rend = ke::Graphics::Renderer::getInstance();
+    if(previous != pFocusedElement && previous != nullptr && previous->getType() == gui::InputField::getStaticType())
+        dynamic_cast<gui::InputField*>(previous)->setFocused(false);
 
-    if(pFocusedElement != nullptr)
+    if(pFocusedElement != nullptr && pFocusedElement->getType() == gui::InputField::getStaticType())
     {
-        if(pFocusedElement->getType() == gui::InputField::getStaticType())
-        {
-            gui::InputField* field = dynamic_cast<gui::InputField*>(pFocusedElement);
-
-            std::string currentFieldValue = field->getRawValue();
-
-            std::string newValue = currentFieldValue + codepoint;
-            field->setValue(newValue);
+        gui::InputField* field = dynamic_cast<gui::InputField*>(pFocusedElement);
+        field->setFocused(true);
+        field->getEditor().setCaret(field->getEditor().hitTest(x * static_cast<float>(framebufferX)));
+    }
 
-            glm::ivec2 screenDimensions = rend.getSwapchainDimensions();
+    if(pFocusedElement == nullptr) mFocused = false;
+    else mFocused = true;
+}
 
-            int pixelX, pixelY, pixelH;
+void ke::gui::UImanager::processMouseMove(int mouseX, int mouseY, int windowX, int windowY)
+{
+    if(windowX <= 0 || windowY <= 0) return;
 
-            pixelX = field->x * screenDimensions.x + 5;
-            pixelH = field->h * screenDimensions.y;
-            pixelY = field->y * screenDimensions.y + pixelH * 0.3;
+    float x = static_cast<float>(mouseX) / windowX;
+    float y = static_cast<float>(windowY - mouseY) / windowY;
 
-            gui::InputValue inputValue = field->getValue();
-            ke::Graphics::Text::TextInstance instance(inputValue.val, "DejaVuSans", pixelX, pixelY, glm::vec4(inputValue.color.r, inputValue.color.g, inputValue.color.b, 1.0f), pixelH );
+    gui::Button* hovered = dynamic_cast<gui::Button*>(mHitGrid.pick(x, y, gui::Button::getStaticType()));
+    if(hovered == pHoveredButton) return;
 
-            field->setTextInstance(instance);
-        }
+    // Only the two buttons involved get their quads rewritten.
+    if(pHoveredButton) pHoveredButton->setColor(mHoveredColor);
+    pHoveredButton = hovered;
+    if(pHoveredButton)
+    {
+        mHoveredColor = pHoveredButton->color;
+        pHoveredButton->setColor(glm::min(mHoveredColor * 1.25f + glm::vec3(0.05f), glm::vec3(1.0f)));
     }
 }
 
-bool ke::gui::UImanager::processFunctionalKey(int key)
+void ke::gui::UImanager::processKeyboardInput(uint32_t codepoint)
 {
-    ke::Graphics::Renderer& rend = ke::Graphics::Renderer::getInstance();
-
-    if(key == GLFW_KEY_BACKSPACE && pFocusedElement != nullptr)
+    if(pFocusedElement != nullptr)
     {
         if(pFocusedElement->getType() == gui::InputField::getStaticType())
         {
             gui::InputField* field = dynamic_cast<gui::InputField*>(pFocusedElement);
 
-            std::string currentFieldValue = field->getRawValue();
-
-            if(currentFieldValue.length() == 0) return true;
-            
-            currentFieldValue.pop_back();
-            field->setValue(currentFieldValue);
-
-            glm::ivec2 screenDimensions = rend.getSwapchainDimensions();
-
-            int pixelX, pixelY, pixelH;
+            // Patches the field's glyphs in place, nothing is rebuilt or uploaded.
+            field->getEditor().insert(codepoint);
+        }
+    }
+}
 
-            pixelX = field->x * screenDimensions.x + 5;
-            pixelH = field->h * screenDimensions.y;
-            pixelY = field->y * screenDimensions.y + pixelH * 0.3;
+bool ke::gui::UImanager::processFunctionalKey(int key, int mods)
+{
+    if(pFocusedElement == nullptr || pFocusedElement->getType() != gui::InputField::getStaticType())
+        return false;
 
-            gui::InputValue inputValue = field->getValue();
-            ke::Graphics::Text::TextInstance instance(inputValue.val, "DejaVuSans", pixelX, pixelY, glm::vec4(inputValue.color.r, inputValue.color.g, inputValue.color.b, 1.0f), pixelH );
+    Graphics::Text::EditableText& editor = dynamic_cast<gui::InputField*>(pFocusedElement)->getEditor();
+    bool shift = mods & GLFW_MOD_SHIFT;
 
-            field->setTextInstance(instance);
+    switch(key)
+    {
+        case GLFW_KEY_BACKSPACE: editor.eraseBackward(); return true;
+        case GLFW_KEY_DELETE: editor.eraseForward(); return true;
+        case GLFW_KEY_LEFT: editor.moveCaret(-1, shift); return true;
+        case GLFW_KEY_RIGHT: editor.moveCaret(1, shift); return true;
+        case GLFW_KEY_HOME: editor.setCaret(0, shift); return true;
+        case GLFW_KEY_END: editor.setCaret(editor.getLength(), shift); return true;
+        case GLFW_KEY_A:
+            if(!(mods & GLFW_MOD_CONTROL)) return false;
+            editor.selectAll();
             return true;
-        }
+        default: return false;
     }
-
-    return false;
-
 }
 
 std::string ke::gui::UImanager::getInputFieldValue(const std::string& name) const
@@ -345,20 +423,29 @@ std::string ke::gui::UImanager::getInputFieldValue(const std::string& name) cons
     return value;
 }
 
-ke::gui::SceneComponent::SceneComponent(std::string filepath, GLFWwindow* window)
+ke::gui::SceneComponent::SceneComponent(std::string filepath, glm::ivec2 framebufferSize)
 {
-    static util::XML parser = util::XML::getInstance();
+    static util::XML& parser = util::XML::getInstance();
 
-    int x, y;
-    glfwGetFramebufferSize(window, &x, &y);
+    parser.parseSceneFile(filepath, mLayout, pSceneView);
+    relayout(framebufferSize);
+}
 
-    parser.parseSceneFile(filepath, pos, extent, x, y);
+void ke::gui::SceneComponent::relayout(glm::ivec2 framebufferSize)
+{
+    if(!mLayout || !pSceneView || framebufferSize.x <= 0 || framebufferSize.y <= 0) return;
+
+    mLayout->layout(gui::LayoutRect{0.0f, 0.0f, 1.0f, 1.0f}, glm::vec2(framebufferSize));
+
+    const gui::LayoutRect& rect = pSceneView->getRect();
+    pos = {static_cast<int>(std::round(framebufferSize.x * rect.x)), static_cast<int>(std::round(framebufferSize.y * rect.y))};
+    extent = {static_cast<int>(std::round(framebufferSize.x * rect.w)), static_cast<int>(std::round(framebufferSize.y * rect.h))};
 }
 
 ke::gui::SceneComponent::SceneComponent(SceneComponent &&other) noexcept
-    :pos(other.pos), extent(other.extent)
+    :pos(other.pos), extent(other.extent), mLayout(std::move(other.mLayout)), pSceneView(other.pSceneView)
 {
-
+    other.pSceneView = nullptr;
 }
 
 ke::gui::SceneComponent &ke::gui::SceneComponent::operator=(SceneComponent &&other) noexcept
@@ -367,7 +454,9 @@ ke::gui::SceneComponent &ke::gui::SceneComponent::operator=(SceneComponent &&oth
 
     pos = other.pos;
     extent = other.extent;
+    mLayout = std::move(other.mLayout);
+    pSceneView = other.pSceneView;
+    other.pSceneView = nullptr;
 
     return *this;
 }
-    
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "./Utility/XMLparser.hpp"
 #include "./Utility/RenderUtil.hpp"
+#include "./Utility/HitGrid.hpp"
 #include "./Utility/structs.hpp"
 #include "./Graphics/Renderer.hpp"
 #include "./Graphics/TextUtilities.hpp"
@@ -18,30 +19,43 @@ namespace ke
         {
         public:
             Component() = default;
-            Component(std::string filepath);
+            Component(std::string filepath, glm::ivec2 framebufferSize);
             ~Component();
 
-            bool pollButtonClick(int mouseX, int mouseY, int windowX, int windowY);
-            Element* pollInputFocus(int mouseX, int mouseY, int windowX, int windowY);
-
             Component(Component&& other) noexcept;
             ke::gui::Component& operator=(Component&& other) noexcept;
             
-            void Draw(VkCommandBuffer commandBuffer);
             void DrawText();
 
+            // Runs the layout tree for a new framebuffer size, returns how many nodes it had to visit.
+            uint32_t relayout(glm::ivec2 framebufferSize);
+            size_t getLayoutNodeCount() const {return mLayout ? mLayout->getNodeCount() : 0;}
+
             bool getInputFieldValue(const std::string& name, std::string& value);
+
+            // Quads this component needs in the shared buffer, frames first and then the explorer's rows.
+            uint32_t getQuadCount() const;
+            // Moves the component to [base, base + getQuadCount()) of the shared buffer and rewrites all of it.
+            void bindQuads(Graphics::QuadBuffer& quads, uint32_t base);
+            // Writes whatever changed since the last update, false if the component outgrew its range and needs rebinding.
+            bool update();
+
+            // Puts the buttons and input fields in the grid, which then follows their rects on each update.
+            void registerHitTargets(HitGrid& grid);
         private:
             std::vector<std::unique_ptr<gui::Element>> mFrames;
             std::vector<gui::Button*> mButtons;
             std::vector<gui::InputField*> mInputFields;
+            std::unique_ptr<gui::LayoutNode> mLayout;
             
-            util::Buffer mVertexBuffer;
-            util::Buffer mIndexBuffer;
+            void writeQuad(const gui::Element& element);
 
-            std::vector<util::str::Vertex2P3C2T> mVertices;
-            std::vector<uint32_t> mIndices;
+            // One quad per frame in the UI manager's buffer, rewritten only when its element is marked dirty.
+            Graphics::QuadBuffer* pQuads = nullptr;
+            uint32_t mQuadBase = 0;
+            std::vector<gui::Element*> mDirtyElements;
 
+            HitGrid* pHitGrid = nullptr;
             gui::Explorer* pExplorerElement = nullptr;
             
             static std::unordered_map<std::string, std::function<void()>> mHandlers;
@@ -51,7 +65,7 @@ namespace ke
         {
         public:
             SceneComponent() = default;
-            SceneComponent(std::string filepath, GLFWwindow* window);
+            SceneComponent(std::string filepath, glm::ivec2 framebufferSize);
             ~SceneComponent() = default;
 
             SceneComponent(SceneComponent&& other) noexcept;
@@ -59,10 +73,16 @@ namespace ke
 
             SceneComponent(const SceneComponent& other) = delete;
             ke::gui::SceneComponent& operator=(const SceneComponent& other) = delete;
+
+            // Recomputes pos and extent from the cached layout, the file is only read once.
+            void relayout(glm::ivec2 framebufferSize);
             
             glm::ivec2 pos;
             glm::ivec2 extent; 
 
+        private:
+            std::unique_ptr<gui::LayoutNode> mLayout;
+            gui::LayoutNode* pSceneView = nullptr;
         };
 
         class UImanager
@@ -73,20 +93,27 @@ namespace ke
                 return instance;
             }
             
-            void loadComponents(GLFWwindow* window);
+            void preloadComponents();
+            void loadComponents(glm::ivec2 framebufferSize);
             void drawComponents(VkCommandBuffer commandBuffer);
             void drawComponentTextLabels();
 
             void unloadComponents();
 
-            void recreateSceneComponent(GLFWwindow* window);
+            // Lays the scene view and every component out for a new framebuffer size. Only subtrees whose box
+            // changed are visited and only elements that moved get their quads rewritten.
+            void recreateSceneComponent(glm::ivec2 framebufferSize);
 
             glm::ivec2 getSceneComponentPosition() const;
             glm::ivec2 getSceneComponentExtent() const;
 
-            void processMouseClick(int mouseX, int mouseY, int windowX, int windowY);
-            void processKeyboardInput(char codepoint);
-            bool processFunctionalKey(int key);
+            // Mouse and window sizes in window coordinates, the framebuffer width places the caret in pixels.
+            void processMouseClick(int mouseX, int mouseY, int windowX, int windowY, int framebufferX);
+            // Highlights the button under the cursor, cheap enough to run for every cursor event.
+            void processMouseMove(int mouseX, int mouseY, int windowX, int windowY);
+            void processKeyboardInput(uint32_t codepoint);
+            // Editing keys for the focused input field, mods are GLFW_MOD_* bits.
+            bool processFunctionalKey(int key, int mods);
 
             bool isFocused() const {return mFocused;}
             std::string getInputFieldValue(const std::string& name) const;
@@ -94,12 +121,26 @@ namespace ke
         private:
             UImanager() = default;
 
+            // Lays the components out back to back in mQuads.
+            void packComponents();
+
+            util::Logger mLogger = util::Logger("UI Manager Logger");
+
             bool mFocused = false;
             gui::Element* pFocusedElement = nullptr;
 
+            // Clickable elements of every component, queried instead of scanning each component's lists.
+            HitGrid mHitGrid;
+            gui::Button* pHoveredButton = nullptr;
+            glm::vec3 mHoveredColor{};   // its color before the highlight
+
             std::vector<std::unique_ptr<Component>> mComponents;
             SceneComponent mSceneComponent;
 
+            // Every component's quads, so the whole UI is one buffer bind and one draw.
+            Graphics::QuadBuffer mQuads;
+            bool mRepack = true;
+
             std::string sceneComponentFilepath;
         };
     }
@@ -0,0 +1,192 @@
+#include "NodePool.hpp"
+#include "Object.hpp"
+
+#include <map>
+#include <new>
+
+namespace
+{
+    const char* getTypeName(ke::nodes::ObjectType type)
+    {
+        switch(type)
+        {
+            case ke::nodes::ObjectType::ROOT: return "Root";
+            case ke::nodes::ObjectType::SCENE: return "Scene";
+            case ke::nodes::ObjectType::RECT2D: return "Rect2D";
+            case ke::nodes::ObjectType::CIRCLE: return "Circle";
+            case ke::nodes::ObjectType::PHYSICSOBJECT2D: return "PhysicsObject2D";
+            case ke::nodes::ObjectType::PHYSICSOBJECT3D: return "PhysicsObject3D";
+            default: return "Unknown";
+        }
+    }
+
+    constexpr std::align_val_t SLAB_ALIGNMENT{64};
+}
+
+ke::nodes::NodePool& ke::nodes::NodePool::getInstance()
+{
+    // Never destroyed: RootObject is a static too and releases its children from its own destructor,
+    // which may run after this pool's would have.
+    static NodePool* instance = new NodePool();
+    return *instance;
+}
+
+ke::nodes::NodePool::NodePool()
+{
+    for(uint32_t objectSize : {64u, 128u, 256u, 512u, 1024u})
+        mClasses.push_back(SizeClass{objectSize, objectSize + static_cast<uint32_t>(sizeof(SlotHeader))});
+}
+
+void* ke::nodes::NodePool::allocate(size_t size)
+{
+    for(uint16_t classIndex = 0; classIndex < mClasses.size(); classIndex++)
+    {
+        SizeClass& sizeClass = mClasses[classIndex];
+        if(size > sizeClass.objectSize) continue;
+
+        if(sizeClass.freeHead == UINT32_MAX) addSlab(sizeClass, classIndex);
+
+        SlotHeader* header = getSlot(sizeClass, sizeClass.freeHead);
+        sizeClass.freeHead = header->nextFree;
+        header->alive = 1;
+        sizeClass.live++;
+
+        return header + 1;
+    }
+
+    // Bigger than any class, still gets a header so deallocate can tell it apart.
+    SlotHeader* header = static_cast<SlotHeader*>(::operator new(size + sizeof(SlotHeader)));
+    header->sizeClass = OVERSIZED;
+    header->alive = 0;
+    mOversizedLive++;
+    mOversizedBytes += size;
+
+    return header + 1;
+}
+
+void ke::nodes::NodePool::deallocate(void* memory, size_t size)
+{
+    if(memory == nullptr) return;
+
+    SlotHeader* header = static_cast<SlotHeader*>(memory) - 1;
+    if(header->sizeClass == OVERSIZED)
+    {
+        mOversizedLive--;
+        mOversizedBytes -= size;
+        ::operator delete(header);
+        return;
+    }
+
+    SizeClass& sizeClass = mClasses[header->sizeClass];
+    header->alive = 0;
+    header->generation++;
+    header->nextFree = sizeClass.freeHead;
+    sizeClass.freeHead = header->slot;
+    sizeClass.live--;
+}
+
+ke::nodes::NodeHandle ke::nodes::NodePool::getHandle(const DefaultObject* object) const
+{
+    // Only slab slots are known to have a header in front, the root and stack or oversized nodes don't.
+    const SlotHeader* header = findSlot(object);
+    if(header == nullptr || !header->alive) return NodeHandle{};
+
+    return NodeHandle{(static_cast<uint32_t>(header->sizeClass) << CLASS_SHIFT) | header->slot, header->generation};
+}
+
+ke::nodes::DefaultObject* ke::nodes::NodePool::resolve(NodeHandle handle) const
+{
+    if(!handle.isValid()) return nullptr;
+
+    uint32_t classIndex = handle.index >> CLASS_SHIFT;
+    uint32_t slot = handle.index & SLOT_MASK;
+    if(classIndex >= mClasses.size()) return nullptr;
+
+    const SizeClass& sizeClass = mClasses[classIndex];
+    if(slot >= sizeClass.slabs.size() * SLAB_SLOTS) return nullptr;
+
+    SlotHeader* header = getSlot(sizeClass, slot);
+    if(!header->alive || header->generation != handle.generation) return nullptr;
+
+    return reinterpret_cast<DefaultObject*>(header + 1);
+}
+
+const ke::nodes::NodePool::SlotHeader* ke::nodes::NodePool::findSlot(const void* object) const
+{
+    const std::byte* address = static_cast<const std::byte*>(object);
+    for(const SizeClass& sizeClass : mClasses)
+        for(const std::byte* slab : sizeClass.slabs)
+        {
+            // Compared as integers, relational operators between unrelated pointers are unspecified.
+            uintptr_t offset = reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(slab);
+            if(offset >= static_cast<uintptr_t>(sizeClass.stride) * SLAB_SLOTS) continue;
+            if(offset % sizeClass.stride != sizeof(SlotHeader)) return nullptr;
+
+            return reinterpret_cast<const SlotHeader*>(address) - 1;
+        }
+
+    return nullptr;
+}
+
+void ke::nodes::NodePool::addSlab(SizeClass& sizeClass, uint16_t classIndex)
+{
+    uint32_t firstSlot = static_cast<uint32_t>(sizeClass.slabs.size()) * SLAB_SLOTS;
+    std::byte* slab = static_cast<std::byte*>(::operator new(static_cast<size_t>(sizeClass.stride) * SLAB_SLOTS, SLAB_ALIGNMENT));
+    sizeClass.slabs.push_back(slab);
+
+    // Thread the new slots onto the free list in address order, so consecutive creates stay adjacent.
+    for(uint32_t i = SLAB_SLOTS; i-- > 0;)
+    {
+        SlotHeader* header = reinterpret_cast<SlotHeader*>(slab + i * sizeClass.stride);
+        header->slot = firstSlot + i;
+        header->sizeClass = classIndex;
+        header->alive = 0;
+        header->generation = 0;
+        header->nextFree = sizeClass.freeHead;
+        sizeClass.freeHead = header->slot;
+    }
+}
+
+std::vector<ke::nodes::NodePoolReport> ke::nodes::NodePool::getReport() const
+{
+    std::map<std::string, NodePoolReport> byType;
+
+    // Bytes are the slots the objects occupy, which is what each type actually costs.
+    for(const SizeClass& sizeClass : mClasses)
+        for(std::byte* slab : sizeClass.slabs)
+            for(uint32_t i = 0; i < SLAB_SLOTS; i++)
+            {
+                const SlotHeader* header = reinterpret_cast<const SlotHeader*>(slab + i * sizeClass.stride);
+                if(!header->alive) continue;
+
+                const DefaultObject* object = reinterpret_cast<const DefaultObject*>(header + 1);
+                NodePoolReport& report = byType[getTypeName(object->getType())];
+                report.count++;
+                report.bytes += sizeClass.stride;
+            }
+
+    std::vector<NodePoolReport> reports;
+    for(auto& [type, report] : byType)
+    {
+        report.type = type;
+        reports.push_back(report);
+    }
+    if(mOversizedLive > 0)
+        reports.push_back(NodePoolReport{"Oversized", mOversizedLive, mOversizedBytes});
+
+    return reports;
+}
+
+void ke::nodes::NodePool::logReport() const
+{
+    for(const SizeClass& sizeClass : mClasses)
+    {
+        if(sizeClass.slabs.empty()) continue;
+
+        size_t capacity = sizeClass.slabs.size() * SLAB_SLOTS;
+        mLogger.info("{:>5} B slots: {}/{} used, {} KiB reserved", sizeClass.objectSize, sizeClass.live, capacity, capacity * sizeClass.stride / 1024);
+    }
+
+    for(const NodePoolReport& report : getReport())
+        mLogger.info("{:<16} {:>6} nodes {:>8} B", report.type, report.count, report.bytes);
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../Utility/Logger.hpp"
+
+namespace ke
+{
+    namespace nodes
+    {
+        class DefaultObject;
+
+        /**
+         * @brief Stable reference to a pooled node.
+         * @details Stays valid across other nodes being created or destroyed, resolves to nullptr once its node is gone.
+         *
+         */
+        struct NodeHandle
+        {
+            uint32_t index = UINT32_MAX;
+            uint32_t generation = 0;
+
+            bool isValid() const {return index != UINT32_MAX;}
+            bool operator==(const NodeHandle& other) const = default;
+        };
+
+        /**
+         * @brief Memory used by one node type, as reported by NodePool::getReport().
+         *
+         */
+        struct NodePoolReport
+        {
+            std::string type;
+            uint32_t count = 0;
+            size_t bytes = 0;
+        };
+
+        /**
+         * @brief Size-class slab allocator behind DefaultObject's operator new.
+         * @details Slots of a class live in 64-slot slabs, so nodes of similar size sit next to each other and
+         * create/destroy are a free-list pop/push. Each slot carries a small header with its generation, which is
+         * what NodeHandles are checked against. Scene nodes are created and destroyed on the main thread only.
+         *
+         */
+        class NodePool
+        {
+        public:
+            static NodePool& getInstance();
+
+            void* allocate(size_t size);
+            void deallocate(void* memory, size_t size);
+
+            NodeHandle getHandle(const DefaultObject* object) const;
+            DefaultObject* resolve(NodeHandle handle) const;
+
+        /**
+         * @brief Visit every live pooled node, slab by slab.
+         *
+         * @param visitor Called with each DefaultObject*.
+         */
+            template<typename F>
+            void forEach(F&& visitor) const
+            {
+                for(const SizeClass& sizeClass : mClasses)
+                    for(std::byte* slab : sizeClass.slabs)
+                        for(uint32_t i = 0; i < SLAB_SLOTS; i++)
+                        {
+                            std::byte* slot = slab + i * sizeClass.stride;
+                            if(reinterpret_cast<const SlotHeader*>(slot)->alive)
+                                visitor(reinterpret_cast<DefaultObject*>(slot + sizeof(SlotHeader)));
+                        }
+            }
+
+            std::vector<NodePoolReport> getReport() const;
+            void logReport() const;
+        private:
+            NodePool();
+
+            struct SlotHeader
+            {
+                uint32_t slot;
+                uint16_t sizeClass;
+                uint16_t alive;
+                uint32_t generation;
+                uint32_t nextFree;
+            };
+            static_assert(sizeof(SlotHeader) == 16, "SlotHeader must keep pooled objects 16-byte aligned");
+
+            struct SizeClass
+            {
+                uint32_t objectSize;
+                uint32_t stride;
+                std::vector<std::byte*> slabs;
+                uint32_t freeHead = UINT32_MAX;
+                uint32_t live = 0;
+            };
+
+            static constexpr uint32_t SLAB_SLOTS = 64;
+            static constexpr uint32_t CLASS_SHIFT = 28;
+            static constexpr uint32_t SLOT_MASK = (1u << CLASS_SHIFT) - 1;
+            static constexpr uint16_t OVERSIZED = UINT16_MAX;
+
+            SlotHeader* getSlot(const SizeClass& sizeClass, uint32_t slot) const
+            {
+                return reinterpret_cast<SlotHeader*>(sizeClass.slabs[slot / SLAB_SLOTS] + (slot % SLAB_SLOTS) * sizeClass.stride);
+            }
+            // Header of the slab slot object starts in, nullptr when it isn't the start of one.
+            const SlotHeader* findSlot(const void* object) const;
+            void addSlab(SizeClass& sizeClass, uint16_t classIndex);
+
+            util::Logger mLogger = util::Logger("Node Pool Logger");
+
+            std::vector<SizeClass> mClasses;
+            uint32_t mOversizedLive = 0;
+            size_t mOversizedBytes = 0;
+        };
+    }
+}
@@ -1,7 +1,9 @@
 #pragma once 
 #include <glm/glm.hpp>
+#include <algorithm>
 #include <memory>
 #include <span>
+#include "NodePool.hpp"
 #include "../Utility/RenderUtil.hpp"
 #include "../Utility/structs.hpp"
 
@@ -84,6 +86,49 @@ namespace ke
 
                 return raw;
             }    
+        /**
+         * @brief Destroy a child object and its whole subtree.
+         * @details Handles to the destroyed nodes stop resolving.
+         * 
+         * @param child The child to destroy.
+         * @return true The child was found and destroyed.
+         * @return false The object is not a child of this one.
+         */
+            bool destroyChild(DefaultObject* child)
+            {
+                auto it = std::find_if(mChildren.begin(), mChildren.end(), [child](const std::unique_ptr<DefaultObject>& owned) {return owned.get() == child;});
+                if(it == mChildren.end()) return false;
+
+                mChildren.erase(it);
+                return true;
+            }
+        /**
+         * @brief Get a stable handle to the object.
+         * @details Only nodes created through createChild live in the NodePool and have one, the root and nodes
+         * on the stack get an invalid handle.
+         * 
+         * @return NodeHandle The handle, invalid for objects outside the pool.
+         */
+            NodeHandle getHandle() const {return NodePool::getInstance().getHandle(this);}
+        /**
+         * @brief Resolve a handle back into an object.
+         * 
+         * @tparam T The expected type of the object.
+         * @param handle The handle to resolve.
+         * @return T* The object, or nullptr if it was destroyed or is not a T.
+         */
+            template<typename T = DefaultObject>
+            static T* fromHandle(NodeHandle handle)
+            {
+                return dynamic_cast<T*>(NodePool::getInstance().resolve(handle));
+            }
+        /**
+         * @brief Pooled allocation, see NodePool.
+         * @details Picked up by the std::make_unique in createChild, and by delete through the virtual destructor.
+         * 
+         */
+            static void* operator new(size_t size) {return NodePool::getInstance().allocate(size);}
+            static void operator delete(void* memory, size_t size) {NodePool::getInstance().deallocate(memory, size);}
         /**
          * @brief Get the children (1st generation descendants) of the object.
          * 
@@ -102,18 +147,24 @@ namespace ke
             std::vector<DefaultObject*> gatherDescendants() const
             {
                 std::vector<DefaultObject*> nodes;
+                gatherDescendants(nodes);
 
+                return nodes;
+            }
+        /**
+         * @brief Append all descendants of the object to an existing container.
+         * @details Same order as gatherDescendants(), without a temporary vector per level. Pass a util::FrameVector on hot paths.
+         * 
+         * @param out The container to append to.
+         */
+            template<typename Allocator>
+            void gatherDescendants(std::vector<DefaultObject*, Allocator>& out) const
+            {
                 for(auto& child : mChildren)
                 {
-                    nodes.push_back(child.get()); 
-
-                    if(child->mChildren.empty()) continue;
-
-                    auto descendants = child->gatherDescendants();
-                    nodes.insert(nodes.end(), descendants.begin(), descendants.end());
+                    out.push_back(child.get());
+                    child->gatherDescendants(out);
                 }
-
-                return nodes;
             }
         /**
          * @brief Get the object type, non-implemented.
@@ -1,6 +1,8 @@
 #include "SceneManager.hpp"
 #include "./Graphics/Texture.hpp"
 #include "Nodes/Object.hpp"
+#include "Utility/Profiler.hpp"
+#include "Utility/FrameAllocator.hpp"
 #include <memory>
 
 void ke::SceneManager::init(glm::ivec2 pos, glm::ivec2 extent, int windowHeight)
@@ -21,7 +23,11 @@ void ke::SceneManager::init(glm::ivec2 pos, glm::ivec2 extent, int windowHeight)
 
 void ke::SceneManager::drawScene() const
 {
-    for(auto node : pSceneObject->gatherDescendants())
+    KE_PROFILE_FUNCTION();
+    util::FrameVector<nodes::DefaultObject*> descendants;
+    pSceneObject->gatherDescendants(descendants);
+
+    for(auto node : descendants)
     {
         if(auto* node2D = dynamic_cast<nodes::Node2D*>(node))
         {
@@ -54,7 +60,7 @@ void ke::SceneManager::recreateViewport(glm::ivec2 pos, glm::ivec2 extent, int w
 
 void ke::SceneManager::terminate()
 {
-    //TODO
+    nodes::NodePool::getInstance().logReport();
 }
 
 const VkViewport &ke::SceneManager::getViewport() const
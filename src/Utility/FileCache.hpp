@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ke
+{
+    namespace util
+    {
+        // $XDG_CACHE_HOME/NewEngine, ~/.cache/NewEngine or ./.cache as a last resort
+        inline std::filesystem::path getCacheDirectory()
+        {
+            std::filesystem::path base;
+
+            if(const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg)
+                base = xdg;
+            else if(const char* home = std::getenv("HOME"); home && *home)
+                base = std::filesystem::path(home) / ".cache";
+            else
+                base = ".cache";
+
+            std::filesystem::path dir = base / "NewEngine";
+
+            std::error_code ec;
+            std::filesystem::create_directories(dir, ec);
+
+            return dir;
+        }
+
+        // FNV-1a, good enough to tell cache entries apart
+        inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            uint64_t hash = seed;
+
+            for(size_t i = 0; i < size; i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        inline bool readCacheFile(const std::filesystem::path& path, std::vector<char>& data)
+        {
+            std::ifstream file(path, std::ios::ate | std::ios::binary);
+            if(!file.is_open()) return false;
+
+            size_t fileSize = (size_t) file.tellg();
+            data.resize(fileSize);
+
+            file.seekg(0);
+            file.read(data.data(), fileSize);
+
+            return file.good();
+        }
+
+        // Writes to a temporary file first so a crash mid-write never leaves a truncated cache behind.
+        inline bool writeCacheFile(const std::filesystem::path& path, const void* data, size_t size)
+        {
+            std::filesystem::path tmpPath = path;
+            tmpPath += ".tmp";
+
+            {
+                std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+                if(!file.is_open()) return false;
+
+                file.write(static_cast<const char*>(data), size);
+                if(!file.good()) return false;
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, path, ec);
+
+            return !ec;
+        }
+    
+        // Read-only view of a whole file. Pages are faulted in on first touch, so opening a large cache entry is
+        // cheap and only the parts that get read cost anything.
+        class MappedFile
+        {
+        public:
+            MappedFile() = default;
+            ~MappedFile() {close();}
+
+            MappedFile(const MappedFile&) = delete;
+            MappedFile& operator=(const MappedFile&) = delete;
+
+            bool open(const std::filesystem::path& path)
+            {
+                close();
+#if defined(_WIN32)
+                std::ifstream file(path, std::ios::binary);
+                if(!file.is_open()) return false;
+
+                mFallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                mData = mFallback.data();
+                mSize = mFallback.size();
+                return true;
+#else
+                int fd = ::open(path.c_str(), O_RDONLY);
+                if(fd < 0) return false;
+
+                struct stat info{};
+                if(fstat(fd, &info) != 0 || info.st_size <= 0)
+                {
+                    ::close(fd);
+                    return false;
+                }
+
+                void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                ::close(fd);
+                if(mapping == MAP_FAILED) return false;
+
+                mData = mapping;
+                mSize = static_cast<size_t>(info.st_size);
+                return true;
+#endif
+            }
+
+            void close()
+            {
+#if defined(_WIN32)
+                mFallback.clear();
+                mFallback.shrink_to_fit();
+#else
+                if(mData) munmap(const_cast<void*>(mData), mSize);
+#endif
+                mData = nullptr;
+                mSize = 0;
+            }
+
+            bool isOpen() const {return mData != nullptr;}
+            const void* data() const {return mData;}
+            size_t size() const {return mSize;}
+        private:
+            const void* mData = nullptr;
+            size_t mSize = 0;
+#if defined(_WIN32)
+            std::vector<char> mFallback;
+#endif
+        };
+    }
+}
@@ -0,0 +1,121 @@
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+std::atomic<uint64_t> ke::util::FrameArena::sFrameEpoch{0};
+
+ke::util::FrameArena& ke::util::FrameArena::getThreadArena()
+{
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+ke::util::FrameArena::~FrameArena()
+{
+    for(Block& block : mBlocks)
+        ::operator delete(block.data, std::align_val_t(alignof(std::max_align_t)));
+}
+
+void ke::util::FrameArena::reset()
+{
+    mEpoch = sFrameEpoch.load(std::memory_order_acquire);
+    mHighWater = std::max(mHighWater, mBytesUsed);
+    mBytesUsed = 0;
+
+    // Frames that overflowed into several blocks get one block big enough for all of them, so a steady state
+    // stops allocating after the first few frames.
+    if(mBlocks.size() > 1)
+    {
+        size_t total = getCapacity();
+        for(Block& block : mBlocks)
+            ::operator delete(block.data, std::align_val_t(alignof(std::max_align_t)));
+        mBlocks.clear();
+        mBlocks.push_back(Block{static_cast<std::byte*>(::operator new(total, std::align_val_t(alignof(std::max_align_t)))), total});
+    }
+
+    mCurrentBlock = 0;
+    mCursor = mBlocks.empty() ? nullptr : mBlocks[0].data;
+    mEnd = mBlocks.empty() ? nullptr : mBlocks[0].data + mBlocks[0].size;
+}
+
+size_t ke::util::FrameArena::getCapacity() const
+{
+    size_t capacity = 0;
+    for(const Block& block : mBlocks)
+        capacity += block.size;
+    return capacity;
+}
+
+void* ke::util::FrameArena::allocateSlow(size_t size, size_t alignment)
+{
+    // Move on to a block that fits, keeping the ones already used this frame alive.
+    while(mCurrentBlock + 1 < mBlocks.size())
+    {
+        mCurrentBlock++;
+        mCursor = mBlocks[mCurrentBlock].data;
+        mEnd = mCursor + mBlocks[mCurrentBlock].size;
+
+        std::byte* aligned = reinterpret_cast<std::byte*>((reinterpret_cast<uintptr_t>(mCursor) + alignment - 1) & ~(uintptr_t(alignment) - 1));
+        if(aligned + size <= mEnd)
+        {
+            mBytesUsed += static_cast<size_t>(aligned + size - mCursor);
+            mCursor = aligned + size;
+            return aligned;
+        }
+    }
+
+    size_t blockSize = std::max(DEFAULT_BLOCK_SIZE, size + alignment);
+    if(!mBlocks.empty()) blockSize = std::max(blockSize, mBlocks.back().size * 2);
+
+    mBlocks.push_back(Block{static_cast<std::byte*>(::operator new(blockSize, std::align_val_t(alignof(std::max_align_t)))), blockSize});
+    mCurrentBlock = mBlocks.size() - 1;
+    mCursor = mBlocks.back().data;
+    mEnd = mCursor + blockSize;
+
+    std::byte* aligned = reinterpret_cast<std::byte*>((reinterpret_cast<uintptr_t>(mCursor) + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    mBytesUsed += static_cast<size_t>(aligned + size - mCursor);
+    mCursor = aligned + size;
+    return aligned;
+}
+
+#ifdef KE_PROFILE
+namespace
+{
+    std::atomic<uint64_t> sHeapAllocations{0};
+
+    void* countedAllocate(size_t size)
+    {
+        sHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+        if(void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+        throw std::bad_alloc();
+    }
+
+    void* countedAllocateAligned(size_t size, std::align_val_t alignment)
+    {
+        sHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+        size_t align = static_cast<size_t>(alignment);
+        if(void* memory = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) & ~(align - 1))) return memory;
+        throw std::bad_alloc();
+    }
+}
+
+uint64_t ke::util::getHeapAllocationCount()
+{
+    return sHeapAllocations.load(std::memory_order_relaxed);
+}
+
+// The array and nothrow forms forward to these by default, so replacing the scalar ones covers every new.
+void* operator new(size_t size) {return countedAllocate(size);}
+void* operator new(size_t size, std::align_val_t alignment) {return countedAllocateAligned(size, alignment);}
+void operator delete(void* memory) noexcept {std::free(memory);}
+void operator delete(void* memory, size_t) noexcept {std::free(memory);}
+void operator delete(void* memory, std::align_val_t) noexcept {std::free(memory);}
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {std::free(memory);}
+#else
+uint64_t ke::util::getHeapAllocationCount()
+{
+    return 0;
+}
+#endif
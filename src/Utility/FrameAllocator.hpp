@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ke
+{
+    namespace util
+    {
+        // Bump allocator for data that only lives for the current frame. Every thread gets its own arena, which
+        // empties itself the first time it is used after FrameArena::beginFrame, so nothing allocated from it may
+        // be kept past the end of the frame.
+        class FrameArena
+        {
+        public:
+            static constexpr size_t DEFAULT_BLOCK_SIZE = 256 * 1024;
+
+            static FrameArena& getThreadArena();
+
+            // Called once per frame from readyCanvas, invalidates every thread's frame memory.
+            static void beginFrame() {sFrameEpoch.fetch_add(1, std::memory_order_release);}
+
+            FrameArena() = default;
+            ~FrameArena();
+
+            FrameArena(const FrameArena&) = delete;
+            FrameArena& operator=(const FrameArena&) = delete;
+
+            void* allocate(size_t size, size_t alignment)
+            {
+                if(mEpoch != sFrameEpoch.load(std::memory_order_acquire)) reset();
+
+                std::byte* aligned = reinterpret_cast<std::byte*>((reinterpret_cast<uintptr_t>(mCursor) + alignment - 1) & ~(uintptr_t(alignment) - 1));
+                if(mCursor == nullptr || aligned + size > mEnd) return allocateSlow(size, alignment);
+
+                mBytesUsed += static_cast<size_t>(aligned + size - mCursor);
+                mCursor = aligned + size;
+                return aligned;
+            }
+
+            void reset();
+
+            size_t getBytesUsed() const {return mBytesUsed;}
+            size_t getHighWater() const {return mHighWater;}
+            size_t getCapacity() const;
+        private:
+            struct Block
+            {
+                std::byte* data;
+                size_t size;
+            };
+
+            void* allocateSlow(size_t size, size_t alignment);
+
+            static std::atomic<uint64_t> sFrameEpoch;
+
+            std::vector<Block> mBlocks;
+            size_t mCurrentBlock = 0;
+            std::byte* mCursor = nullptr;
+            std::byte* mEnd = nullptr;
+
+            size_t mBytesUsed = 0;
+            size_t mHighWater = 0;
+            uint64_t mEpoch = 0;
+        };
+
+        // STL adapter over the calling thread's frame arena. Deallocation is a no-op, memory comes back on reset.
+        template<typename T>
+        class FrameAllocator
+        {
+        public:
+            using value_type = T;
+
+            FrameAllocator() noexcept : mArena(&FrameArena::getThreadArena()) {}
+            template<typename U>
+            FrameAllocator(const FrameAllocator<U>& other) noexcept : mArena(other.getArena()) {}
+
+            T* allocate(size_t count)
+            {
+                return static_cast<T*>(mArena->allocate(count * sizeof(T), alignof(T)));
+            }
+            void deallocate(T*, size_t) noexcept {}
+
+            FrameArena* getArena() const {return mArena;}
+
+            template<typename U>
+            bool operator==(const FrameAllocator<U>& other) const {return mArena == other.getArena();}
+        private:
+            FrameArena* mArena;
+        };
+
+        template<typename T>
+        using FrameVector = std::vector<T, FrameAllocator<T>>;
+        using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+
+        // Counts every global operator new when built with --profile, so per-frame heap traffic can be tracked
+        // down to zero. Always 0 otherwise.
+        uint64_t getHeapAllocationCount();
+        constexpr bool isCountingHeapAllocations()
+        {
+#ifdef KE_PROFILE
+            return true;
+#else
+            return false;
+#endif
+        }
+    }
+}
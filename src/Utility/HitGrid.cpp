@@ -0,0 +1,121 @@
+#include "HitGrid.hpp"
+#include "XMLparser.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t ke::gui::HitGrid::toCell(float coordinate)
+{
+    float cell = std::floor(coordinate * static_cast<float>(CELLS));
+    return static_cast<uint32_t>(std::clamp(cell, 0.0f, static_cast<float>(CELLS - 1)));
+}
+
+void ke::gui::HitGrid::insert(Element* element)
+{
+    if(element == nullptr || mIndex.contains(element)) return;
+
+    uint32_t entry;
+    if(!mFreeEntries.empty())
+    {
+        entry = mFreeEntries.back();
+        mFreeEntries.pop_back();
+    }
+    else
+    {
+        entry = static_cast<uint32_t>(mEntries.size());
+        mEntries.emplace_back();
+    }
+
+    mEntries[entry].element = element;
+    mEntries[entry].order = mNextOrder++;
+    mIndex.emplace(element, entry);
+
+    bin(entry);
+}
+
+void ke::gui::HitGrid::update(Element* element)
+{
+    auto it = mIndex.find(element);
+    if(it == mIndex.end()) return;
+
+    unbin(it->second);
+    bin(it->second);
+}
+
+void ke::gui::HitGrid::remove(Element* element)
+{
+    auto it = mIndex.find(element);
+    if(it == mIndex.end()) return;
+
+    unbin(it->second);
+    mEntries[it->second] = Entry{};
+    mFreeEntries.push_back(it->second);
+    mIndex.erase(it);
+}
+
+void ke::gui::HitGrid::clear()
+{
+    for(std::vector<uint32_t>& cell : mCells)
+        cell.clear();
+    mEntries.clear();
+    mFreeEntries.clear();
+    mIndex.clear();
+    mNextOrder = 0;
+}
+
+void ke::gui::HitGrid::bin(uint32_t entry)
+{
+    Entry& target = mEntries[entry];
+    const Element& element = *target.element;
+
+    target.x0 = toCell(element.x);
+    target.y0 = toCell(element.y);
+    target.x1 = toCell(element.x + element.w);
+    target.y1 = toCell(element.y + element.h);
+
+    auto byOrder = [this](uint32_t a, uint32_t b) {return mEntries[a].order < mEntries[b].order;};
+    for(uint32_t cy = target.y0; cy <= target.y1; cy++)
+        for(uint32_t cx = target.x0; cx <= target.x1; cx++)
+        {
+            std::vector<uint32_t>& cell = mCells[cy * CELLS + cx];
+            cell.insert(std::upper_bound(cell.begin(), cell.end(), entry, byOrder), entry);
+        }
+}
+
+void ke::gui::HitGrid::unbin(uint32_t entry)
+{
+    const Entry& target = mEntries[entry];
+
+    for(uint32_t cy = target.y0; cy <= target.y1; cy++)
+        for(uint32_t cx = target.x0; cx <= target.x1; cx++)
+        {
+            std::vector<uint32_t>& cell = mCells[cy * CELLS + cx];
+            cell.erase(std::remove(cell.begin(), cell.end(), entry), cell.end());
+        }
+}
+
+ke::gui::Element* ke::gui::HitGrid::find(float x, float y, const UIType* type) const
+{
+    if(x < 0.0f || x > 1.0f || y < 0.0f || y > 1.0f) return nullptr;
+
+    for(uint32_t entry : mCells[toCell(y) * CELLS + toCell(x)])
+    {
+        Element* element = mEntries[entry].element;
+        if(type && element->getType() != *type) continue;
+
+        // Edges don't count, same as the pixel tests this replaced.
+        if(x > element->x && x < element->x + element->w && y > element->y && y < element->y + element->h)
+            return element;
+    }
+    return nullptr;
+}
+
+ke::gui::Element* ke::gui::HitGrid::pick(float x, float y) const
+{
+    return find(x, y, nullptr);
+}
+
+ke::gui::Element* ke::gui::HitGrid::pick(float x, float y, UIType type) const
+{
+    return find(x, y, &type);
+}
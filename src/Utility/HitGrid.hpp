@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ke
+{
+    namespace gui
+    {
+        class Element;
+        enum class UIType;
+
+        // Uniform grid over the normalized UI space [0,1]^2 for hit-testing. Each element sits in every cell its
+        // rect overlaps, so a point query only tests the handful of elements sharing its cell, however many
+        // widgets there are. An element that moves is re-binned on its own, the rest of the grid is untouched.
+        class HitGrid
+        {
+        public:
+            static constexpr uint32_t CELLS = 32;   // per axis
+
+            HitGrid() : mCells(CELLS * CELLS) {}
+
+            void insert(Element* element);
+            // Re-bins an inserted element after its rect changed, ignores anything that was never inserted.
+            void update(Element* element);
+            void remove(Element* element);
+            void clear();
+
+            // Earliest inserted element containing the point, y grows upwards like the element rects.
+            Element* pick(float x, float y) const;
+            Element* pick(float x, float y, UIType type) const;
+
+            size_t size() const {return mIndex.size();}
+        private:
+            struct Entry
+            {
+                Element* element = nullptr;
+                uint32_t order = 0;
+                uint32_t x0 = 0, y0 = 0, x1 = 0, y1 = 0;   // inclusive cell range
+            };
+
+            Element* find(float x, float y, const UIType* type) const;
+
+            void bin(uint32_t entry);
+            void unbin(uint32_t entry);
+            static uint32_t toCell(float coordinate);
+
+            // Entry indices, kept sorted by insertion order so the first hit is the earliest element.
+            std::vector<std::vector<uint32_t>> mCells;
+            std::vector<Entry> mEntries;
+            std::vector<uint32_t> mFreeEntries;
+            std::unordered_map<Element*, uint32_t> mIndex;
+            uint32_t mNextOrder = 0;
+        };
+    }
+}
@@ -0,0 +1,399 @@
+#include "JobSystem.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t NO_WORKER = UINT32_MAX;
+    constexpr int64_t QUEUE_MASK = ke::util::WorkStealingQueue::CAPACITY - 1;
+
+    thread_local uint32_t sWorkerIndex = NO_WORKER;
+}
+
+bool ke::util::WorkStealingQueue::push(Job* job)
+{
+    int64_t bottom = mBottom.load(std::memory_order_relaxed);
+    int64_t top = mTop.load(std::memory_order_acquire);
+    if(bottom - top >= CAPACITY) return false;
+
+    mJobs[bottom & QUEUE_MASK].store(job, std::memory_order_relaxed);
+    mBottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+ke::util::Job* ke::util::WorkStealingQueue::pop()
+{
+    int64_t bottom = mBottom.load(std::memory_order_relaxed) - 1;
+    mBottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = mTop.load(std::memory_order_relaxed);
+
+    if(top > bottom)
+    {
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = mJobs[bottom & QUEUE_MASK].load(std::memory_order_relaxed);
+    if(top == bottom)
+    {
+        // Last job, race the thieves for it.
+        if(!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        mBottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+ke::util::Job* ke::util::WorkStealingQueue::steal()
+{
+    int64_t top = mTop.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = mBottom.load(std::memory_order_acquire);
+    if(top >= bottom) return nullptr;
+
+    Job* job = mJobs[top & QUEUE_MASK].load(std::memory_order_relaxed);
+    if(!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+ke::util::JobSystem& ke::util::JobSystem::getInstance()
+{
+    static JobSystem instance;
+    return instance;
+}
+
+void ke::util::JobSystem::init(uint32_t workerCount)
+{
+    if(mRunning.load(std::memory_order_acquire)) return;
+
+    if(workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    mMainThread = std::this_thread::get_id();
+    sWorkerIndex = 0;
+
+    for(uint32_t i = 0; i <= workerCount; i++)
+        mWorkerSlots.push_back(std::make_unique<Worker>());
+
+    resetStats();
+    mRunning.store(true, std::memory_order_release);
+
+    for(uint32_t i = 1; i <= workerCount; i++)
+        mWorkers.emplace_back(&JobSystem::workerLoop, this, i);
+
+    mLogger.info("Started {} job workers", workerCount);
+}
+
+void ke::util::JobSystem::shutdown()
+{
+    if(!mRunning.load(std::memory_order_acquire)) return;
+
+    // Everything already scheduled still runs, including continuations of counters that drain meanwhile.
+    while(mOutstanding.load(std::memory_order_acquire) > 0)
+        if(!runOne()) std::this_thread::yield();
+
+    logStats();
+
+    mRunning.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    mWake.notify_all();
+
+    for(std::thread& worker : mWorkers)
+        worker.join();
+    mWorkers.clear();
+
+    for(std::unique_ptr<Worker>& worker : mWorkerSlots)
+    {
+        for(Job* lists : {worker->freeJobs, worker->returnedJobs.load(std::memory_order_acquire)})
+            while(lists)
+            {
+                Job* next = lists->nextFree;
+                delete lists;
+                lists = next;
+            }
+    }
+    mWorkerSlots.clear();
+    sWorkerIndex = NO_WORKER;
+}
+
+ke::util::Job* ke::util::JobSystem::allocateJob()
+{
+    uint32_t index = sWorkerIndex;
+    if(index >= mWorkerSlots.size()) return new Job();
+
+    Worker& worker = *mWorkerSlots[index];
+    if(worker.freeJobs == nullptr)
+        worker.freeJobs = worker.returnedJobs.exchange(nullptr, std::memory_order_acquire);
+
+    Job* job = worker.freeJobs;
+    if(job == nullptr)
+    {
+        job = new Job();
+        job->owner = index;
+        return job;
+    }
+
+    worker.freeJobs = job->nextFree;
+    return job;
+}
+
+void ke::util::JobSystem::freeJob(Job* job)
+{
+    job->function.reset();
+    if(job->owner == NO_WORKER)
+    {
+        delete job;
+        return;
+    }
+
+    Worker& owner = *mWorkerSlots[job->owner];
+    if(job->owner == sWorkerIndex)
+    {
+        job->nextFree = owner.freeJobs;
+        owner.freeJobs = job;
+        return;
+    }
+
+    // Handed back to the thread that allocated it, which takes the whole list at once when it runs dry.
+    Job* head = owner.returnedJobs.load(std::memory_order_relaxed);
+    do job->nextFree = head;
+    while(!owner.returnedJobs.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool ke::util::JobSystem::holdBack(JobCounter& dependency, Job* job)
+{
+    std::lock_guard<std::mutex> lock(dependency.mMutex);
+    if(dependency.mPending.load(std::memory_order_acquire) == 0) return false;
+
+    dependency.mContinuations.push_back(job);
+    return true;
+}
+
+void ke::util::JobSystem::enqueue(Job* job)
+{
+    if(job->mainThread)
+    {
+        std::lock_guard<std::mutex> lock(mMainMutex);
+        mMainQueue.push_back(job);
+        return;
+    }
+
+    uint32_t index = sWorkerIndex;
+    if(index >= mWorkerSlots.size() || !mWorkerSlots[index]->queue.push(job))
+    {
+        std::lock_guard<std::mutex> lock(mGlobalMutex);
+        mGlobalQueue.push_back(job);
+        mGlobalSize.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    mWorkEpoch.fetch_add(1, std::memory_order_seq_cst);
+    if(mSleeping.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mWake.notify_one();
+    }
+}
+
+void ke::util::JobSystem::finish(JobCounter& counter)
+{
+    uint32_t pending = counter.mPending.load(std::memory_order_relaxed);
+    while(pending > 1)
+        if(counter.mPending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+            return;
+
+    // The last decrement happens under the lock, so a waiter that saw zero can't destroy the counter while the
+    // continuations are being taken out of it.
+    std::vector<Job*> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter.mMutex);
+        if(counter.mPending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        ready.swap(counter.mContinuations);
+    }
+
+    for(Job* job : ready)
+        enqueue(job);
+}
+
+void ke::util::JobSystem::wait(JobCounter& counter)
+{
+    while(!counter.isDone())
+        if(!runOne()) std::this_thread::yield();
+
+    std::lock_guard<std::mutex> lock(counter.mMutex);
+}
+
+void ke::util::JobSystem::runMainThreadJobs()
+{
+    if(sWorkerIndex != 0) return;
+
+    // Only what is queued now, jobs scheduled by these wait for the next call.
+    std::deque<Job*> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mMainMutex);
+        jobs.swap(mMainQueue);
+    }
+    for(Job* job : jobs)
+        execute(job, 0);
+}
+
+ke::util::Job* ke::util::JobSystem::findJob(uint32_t workerIndex)
+{
+    uint32_t count = static_cast<uint32_t>(mWorkerSlots.size());
+    if(count == 0) return nullptr;
+
+    if(workerIndex < count)
+        if(Job* job = mWorkerSlots[workerIndex]->queue.pop()) return job;
+
+    if(mGlobalSize.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(mGlobalMutex);
+        if(!mGlobalQueue.empty())
+        {
+            Job* job = mGlobalQueue.front();
+            mGlobalQueue.pop_front();
+            mGlobalSize.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    // Start at a different victim every time so thieves don't all hammer the same deque.
+    static thread_local uint32_t seed = workerIndex * 2654435761u + 1;
+    seed = seed * 1664525u + 1013904223u;
+
+    for(uint32_t i = 0; i < count; i++)
+    {
+        uint32_t victim = (seed + i) % count;
+        if(victim == workerIndex) continue;
+
+        if(Job* job = mWorkerSlots[victim]->queue.steal())
+        {
+            if(workerIndex < count) mWorkerSlots[workerIndex]->steals.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+bool ke::util::JobSystem::runOne()
+{
+    uint32_t index = sWorkerIndex;
+
+    if(index == 0)
+    {
+        Job* job = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mMainMutex);
+            if(!mMainQueue.empty())
+            {
+                job = mMainQueue.front();
+                mMainQueue.pop_front();
+            }
+        }
+        if(job)
+        {
+            execute(job, index);
+            return true;
+        }
+    }
+
+    Job* job = findJob(index);
+    if(job == nullptr) return false;
+
+    execute(job, index);
+    return true;
+}
+
+void ke::util::JobSystem::execute(Job* job, uint32_t workerIndex)
+{
+    auto start = std::chrono::steady_clock::now();
+    {
+        KE_PROFILE_ZONE(job->name);
+        job->function();
+    }
+
+    if(workerIndex < mWorkerSlots.size())
+    {
+        Worker& worker = *mWorkerSlots[workerIndex];
+        worker.jobs.fetch_add(1, std::memory_order_relaxed);
+        worker.busyNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(), std::memory_order_relaxed);
+    }
+
+    JobCounter* signal = job->signal;
+    freeJob(job);
+    if(signal) finish(*signal);
+
+    mOutstanding.fetch_sub(1, std::memory_order_release);
+}
+
+void ke::util::JobSystem::workerLoop(uint32_t workerIndex)
+{
+    sWorkerIndex = workerIndex;
+    KE_PROFILE_THREAD(fmt::format("Job Worker {}", workerIndex).c_str());
+
+    while(mRunning.load(std::memory_order_acquire))
+    {
+        uint64_t epoch = mWorkEpoch.load(std::memory_order_seq_cst);
+        if(Job* job = findJob(workerIndex))
+        {
+            execute(job, workerIndex);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleeping.fetch_add(1, std::memory_order_seq_cst);
+        mWake.wait(lock, [&]() {
+            return mWorkEpoch.load(std::memory_order_seq_cst) != epoch || !mRunning.load(std::memory_order_acquire);
+        });
+        mSleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+uint32_t ke::util::JobSystem::getCurrentWorker() const
+{
+    return sWorkerIndex;
+}
+
+std::vector<ke::util::WorkerStats> ke::util::JobSystem::getStats() const
+{
+    double elapsed = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStatsStart).count());
+
+    std::vector<WorkerStats> stats;
+    for(const std::unique_ptr<Worker>& worker : mWorkerSlots)
+    {
+        WorkerStats workerStats;
+        workerStats.jobs = worker->jobs.load(std::memory_order_relaxed);
+        workerStats.steals = worker->steals.load(std::memory_order_relaxed);
+        workerStats.busyNanoseconds = worker->busyNanoseconds.load(std::memory_order_relaxed);
+        // Nested waits count their inner jobs twice, hence the clamp.
+        workerStats.utilization = elapsed > 0.0 ? std::min(1.0f, static_cast<float>(workerStats.busyNanoseconds / elapsed)) : 0.0f;
+        stats.push_back(workerStats);
+    }
+    return stats;
+}
+
+void ke::util::JobSystem::resetStats()
+{
+    for(std::unique_ptr<Worker>& worker : mWorkerSlots)
+    {
+        worker->jobs.store(0, std::memory_order_relaxed);
+        worker->steals.store(0, std::memory_order_relaxed);
+        worker->busyNanoseconds.store(0, std::memory_order_relaxed);
+    }
+    mStatsStart = std::chrono::steady_clock::now();
+}
+
+void ke::util::JobSystem::logStats() const
+{
+    std::vector<WorkerStats> stats = getStats();
+    for(size_t i = 0; i < stats.size(); i++)
+        mLogger.info("{:<10} {:>8} jobs {:>6} steals {:>5.1f}% busy", i == 0 ? std::string("Main") : fmt::format("Worker {}", i),
+            stats[i].jobs, stats[i].steals, stats[i].utilization * 100.0f);
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Logger.hpp"
+
+namespace ke
+{
+    namespace util
+    {
+        // Type-erased callable with inline storage, so scheduling a small lambda doesn't touch the heap.
+        class JobFunction
+        {
+        public:
+            static constexpr size_t STORAGE = 64;
+
+            JobFunction() = default;
+            ~JobFunction() {reset();}
+
+            JobFunction(const JobFunction&) = delete;
+            JobFunction& operator=(const JobFunction&) = delete;
+
+            template<typename F>
+            void set(F&& function)
+            {
+                using Callable = std::decay_t<F>;
+                reset();
+
+                if constexpr(sizeof(Callable) <= STORAGE && alignof(Callable) <= alignof(std::max_align_t))
+                {
+                    mTarget = new(mStorage) Callable(std::forward<F>(function));
+                    mDestroy = [](void* target) {static_cast<Callable*>(target)->~Callable();};
+                }
+                else
+                {
+                    mTarget = new Callable(std::forward<F>(function));
+                    mDestroy = [](void* target) {delete static_cast<Callable*>(target);};
+                }
+                mInvoke = [](void* target) {(*static_cast<Callable*>(target))();};
+            }
+
+            void operator()() {mInvoke(mTarget);}
+
+            void reset()
+            {
+                if(mDestroy) mDestroy(mTarget);
+                mTarget = nullptr;
+                mInvoke = nullptr;
+                mDestroy = nullptr;
+            }
+        private:
+            alignas(std::max_align_t) std::byte mStorage[STORAGE];
+            void* mTarget = nullptr;
+            void (*mInvoke)(void*) = nullptr;
+            void (*mDestroy)(void*) = nullptr;
+        };
+
+        class JobCounter;
+
+        struct Job
+        {
+            JobFunction function;
+            JobCounter* signal = nullptr;
+            const char* name = "Job";
+            bool mainThread = false;
+            uint32_t owner = UINT32_MAX;    // worker whose free list the job returns to, UINT32_MAX for plain heap
+            Job* nextFree = nullptr;
+        };
+
+        // Counts outstanding jobs. Waiting on it runs other jobs in the meantime, jobs scheduled with it as a
+        // dependency start once it reaches zero.
+        class JobCounter
+        {
+        public:
+            JobCounter() = default;
+            JobCounter(const JobCounter&) = delete;
+            JobCounter& operator=(const JobCounter&) = delete;
+
+            bool isDone() const {return mPending.load(std::memory_order_acquire) == 0;}
+        private:
+            friend class JobSystem;
+
+            std::atomic<uint32_t> mPending{0};
+            std::mutex mMutex;
+            std::vector<Job*> mContinuations;
+        };
+
+        enum class JobAffinity
+        {
+            Any,
+            MainThread  // for work touching thread-bound APIs, run from runMainThreadJobs or while the main thread waits
+        };
+
+        struct JobDesc
+        {
+            const char* name = "Job";           // shows up as a profiler zone, must have static storage
+            JobCounter* signal = nullptr;       // incremented now, decremented when the job finishes
+            JobCounter* dependency = nullptr;   // the job is held back until this reaches zero
+            JobAffinity affinity = JobAffinity::Any;
+        };
+
+        struct WorkerStats
+        {
+            uint64_t jobs = 0;
+            uint64_t steals = 0;
+            uint64_t busyNanoseconds = 0;
+            float utilization = 0.0f;   // share of wall time spent running jobs since the last reset
+        };
+
+        // Chase-Lev deque: the owning worker pushes and pops at the bottom, thieves take from the top.
+        class WorkStealingQueue
+        {
+        public:
+            static constexpr int64_t CAPACITY = 4096;
+
+            bool push(Job* job);
+            Job* pop();
+            Job* steal();
+        private:
+            alignas(64) std::atomic<int64_t> mTop{0};
+            alignas(64) std::atomic<int64_t> mBottom{0};
+            std::array<std::atomic<Job*>, CAPACITY> mJobs{};
+        };
+
+        // Worker threads with one deque each, the main thread owns deque 0 and only runs jobs while it waits.
+        // Waiting never blocks a thread: it keeps running queued jobs until the counter drains, so don't wait while
+        // holding a lock another job might take. Before init every job runs inline on the caller.
+        class JobSystem
+        {
+        public:
+            static JobSystem& getInstance();
+
+            void init(uint32_t workerCount = 0);
+            void shutdown();
+
+            template<typename F>
+            void schedule(F&& function, const JobDesc& desc = {})
+            {
+                if(desc.signal) desc.signal->mPending.fetch_add(1, std::memory_order_relaxed);
+
+                if(!mRunning.load(std::memory_order_acquire))
+                {
+                    std::forward<F>(function)();
+                    if(desc.signal) finish(*desc.signal);
+                    return;
+                }
+
+                Job* job = allocateJob();
+                job->function.set(std::forward<F>(function));
+                job->signal = desc.signal;
+                job->name = desc.name;
+                job->mainThread = desc.affinity == JobAffinity::MainThread;
+
+                mOutstanding.fetch_add(1, std::memory_order_relaxed);
+                if(desc.dependency && holdBack(*desc.dependency, job)) return;
+                enqueue(job);
+            }
+
+            // Splits [0, count) into batches and waits for all of them.
+            template<typename F>
+            void parallelFor(uint32_t count, uint32_t batchSize, F&& function, const char* name = "ParallelFor")
+            {
+                JobCounter counter;
+                batchSize = batchSize == 0 ? 1 : batchSize;
+                for(uint32_t begin = 0; begin < count; begin += batchSize)
+                {
+                    uint32_t end = begin + batchSize < count ? begin + batchSize : count;
+                    schedule([&function, begin, end]() {function(begin, end);}, {name, &counter});
+                }
+                wait(counter);
+            }
+
+            void wait(JobCounter& counter);
+            void runMainThreadJobs();
+
+            bool isMainThread() const {return std::this_thread::get_id() == mMainThread;}
+            uint32_t getWorkerCount() const {return static_cast<uint32_t>(mWorkers.size());}
+            uint32_t getCurrentWorker() const;   // 0 on the main thread, UINT32_MAX off the job system
+
+            std::vector<WorkerStats> getStats() const;
+            void resetStats();
+            void logStats() const;
+        private:
+            JobSystem() = default;
+            ~JobSystem() {shutdown();}
+
+            struct Worker
+            {
+                WorkStealingQueue queue;
+                Job* freeJobs = nullptr;
+                std::atomic<Job*> returnedJobs{nullptr};   // jobs freed by other threads
+                std::atomic<uint64_t> jobs{0};
+                std::atomic<uint64_t> steals{0};
+                std::atomic<uint64_t> busyNanoseconds{0};
+            };
+
+            Job* allocateJob();
+            void freeJob(Job* job);
+
+            bool holdBack(JobCounter& dependency, Job* job);
+            void enqueue(Job* job);
+            void finish(JobCounter& counter);
+
+            Job* findJob(uint32_t workerIndex);
+            bool runOne();
+            void execute(Job* job, uint32_t workerIndex);
+            void workerLoop(uint32_t workerIndex);
+
+            util::Logger mLogger = util::Logger("Job System Logger");
+
+            std::vector<std::unique_ptr<Worker>> mWorkerSlots;   // slot 0 is the main thread
+            std::vector<std::thread> mWorkers;
+            std::thread::id mMainThread = std::this_thread::get_id();
+            std::atomic<bool> mRunning{false};
+            std::atomic<uint64_t> mOutstanding{0};
+
+            std::mutex mGlobalMutex;     // jobs from threads without a deque
+            std::deque<Job*> mGlobalQueue;
+            std::atomic<uint32_t> mGlobalSize{0};
+
+            std::mutex mMainMutex;
+            std::deque<Job*> mMainQueue;
+
+            std::mutex mSleepMutex;
+            std::condition_variable mWake;
+            std::atomic<uint32_t> mSleeping{0};
+            std::atomic<uint64_t> mWorkEpoch{0};   // bumped on every enqueue so sleepers can't miss one
+
+            std::chrono::steady_clock::time_point mStatsStart = std::chrono::steady_clock::now();
+        };
+    }
+}
@@ -0,0 +1,133 @@
+#include "LogBackend.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // Marks the ring reusable once its thread exits, std::async and similar spawn short-lived threads that log once.
+    struct ThreadRingHandle
+    {
+        ke::util::LogRing* ring = nullptr;
+        ~ThreadRingHandle()
+        {
+            if(ring) ring->retired.store(true, std::memory_order_release);
+        }
+    };
+}
+
+ke::util::LogBackend& ke::util::LogBackend::getInstance()
+{
+    static LogBackend instance;
+    return instance;
+}
+
+ke::util::LogBackend::~LogBackend()
+{
+    if(mRunning.exchange(false))
+    {
+        mWake.notify_one();
+        mSink.join();
+    }
+    drainRings();
+}
+
+uint16_t ke::util::LogBackend::registerLogger(std::shared_ptr<spdlog::logger> logger)
+{
+    std::lock_guard<std::mutex> lock(mLoggerMutex);
+
+    // Loggers are kept alive here so records outliving the object that wrote them can still be printed.
+    mLoggers.push_back(std::move(logger));
+    return static_cast<uint16_t>(std::min<size_t>(mLoggers.size() - 1, UINT16_MAX));
+}
+
+ke::util::LogRing& ke::util::LogBackend::getThreadRing()
+{
+    static thread_local ThreadRingHandle handle;
+    if(handle.ring) return *handle.ring;
+
+    {
+        std::lock_guard<std::mutex> lock(mRingMutex);
+        if(!mFreeRings.empty())
+        {
+            handle.ring = mFreeRings.back();
+            mFreeRings.pop_back();
+            handle.ring->retired.store(false, std::memory_order_relaxed);
+        }
+        else
+        {
+            mRings.push_back(std::make_unique<LogRing>());
+            handle.ring = mRings.back().get();
+        }
+    }
+
+    // First record from anywhere starts the sink, builds that never log never spawn it.
+    startSink();
+
+    return *handle.ring;
+}
+
+void ke::util::LogBackend::flush()
+{
+    drainRings();
+}
+
+void ke::util::LogBackend::startSink()
+{
+    std::lock_guard<std::mutex> lock(mWakeMutex);
+    if(mRunning.exchange(true)) return;
+
+    mSink = std::thread(&LogBackend::sinkLoop, this);
+}
+
+void ke::util::LogBackend::sinkLoop()
+{
+    while(mRunning.load(std::memory_order_acquire))
+    {
+        drainRings();
+
+        // Polling keeps producers free of any wake-up syscall, a millisecond of latency is invisible in a log.
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWake.wait_for(lock, std::chrono::milliseconds(1), [this]() {return !mRunning.load(std::memory_order_acquire);});
+    }
+}
+
+void ke::util::LogBackend::drainRings()
+{
+    std::lock_guard<std::mutex> lock(mRingMutex);
+
+    uint64_t dropped = 0;
+    for(const std::unique_ptr<LogRing>& ring : mRings)
+    {
+        // Read before draining, a ring retired after this point still has its last records picked up next pass.
+        bool retired = ring->retired.load(std::memory_order_acquire);
+
+        ring->drain([this](const LogRecord& record, const std::byte* payload)
+        {
+            mFormatBuffer.clear();
+            record.decode(payload, std::string_view(record.format, record.formatSize), mFormatBuffer);
+            mPending.push_back(PendingMessage{record.timestamp, record.loggerId, record.level, std::string(mFormatBuffer.data(), mFormatBuffer.size())});
+        });
+        dropped += ring->takeDropped();
+
+        if(retired && ring->isEmpty() && std::find(mFreeRings.begin(), mFreeRings.end(), ring.get()) == mFreeRings.end())
+            mFreeRings.push_back(ring.get());
+    }
+
+    if(mPending.empty() && dropped == 0) return;
+
+    // Each ring is in order on its own, sorting merges the threads back into one timeline.
+    std::stable_sort(mPending.begin(), mPending.end(), [](const PendingMessage& a, const PendingMessage& b) {return a.timestamp < b.timestamp;});
+
+    std::lock_guard<std::mutex> loggerLock(mLoggerMutex);
+    for(const PendingMessage& message : mPending)
+    {
+        if(message.loggerId >= mLoggers.size()) continue;
+
+        std::chrono::system_clock::time_point time{std::chrono::system_clock::duration(message.timestamp)};
+        mLoggers[message.loggerId]->log(time, spdlog::source_loc{}, static_cast<spdlog::level::level_enum>(message.level), message.text);
+    }
+    mPending.clear();
+
+    if(dropped > 0 && !mLoggers.empty())
+        mLoggers.front()->warn("Dropped {} log messages, the log rings were full.", dropped);
+}
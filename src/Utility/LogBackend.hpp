@@ -0,0 +1,239 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace ke
+{
+    namespace util
+    {
+        using LogDecodeFunction = void(*)(const std::byte* payload, std::string_view format, fmt::memory_buffer& out);
+
+        // Fixed part of every record in a LogRing, the encoded arguments follow it. Formatting happens on the
+        // sink thread through `decode`, which knows the argument types of the call site that wrote the record.
+        struct LogRecord
+        {
+            static constexpr uint8_t FLAG_PADDING = 1;
+
+            uint32_t size;          // header + payload, multiple of 8
+            uint16_t loggerId;
+            uint8_t level;
+            uint8_t flags;
+            int64_t timestamp;      // system_clock ticks, what spdlog stamps messages with
+            LogDecodeFunction decode;
+            const char* format;     // format strings are literals, only the pointer is stored
+            uint64_t formatSize;
+        };
+        static_assert(sizeof(LogRecord) % 8 == 0);
+
+        // Byte ring written only by its owning thread and drained only by the sink, so the two indices are the only
+        // shared state. Records never straddle the end: a producer that would wrap pads the tail first.
+        class LogRing
+        {
+        public:
+            static constexpr uint32_t CAPACITY = 1 << 16;
+            static constexpr uint32_t MAX_RECORD_SIZE = CAPACITY / 4;
+
+            // Returns nullptr when the ring is full, the caller decides whether to drop or log synchronously.
+            // Sizes above MAX_RECORD_SIZE are the caller's to reject.
+            std::byte* beginWrite(uint32_t size)
+            {
+                uint64_t head = mHead.load(std::memory_order_relaxed);
+                uint64_t tail = mTail.load(std::memory_order_acquire);
+
+                uint32_t offset = static_cast<uint32_t>(head % CAPACITY);
+                uint32_t padding = CAPACITY - offset < size ? CAPACITY - offset : 0;
+                if(head + padding + size - tail > CAPACITY) return nullptr;
+
+                if(padding >= sizeof(LogRecord))
+                {
+                    LogRecord* skip = reinterpret_cast<LogRecord*>(mData + offset);
+                    skip->size = padding;
+                    skip->flags = LogRecord::FLAG_PADDING;
+                }
+
+                mPendingHead = head + padding + size;
+                return mData + (offset + padding) % CAPACITY;
+            }
+
+            void commitWrite()
+            {
+                mHead.store(mPendingHead, std::memory_order_release);
+            }
+
+            template<typename F>
+            void drain(F&& consumer)
+            {
+                uint64_t tail = mTail.load(std::memory_order_relaxed);
+                uint64_t head = mHead.load(std::memory_order_acquire);
+
+                while(tail != head)
+                {
+                    uint32_t offset = static_cast<uint32_t>(tail % CAPACITY);
+
+                    // Too little room for a header at the end means the producer wrapped without marking it.
+                    if(CAPACITY - offset < sizeof(LogRecord))
+                    {
+                        tail += CAPACITY - offset;
+                        continue;
+                    }
+
+                    const LogRecord* record = reinterpret_cast<const LogRecord*>(mData + offset);
+                    if(!(record->flags & LogRecord::FLAG_PADDING))
+                        consumer(*record, mData + offset + sizeof(LogRecord));
+                    tail += record->size;
+                }
+
+                mTail.store(tail, std::memory_order_release);
+            }
+
+            bool isEmpty() const {return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);}
+            uint64_t takeDropped() {return mDropped.exchange(0, std::memory_order_relaxed);}
+            void countDropped() {mDropped.fetch_add(1, std::memory_order_relaxed);}
+
+            std::atomic<bool> retired{false};
+        private:
+            alignas(64) std::byte mData[CAPACITY];
+            alignas(64) std::atomic<uint64_t> mHead{0};
+            uint64_t mPendingHead = 0;
+            alignas(64) std::atomic<uint64_t> mTail{0};
+            std::atomic<uint64_t> mDropped{0};
+        };
+
+        // Owns the per-thread rings and the sink thread that formats their records and hands them to spdlog.
+        class LogBackend
+        {
+        public:
+            static LogBackend& getInstance();
+
+            uint16_t registerLogger(std::shared_ptr<spdlog::logger> logger);
+            LogRing& getThreadRing();
+
+            // Formats everything queued so far on the calling thread. Used before exit and after critical messages.
+            void flush();
+        private:
+            LogBackend() = default;
+            ~LogBackend();
+
+            struct PendingMessage
+            {
+                int64_t timestamp;
+                uint16_t loggerId;
+                uint8_t level;
+                std::string text;
+            };
+
+            void startSink();
+            void sinkLoop();
+            void drainRings();
+
+            std::mutex mLoggerMutex;
+            std::vector<std::shared_ptr<spdlog::logger>> mLoggers;
+
+            std::mutex mRingMutex;
+            std::vector<std::unique_ptr<LogRing>> mRings;
+            std::vector<LogRing*> mFreeRings;
+
+            std::vector<PendingMessage> mPending;
+            fmt::memory_buffer mFormatBuffer;
+
+            std::thread mSink;
+            std::atomic<bool> mRunning{false};
+            std::mutex mWakeMutex;
+            std::condition_variable mWake;
+        };
+
+        namespace logdetail
+        {
+            template<typename T>
+            using Decayed = std::remove_cv_t<std::remove_reference_t<T>>;
+
+            template<typename T>
+            constexpr bool isString = std::is_same_v<std::decay_t<Decayed<T>>, char*> || std::is_same_v<std::decay_t<Decayed<T>>, const char*>
+                || std::is_same_v<Decayed<T>, std::string> || std::is_same_v<Decayed<T>, std::string_view>;
+
+            // Strings are copied into the record, everything else must be trivially copyable so it can be memcpy'd.
+            // Anything fancier (paths, glm types) should be converted or formatted at the call site.
+            template<typename T>
+            using Stored = std::conditional_t<isString<T>, std::string_view, Decayed<T>>;
+
+            template<typename T>
+            constexpr void checkArgument()
+            {
+                static_assert(isString<T> || std::is_trivially_copyable_v<Decayed<T>>, "Logger arguments must be strings or trivially copyable, format others at the call site.");
+            }
+
+            inline std::string_view toView(const char* value) {return value ? std::string_view(value) : std::string_view("(null)");}
+            inline std::string_view toView(std::string_view value) {return value;}
+
+            template<typename T>
+            inline size_t encodedSize(const T& value)
+            {
+                if constexpr(isString<T>) return sizeof(uint32_t) + toView(value).size();
+                else return sizeof(T);
+            }
+
+            template<typename T>
+            inline void encode(std::byte*& cursor, const T& value)
+            {
+                if constexpr(isString<T>)
+                {
+                    std::string_view view = toView(value);
+                    uint32_t length = static_cast<uint32_t>(view.size());
+                    memcpy(cursor, &length, sizeof(length));
+                    memcpy(cursor + sizeof(length), view.data(), length);
+                    cursor += sizeof(length) + length;
+                }
+                else
+                {
+                    memcpy(cursor, &value, sizeof(T));
+                    cursor += sizeof(T);
+                }
+            }
+
+            template<typename T>
+            inline Stored<T> decodeArgument(const std::byte*& cursor)
+            {
+                if constexpr(isString<T>)
+                {
+                    uint32_t length;
+                    memcpy(&length, cursor, sizeof(length));
+                    std::string_view view(reinterpret_cast<const char*>(cursor + sizeof(length)), length);
+                    cursor += sizeof(length) + length;
+                    return view;
+                }
+                else
+                {
+                    Stored<T> value;
+                    memcpy(&value, cursor, sizeof(value));
+                    cursor += sizeof(value);
+                    return value;
+                }
+            }
+
+            template<typename... Args>
+            void decode(const std::byte* payload, std::string_view format, fmt::memory_buffer& out)
+            {
+                // Braced initialization evaluates left to right, matching the order the arguments were encoded in.
+                std::tuple<Stored<Args>...> values{decodeArgument<Args>(payload)...};
+                std::apply([&](auto&... value)
+                {
+                    fmt::vformat_to(fmt::appender(out), fmt::string_view(format.data(), format.size()), fmt::make_format_args(value...));
+                }, values);
+            }
+        }
+    }
+}
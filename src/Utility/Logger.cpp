@@ -5,6 +5,7 @@ std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> ke::util::Logger::sSharedSi
 ke::util::Logger::Logger(const char *name)
 {
     mLogger = std::make_shared<spdlog::logger>(name, sSharedSink);
+    mId = LogBackend::getInstance().registerLogger(mLogger);
 }
 
 void ke::util::Logger::initLoggers()
@@ -13,44 +14,9 @@ void ke::util::Logger::initLoggers()
     spdlog::set_level(spdlog::level::debug);
 }
 
-void ke::util::Logger::trace(const char *msg) const
+void ke::util::Logger::flush()
 {
-#ifdef DEBUG
-    mLogger->trace(msg);
-#endif
-}
-
-void ke::util::Logger::debug(const char *msg) const
-{
-#ifdef DEBUG
-    mLogger->debug(msg);
-#endif
-}
-
-void ke::util::Logger::info(const char *msg) const
-{
-#ifdef DEBUG
-    mLogger->info(msg);
-#endif
-}
-
-void ke::util::Logger::warn(const char *msg) const
-{
-#ifdef DEBUG
-    mLogger->warn(msg);
-#endif
-}
-
-void ke::util::Logger::error(const char *msg) const
-{
-#ifdef DEBUG
-    mLogger->error(msg);
-#endif
-}
-
-void ke::util::Logger::critical(const char *msg) const
-{
-#ifdef DEBUG
-    mLogger->critical(msg);
+#if KE_LOG_ACTIVE_LEVEL < KE_LOG_LEVEL_OFF
+    LogBackend::getInstance().flush();
 #endif
 }
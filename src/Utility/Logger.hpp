@@ -3,10 +3,32 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <memory.h>
 
+#include "LogBackend.hpp"
+
+#define KE_LOG_LEVEL_TRACE 0
+#define KE_LOG_LEVEL_DEBUG 1
+#define KE_LOG_LEVEL_INFO 2
+#define KE_LOG_LEVEL_WARN 3
+#define KE_LOG_LEVEL_ERROR 4
+#define KE_LOG_LEVEL_CRITICAL 5
+#define KE_LOG_LEVEL_OFF 6
+
+// Calls below this level compile to nothing. Defaults keep the old behaviour of logging only in Debug builds,
+// premake's --log-level overrides it.
+#ifndef KE_LOG_ACTIVE_LEVEL
+    #ifdef DEBUG
+        #define KE_LOG_ACTIVE_LEVEL KE_LOG_LEVEL_TRACE
+    #else
+        #define KE_LOG_ACTIVE_LEVEL KE_LOG_LEVEL_OFF
+    #endif
+#endif
+
 namespace ke
 {
     namespace util
     {
+        // Messages are queued as binary records on a per-thread ring and formatted by LogBackend's sink thread,
+        // so a call costs a timestamp and a few memcpys. Arguments use fmt syntax and are checked at compile time.
         class Logger
         {
         public:
@@ -14,16 +36,98 @@ namespace ke
             Logger(const char* name);
 
             static void initLoggers();
+            static void flush();
+
+            template<typename... Args>
+            void trace(fmt::format_string<Args...> format, Args&&... args) const
+            {
+                if constexpr(KE_LOG_ACTIVE_LEVEL <= KE_LOG_LEVEL_TRACE) write(spdlog::level::trace, format, std::forward<Args>(args)...);
+            }
+
+            template<typename... Args>
+            void debug(fmt::format_string<Args...> format, Args&&... args) const
+            {
+                if constexpr(KE_LOG_ACTIVE_LEVEL <= KE_LOG_LEVEL_DEBUG) write(spdlog::level::debug, format, std::forward<Args>(args)...);
+            }
+
+            template<typename... Args>
+            void info(fmt::format_string<Args...> format, Args&&... args) const
+            {
+                if constexpr(KE_LOG_ACTIVE_LEVEL <= KE_LOG_LEVEL_INFO) write(spdlog::level::info, format, std::forward<Args>(args)...);
+            }
+
+            template<typename... Args>
+            void warn(fmt::format_string<Args...> format, Args&&... args) const
+            {
+                if constexpr(KE_LOG_ACTIVE_LEVEL <= KE_LOG_LEVEL_WARN) write(spdlog::level::warn, format, std::forward<Args>(args)...);
+            }
+
+            template<typename... Args>
+            void error(fmt::format_string<Args...> format, Args&&... args) const
+            {
+                if constexpr(KE_LOG_ACTIVE_LEVEL <= KE_LOG_LEVEL_ERROR) write(spdlog::level::err, format, std::forward<Args>(args)...);
+            }
+
+            template<typename... Args>
+            void critical(fmt::format_string<Args...> format, Args&&... args) const
+            {
+                if constexpr(KE_LOG_ACTIVE_LEVEL <= KE_LOG_LEVEL_CRITICAL)
+                {
+                    write(spdlog::level::critical, format, std::forward<Args>(args)...);
+                    flush();
+                }
+            }
 
-            void trace(const char* msg) const;
-            void debug(const char* msg) const;
-            void info(const char* msg) const;
-            void warn(const char* msg) const;
-            void error(const char* msg) const;
-            void critical(const char* msg) const;
+            // Plain messages, the text is copied into the record since callers often pass temporaries.
+            void trace(const char* msg) const {trace("{}", msg);}
+            void debug(const char* msg) const {debug("{}", msg);}
+            void info(const char* msg) const {info("{}", msg);}
+            void warn(const char* msg) const {warn("{}", msg);}
+            void error(const char* msg) const {error("{}", msg);}
+            void critical(const char* msg) const {critical("{}", msg);}
         private:
+            template<typename... Args>
+            void write(spdlog::level::level_enum level, fmt::format_string<Args...> format, Args&&... args) const
+            {
+                if(!mLogger || !mLogger->should_log(level)) return;
+
+                (logdetail::checkArgument<Args>(), ...);
+
+                size_t size = sizeof(LogRecord) + (logdetail::encodedSize(args) + ... + size_t(0));
+                size = (size + 7) & ~size_t(7);
+
+                static thread_local LogRing* ring = &LogBackend::getInstance().getThreadRing();
+                bool oversized = size > LogRing::MAX_RECORD_SIZE;
+                std::byte* out = oversized ? nullptr : ring->beginWrite(static_cast<uint32_t>(size));
+                if(!out)
+                {
+                    // Never block the frame on a full ring: drop chatter, but still get problems out synchronously.
+                    if(oversized || level >= spdlog::level::warn) mLogger->log(level, format, std::forward<Args>(args)...);
+                    else ring->countDropped();
+                    return;
+                }
+
+                fmt::string_view formatView = format.get();
+
+                LogRecord* record = reinterpret_cast<LogRecord*>(out);
+                record->size = static_cast<uint32_t>(size);
+                record->loggerId = mId;
+                record->level = static_cast<uint8_t>(level);
+                record->flags = 0;
+                record->timestamp = std::chrono::system_clock::now().time_since_epoch().count();
+                record->decode = &logdetail::decode<Args...>;
+                record->format = formatView.data();
+                record->formatSize = formatView.size();
+
+                std::byte* cursor = out + sizeof(LogRecord);
+                (logdetail::encode(cursor, args), ...);
+
+                ring->commitWrite();
+            }
+
             std::shared_ptr<spdlog::logger> mLogger;
+            uint16_t mId = 0;
             static std::shared_ptr<spdlog::sinks::stdout_color_sink_mt> sSharedSink;
         };
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,121 @@
+#include "Profiler.hpp"
+
+#include <chrono>
+#include <fstream>
+
+ke::util::Profiler& ke::util::Profiler::getInstance()
+{
+    static Profiler instance;
+    return instance;
+}
+
+uint64_t ke::util::Profiler::now()
+{
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+ke::util::ProfileRing& ke::util::Profiler::getThreadRing()
+{
+    static thread_local ProfileRing* ring = nullptr;
+    if(ring) return *ring;
+
+    // Rings outlive their threads so events recorded right before a thread exits still get collected.
+    std::lock_guard<std::mutex> lock(mRingMutex);
+    mRings.push_back(std::make_unique<ProfileRing>(static_cast<uint32_t>(mRings.size())));
+    ring = mRings.back().get();
+
+    return *ring;
+}
+
+void ke::util::Profiler::setThreadName(const char* name)
+{
+    ProfileRing& ring = getThreadRing();
+
+    std::lock_guard<std::mutex> lock(mRingMutex);
+    ring.threadName = name;
+}
+
+void ke::util::Profiler::collect()
+{
+    std::lock_guard<std::mutex> lock(mRingMutex);
+
+    for(const std::unique_ptr<ProfileRing>& ring : mRings)
+    {
+        uint32_t threadId = ring->getThreadId();
+        ring->drain([this, threadId](const ProfileEvent& event)
+        {
+            if(!mCapturing) return;
+
+            if(mCapture.size() >= MAX_CAPTURED_EVENTS)
+            {
+                mCaptureTruncated = true;
+                return;
+            }
+            mCapture.push_back(CapturedEvent{event, threadId});
+        });
+
+        uint64_t dropped = ring->takeDropped();
+        if(dropped > 0 && mCapturing)
+            mLogger.warn("Dropped {} profiler events on thread {}, collect more often.", dropped, threadId);
+    }
+}
+
+void ke::util::Profiler::beginCapture()
+{
+    collect();
+
+    mCapture.clear();
+    mCaptureTruncated = false;
+    mCapturing = true;
+
+    mLogger.info("Started profiler capture.");
+}
+
+void ke::util::Profiler::endCapture(const std::string& path)
+{
+    if(!mCapturing) return;
+
+    collect();
+    mCapturing = false;
+
+    if(mCaptureTruncated)
+        mLogger.warn("Profiler capture hit the {} event limit and was truncated.", MAX_CAPTURED_EVENTS);
+
+    std::lock_guard<std::mutex> lock(mRingMutex);
+    writeChromeTrace(path);
+    mCapture.clear();
+}
+
+void ke::util::Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream file(path, std::ios::trunc);
+    if(!file)
+    {
+        mLogger.error("Failed to open {} for the profiler trace!", path);
+        return;
+    }
+
+    // Chrome's trace event format, also understood by Perfetto: complete ("X") events in microseconds.
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for(const std::unique_ptr<ProfileRing>& ring : mRings)
+    {
+        if(ring->threadName.empty()) continue;
+
+        file << (first ? "" : ",\n") << fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}", ring->getThreadId(), ring->threadName);
+        first = false;
+    }
+
+    for(const CapturedEvent& captured : mCapture)
+    {
+        file << (first ? "" : ",\n") << fmt::format("{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+            captured.event.name, captured.threadId, captured.event.start / 1000.0, (captured.event.end - captured.event.start) / 1000.0);
+        first = false;
+    }
+
+    file << "\n]}\n";
+
+    mLogger.info("Wrote {} profiler events to {}.", mCapture.size(), path);
+}
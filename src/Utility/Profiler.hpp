@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Logger.hpp"
+
+namespace ke
+{
+    namespace util
+    {
+        struct ProfileEvent
+        {
+            const char* name;   // must have static storage, zones store the pointer only
+            uint64_t start;     // ns since the profiler epoch
+            uint64_t end;
+        };
+
+        // Written only by its owning thread and drained only by Profiler::collect, so the two indices are the
+        // only shared state. When the consumer falls behind new events are dropped rather than blocking.
+        class ProfileRing
+        {
+        public:
+            static constexpr uint32_t CAPACITY = 1 << 14;
+
+            explicit ProfileRing(uint32_t threadId) : mThreadId(threadId) {}
+
+            void push(const ProfileEvent& event)
+            {
+                uint32_t head = mHead.load(std::memory_order_relaxed);
+                if(head - mTail.load(std::memory_order_acquire) >= CAPACITY)
+                {
+                    mDropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                mEvents[head % CAPACITY] = event;
+                mHead.store(head + 1, std::memory_order_release);
+            }
+
+            template<typename F>
+            void drain(F&& consumer)
+            {
+                uint32_t tail = mTail.load(std::memory_order_relaxed);
+                uint32_t head = mHead.load(std::memory_order_acquire);
+
+                for(; tail != head; tail++)
+                    consumer(mEvents[tail % CAPACITY]);
+
+                mTail.store(tail, std::memory_order_release);
+            }
+
+            uint32_t getThreadId() const {return mThreadId;}
+            uint64_t takeDropped() {return mDropped.exchange(0, std::memory_order_relaxed);}
+
+            std::string threadName;
+        private:
+            std::array<ProfileEvent, CAPACITY> mEvents;
+            std::atomic<uint32_t> mHead{0};
+            std::atomic<uint32_t> mTail{0};
+            std::atomic<uint64_t> mDropped{0};
+            uint32_t mThreadId;
+        };
+
+        class Profiler
+        {
+        public:
+            static Profiler& getInstance();
+
+            static uint64_t now();
+            ProfileRing& getThreadRing();
+            void setThreadName(const char* name);
+
+            // Drains every thread's ring, events are kept only while a capture is running.
+            void collect();
+
+            void beginCapture();
+            void endCapture(const std::string& path);
+            bool isCapturing() const {return mCapturing;}
+        private:
+            Profiler() = default;
+
+            struct CapturedEvent
+            {
+                ProfileEvent event;
+                uint32_t threadId;
+            };
+
+            static constexpr size_t MAX_CAPTURED_EVENTS = 1 << 22;
+
+            void writeChromeTrace(const std::string& path) const;
+
+            util::Logger mLogger = util::Logger("Profiler Logger");
+
+            std::mutex mRingMutex;
+            std::vector<std::unique_ptr<ProfileRing>> mRings;
+
+            std::vector<CapturedEvent> mCapture;
+            bool mCapturing = false;
+            bool mCaptureTruncated = false;
+        };
+
+        class ProfileZone
+        {
+        public:
+            explicit ProfileZone(const char* name) : mName(name), mStart(Profiler::now()) {}
+            ~ProfileZone()
+            {
+                static thread_local ProfileRing& ring = Profiler::getInstance().getThreadRing();
+                ring.push(ProfileEvent{mName, mStart, Profiler::now()});
+            }
+
+            ProfileZone(const ProfileZone&) = delete;
+            ProfileZone& operator=(const ProfileZone&) = delete;
+        private:
+            const char* mName;
+            uint64_t mStart;
+        };
+    }
+}
+
+// Built with --profile (premake) the macros record zones, otherwise they compile to nothing.
+#ifdef KE_PROFILE
+    #define KE_PROFILE_CONCAT_INNER(a, b) a##b
+    #define KE_PROFILE_CONCAT(a, b) KE_PROFILE_CONCAT_INNER(a, b)
+    #define KE_PROFILE_ZONE(name) ::ke::util::ProfileZone KE_PROFILE_CONCAT(keProfileZone, __LINE__)(name)
+    #define KE_PROFILE_FUNCTION() KE_PROFILE_ZONE(__func__)
+    #define KE_PROFILE_THREAD(name) ::ke::util::Profiler::getInstance().setThreadName(name)
+    #define KE_PROFILE_COLLECT() ::ke::util::Profiler::getInstance().collect()
+#else
+    #define KE_PROFILE_ZONE(name) ((void)0)
+    #define KE_PROFILE_FUNCTION() ((void)0)
+    #define KE_PROFILE_THREAD(name) ((void)0)
+    #define KE_PROFILE_COLLECT() ((void)0)
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <cstdlib>
+#include <memory>
 #include <optional>
 #include <fstream>
 #include <glm/glm.hpp>
@@ -51,6 +53,19 @@ namespace ke
         static float srgbToLinear(float c)
         {return powf(c, 2.2f);}
 
+        // First memory type allowed by typeFilter that has every requested property, UINT32_MAX if there is none.
+        static uint32_t findMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeFilter, VkMemoryPropertyFlags properties)
+        {
+            VkPhysicalDeviceMemoryProperties memoryProperties;
+            vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+            for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+                if((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+                    return i;
+
+            return UINT32_MAX;
+        }
+
         struct UniformBufferObject
         {
             glm::mat4 model;
@@ -58,6 +73,14 @@ namespace ke
             glm::mat4 proj;
         };
 
+        // RGBA8 pixels decoded off the render thread, uploaded with Renderer::createTextureImage later.
+        struct DecodedImage
+        {
+            int width = 0;
+            int height = 0;
+            std::unique_ptr<unsigned char, void(*)(void*)> pixels{nullptr, std::free};
+        };
+
         struct Image
         {
             VkImage image;
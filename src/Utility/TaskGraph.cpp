@@ -0,0 +1,120 @@
+#include "TaskGraph.hpp"
+
+#include <algorithm>
+
+ke::util::TaskGraph::TaskId ke::util::TaskGraph::add(const char* name, std::function<void()> function, std::initializer_list<TaskId> dependencies, JobAffinity affinity)
+{
+    TaskId id = static_cast<TaskId>(mTasks.size());
+    Task& task = mTasks.emplace_back();
+    task.name = name;
+    task.function = std::move(function);
+    task.affinity = affinity;
+
+    for(TaskId dependency : dependencies)
+    {
+        if(dependency >= id)
+        {
+            mLogger.error("Task {} depends on a task that wasn't added before it, ignoring the dependency.", name);
+            continue;
+        }
+        task.dependencies.push_back(dependency);
+        mTasks[dependency].dependents.push_back(id);
+    }
+
+    return id;
+}
+
+void ke::util::TaskGraph::run()
+{
+    mStart = std::chrono::steady_clock::now();
+
+    for(Task& task : mTasks)
+        task.unresolved.store(static_cast<uint32_t>(task.dependencies.size()), std::memory_order_relaxed);
+
+    for(TaskId id = 0; id < mTasks.size(); id++)
+        if(mTasks[id].dependencies.empty()) launch(id);
+
+    // Dependents are launched from inside the finishing task, so the counter can't drain early.
+    JobSystem::getInstance().wait(mDone);
+    mWallTime = sinceStart();
+}
+
+void ke::util::TaskGraph::launch(TaskId id)
+{
+    const Task& queued = mTasks[id];
+    JobSystem::getInstance().schedule([this, id]()
+    {
+        Task& task = mTasks[id];
+        task.worker = JobSystem::getInstance().getCurrentWorker();
+        task.start = sinceStart();
+        task.function();
+        task.end = sinceStart();
+
+        for(TaskId dependent : task.dependents)
+            if(mTasks[dependent].unresolved.fetch_sub(1, std::memory_order_acq_rel) == 1) launch(dependent);
+    }, {queued.name, &mDone, nullptr, queued.affinity});
+}
+
+double ke::util::TaskGraph::sinceStart() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+}
+
+std::vector<ke::util::TaskGraph::TaskId> ke::util::TaskGraph::getCriticalPath() const
+{
+    if(mTasks.empty()) return {};
+
+    // Walk back from the task that finished last, always through the dependency that released it.
+    TaskId current = 0;
+    for(TaskId id = 1; id < mTasks.size(); id++)
+        if(mTasks[id].end > mTasks[current].end) current = id;
+
+    std::vector<TaskId> path{current};
+    while(!mTasks[current].dependencies.empty())
+    {
+        current = *std::max_element(mTasks[current].dependencies.begin(), mTasks[current].dependencies.end(), [this](TaskId a, TaskId b)
+        {
+            return mTasks[a].end < mTasks[b].end;
+        });
+        path.push_back(current);
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+void ke::util::TaskGraph::logTimeline() const
+{
+    constexpr int BAR_WIDTH = 40;
+
+    std::vector<TaskId> criticalPath = getCriticalPath();
+    double work = 0.0;
+    for(const Task& task : mTasks)
+        work += task.end - task.start;
+
+    mLogger.info("{} took {:.1f} ms, {:.1f} ms of work across {} tasks.", mName, mWallTime, work, mTasks.size());
+
+    for(TaskId id = 0; id < mTasks.size(); id++)
+    {
+        const Task& task = mTasks[id];
+        bool critical = std::find(criticalPath.begin(), criticalPath.end(), id) != criticalPath.end();
+
+        int from = mWallTime > 0.0 ? static_cast<int>(task.start / mWallTime * BAR_WIDTH) : 0;
+        int to = mWallTime > 0.0 ? static_cast<int>(task.end / mWallTime * BAR_WIDTH) : 0;
+        std::string bar(BAR_WIDTH, ' ');
+        for(int i = std::min(from, BAR_WIDTH - 1); i <= std::min(to, BAR_WIDTH - 1); i++)
+            bar[i] = critical ? '#' : '=';
+
+        std::string thread = task.worker == 0 ? std::string("main") : task.worker == UINT32_MAX ? std::string("-") : fmt::format("w{}", task.worker);
+        mLogger.info("{}{:<16} {:>8.1f} {:>8.1f} {:>8.1f} ms {:<5} |{}|", critical ? '*' : ' ', task.name, task.start, task.end, task.end - task.start, thread, bar);
+    }
+
+    std::string path;
+    double pathTime = 0.0;
+    for(TaskId id : criticalPath)
+    {
+        path += path.empty() ? mTasks[id].name : fmt::format(" > {}", mTasks[id].name);
+        pathTime += mTasks[id].end - mTasks[id].start;
+    }
+    mLogger.info("Critical path: {} ({:.1f} ms busy, {:.1f} ms waiting)", path, pathTime, mWallTime - pathTime);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "Logger.hpp"
+
+namespace ke
+{
+    namespace util
+    {
+        // Named tasks with declared dependencies, run once on the job system. A task starts as soon as everything
+        // it depends on has finished, and the timeline afterwards shows which chain of tasks bounded the total time.
+        class TaskGraph
+        {
+        public:
+            using TaskId = uint32_t;
+
+            explicit TaskGraph(const char* name) : mName(name) {}
+
+            // Dependencies have to be added first, which keeps the graph acyclic by construction.
+            TaskId add(const char* name, std::function<void()> function, std::initializer_list<TaskId> dependencies = {}, JobAffinity affinity = JobAffinity::Any);
+
+            void run();
+
+            std::vector<TaskId> getCriticalPath() const;
+            void logTimeline() const;
+        private:
+            struct Task
+            {
+                const char* name;
+                std::function<void()> function;
+                std::vector<TaskId> dependencies;
+                std::vector<TaskId> dependents;
+                JobAffinity affinity;
+                std::atomic<uint32_t> unresolved{0};
+
+                double start = 0.0;     // ms since run()
+                double end = 0.0;
+                uint32_t worker = 0;
+            };
+
+            void launch(TaskId id);
+            double sinceStart() const;
+
+            util::Logger mLogger = util::Logger("Task Graph Logger");
+
+            const char* mName;
+            std::deque<Task> mTasks;
+            JobCounter mDone;
+            std::chrono::steady_clock::time_point mStart;
+            double mWallTime = 0.0;
+        };
+    }
+}
@@ -0,0 +1,278 @@
+#include "UILayout.hpp"
+#include "XMLparser.hpp"
+#include "../Graphics/TextLayout.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+ke::gui::Length ke::gui::Length::parse(const char* text)
+{
+    Length length;
+    if(text == nullptr || *text == '\0') return length;
+
+    if(strcmp(text, "auto") == 0)
+    {
+        length.unit = Unit::Auto;
+        return length;
+    }
+
+    char* end = nullptr;
+    length.value = std::strtof(text, &end);
+    if(end == text) return length;
+
+    length.unit = strncmp(end, "px", 2) == 0 ? Unit::Pixels : Unit::Percent;
+    return length;
+}
+
+ke::gui::LayoutNode::LayoutNode(LayoutStyle style, Element* element)
+    : mStyle(std::move(style)), pElement(element)
+{
+    // Spacing this node puts between its children.
+    mViewportDependent = mStyle.padding.dependsOnViewport() || mStyle.gap.dependsOnViewport() || mStyle.rowHeight.dependsOnViewport();
+}
+
+ke::gui::LayoutNode* ke::gui::LayoutNode::addChild(std::unique_ptr<LayoutNode> child)
+{
+    const LayoutStyle& style = child->mStyle;
+    bool dependent = child->mViewportDependent;
+    for(const Length* length : {&style.x, &style.y, &style.w, &style.h, &style.minW, &style.maxW, &style.minH, &style.maxH})
+        dependent = dependent || length->dependsOnViewport();
+
+    // Where the child ends up now depends on the window size, so every ancestor has to be visited on a resize.
+    if(dependent)
+        for(LayoutNode* node = this; node && !node->mViewportDependent; node = node->pParent)
+            node->mViewportDependent = true;
+
+    child->pParent = this;
+    mChildren.push_back(std::move(child));
+    markDirty();
+    return mChildren.back().get();
+}
+
+void ke::gui::LayoutNode::markDirty()
+{
+    for(LayoutNode* node = this; node && !node->mDirty; node = node->pParent)
+        node->mDirty = true;
+}
+
+size_t ke::gui::LayoutNode::getNodeCount() const
+{
+    size_t count = 1;
+    for(const auto& child : mChildren)
+        count += child->getNodeCount();
+    return count;
+}
+
+float ke::gui::LayoutNode::resolve(const Length& length, float parentExtent, float pixelsPerUnit) const
+{
+    switch(length.unit)
+    {
+        case Length::Unit::Percent: return length.value / 100.0f * parentExtent;
+        case Length::Unit::Pixels: return pixelsPerUnit > 0.0f ? length.value / pixelsPerUnit : 0.0f;
+        default: return 0.0f;
+    }
+}
+
+float ke::gui::LayoutNode::clampWidth(float w, float parentW, glm::vec2 viewport) const
+{
+    if(mStyle.maxW.isSet()) w = std::min(w, resolve(mStyle.maxW, parentW, viewport.x));
+    if(mStyle.minW.isSet()) w = std::max(w, resolve(mStyle.minW, parentW, viewport.x));
+    return std::max(w, 0.0f);
+}
+
+float ke::gui::LayoutNode::clampHeight(float h, float parentH, glm::vec2 viewport) const
+{
+    if(mStyle.maxH.isSet()) h = std::min(h, resolve(mStyle.maxH, parentH, viewport.y));
+    if(mStyle.minH.isSet()) h = std::max(h, resolve(mStyle.minH, parentH, viewport.y));
+    return std::max(h, 0.0f);
+}
+
+float ke::gui::LayoutNode::measureText(float height, glm::vec2 viewport) const
+{
+    if(mStyle.text.empty() || viewport.x <= 0.0f) return 0.0f;
+
+    // Input fields draw their text at their own height with a 5 pixel inset, measure it the same way.
+    Graphics::Text::TextStyle style;
+    style.pixelSize = height * viewport.y;
+
+    Graphics::Text::Font& font = Graphics::Text::TextUtils::getInstance().getFont("DejaVuSans");
+    std::shared_ptr<const Graphics::Text::ShapedRun> run = Graphics::Text::TextLayout::getInstance().shape(mStyle.text, font, style);
+
+    return (run->size.x + 10.0f) / viewport.x;
+}
+
+void ke::gui::LayoutNode::arrangeAbsolute(const LayoutRect& content, glm::vec2 viewport, std::vector<LayoutRect>& rects) const
+{
+    for(size_t i = 0; i < mChildren.size(); i++)
+    {
+        const LayoutNode& child = *mChildren[i];
+        const LayoutStyle& style = child.mStyle;
+
+        float h = style.h.isSet() && style.h.unit != Length::Unit::Auto ? resolve(style.h, content.h, viewport.y) : content.h;
+        h = child.clampHeight(h, content.h, viewport);
+
+        float w = content.w;
+        if(style.w.unit == Length::Unit::Auto) w = child.measureText(h, viewport);
+        else if(style.w.isSet()) w = resolve(style.w, content.w, viewport.x);
+        w = child.clampWidth(w, content.w, viewport);
+
+        rects[i] = LayoutRect{content.x + resolve(style.x, content.w, viewport.x), content.y + resolve(style.y, content.h, viewport.y), w, h};
+    }
+}
+
+void ke::gui::LayoutNode::arrangeFlex(const LayoutRect& content, glm::vec2 viewport, std::vector<LayoutRect>& rects) const
+{
+    bool row = mStyle.mode == LayoutMode::Row;
+    size_t count = mChildren.size();
+
+    float mainExtent = row ? content.w : content.h;
+    float crossExtent = row ? content.h : content.w;
+    float gap = row ? resolve(mStyle.gap, content.w, viewport.x) : resolve(mStyle.gap, content.h, viewport.y);
+
+    auto clampMain = [&](const LayoutNode& child, float size)
+    {
+        return row ? child.clampWidth(size, content.w, viewport) : child.clampHeight(size, content.h, viewport);
+    };
+
+    std::vector<float> base(count), sizes(count), grow(count), cross(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        const LayoutNode& child = *mChildren[i];
+        const LayoutStyle& style = child.mStyle;
+        const Length& mainLength = row ? style.w : style.h;
+        const Length& crossLength = row ? style.h : style.w;
+
+        // Stretch across unless the child asks for a size.
+        if(crossLength.isSet() && crossLength.unit != Length::Unit::Auto)
+            cross[i] = row ? resolve(crossLength, content.h, viewport.y) : resolve(crossLength, content.w, viewport.x);
+        else
+            cross[i] = crossExtent;
+        cross[i] = row ? child.clampHeight(cross[i], content.h, viewport) : child.clampWidth(cross[i], content.w, viewport);
+
+        if(row && mainLength.unit == Length::Unit::Auto) base[i] = child.measureText(cross[i], viewport);
+        else if(mainLength.unit != Length::Unit::Auto) base[i] = resolve(mainLength, mainExtent, row ? viewport.x : viewport.y);
+
+        // With neither a size nor a weight, children share the space evenly.
+        grow[i] = style.grow > 0.0f || mainLength.isSet() ? style.grow : 1.0f;
+        base[i] = sizes[i] = clampMain(child, base[i]);
+    }
+
+    // Hand out the free space by weight. A child that hits its min or max keeps that size and the rest is
+    // shared again among the others.
+    std::vector<bool> frozen(count);
+    for(size_t i = 0; i < count; i++)
+        frozen[i] = grow[i] <= 0.0f;
+
+    while(true)
+    {
+        float used = gap * static_cast<float>(count > 0 ? count - 1 : 0);
+        float totalGrow = 0.0f;
+        for(size_t i = 0; i < count; i++)
+        {
+            used += frozen[i] ? sizes[i] : base[i];
+            if(!frozen[i]) totalGrow += grow[i];
+        }
+
+        float free = mainExtent - used;
+        if(totalGrow <= 0.0f || free <= 0.0f)
+        {
+            for(size_t i = 0; i < count; i++)
+                if(!frozen[i]) sizes[i] = base[i];
+            break;
+        }
+
+        bool clamped = false;
+        for(size_t i = 0; i < count; i++)
+        {
+            if(frozen[i]) continue;
+
+            float target = base[i] + free * grow[i] / totalGrow;
+            sizes[i] = clampMain(*mChildren[i], target);
+            if(sizes[i] != target)
+            {
+                frozen[i] = true;
+                clamped = true;
+            }
+        }
+        if(!clamped) break;
+    }
+
+    // Rows run left to right and columns top to bottom, both hang from the top edge.
+    float pen = row ? content.x : content.y + content.h;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(row)
+        {
+            rects[i] = LayoutRect{pen, content.y + content.h - cross[i], sizes[i], cross[i]};
+            pen += sizes[i] + gap;
+        }
+        else
+        {
+            pen -= sizes[i];
+            rects[i] = LayoutRect{content.x, pen, cross[i], sizes[i]};
+            pen -= gap;
+        }
+    }
+}
+
+void ke::gui::LayoutNode::arrangeGrid(const LayoutRect& content, glm::vec2 viewport, std::vector<LayoutRect>& rects) const
+{
+    uint32_t columns = std::max(mStyle.columns, 1u);
+    uint32_t rows = static_cast<uint32_t>((mChildren.size() + columns - 1) / columns);
+    if(rows == 0) return;
+
+    float gapX = resolve(mStyle.gap, content.w, viewport.x);
+    float gapY = resolve(mStyle.gap, content.h, viewport.y);
+
+    float cellW = (content.w - gapX * static_cast<float>(columns - 1)) / static_cast<float>(columns);
+    float cellH = mStyle.rowHeight.isSet() ? resolve(mStyle.rowHeight, content.h, viewport.y)
+                                           : (content.h - gapY * static_cast<float>(rows - 1)) / static_cast<float>(rows);
+
+    for(size_t i = 0; i < mChildren.size(); i++)
+    {
+        uint32_t column = static_cast<uint32_t>(i % columns);
+        uint32_t row = static_cast<uint32_t>(i / columns);
+        const LayoutNode& child = *mChildren[i];
+
+        float x = content.x + static_cast<float>(column) * (cellW + gapX);
+        float top = content.y + content.h - static_cast<float>(row) * (cellH + gapY);
+        float w = child.clampWidth(cellW, content.w, viewport);
+        float h = child.clampHeight(cellH, content.h, viewport);
+
+        rects[i] = LayoutRect{x, top - h, w, h};
+    }
+}
+
+uint32_t ke::gui::LayoutNode::layout(const LayoutRect& rect, glm::vec2 viewport)
+{
+    if(!mDirty && rect == mRect && (!mViewportDependent || viewport == mViewport)) return 0;
+
+    mRect = rect;
+    mViewport = viewport;
+    mDirty = false;
+
+    if(pElement && (pElement->x != rect.x || pElement->y != rect.y || pElement->w != rect.w || pElement->h != rect.h))
+        pElement->setRect(rect.x, rect.y, rect.w, rect.h);
+
+    if(mChildren.empty()) return 1;
+
+    float padX = resolve(mStyle.padding, rect.w, viewport.x);
+    float padY = resolve(mStyle.padding, rect.h, viewport.y);
+    LayoutRect content{rect.x + padX, rect.y + padY, std::max(rect.w - 2.0f * padX, 0.0f), std::max(rect.h - 2.0f * padY, 0.0f)};
+
+    std::vector<LayoutRect> rects(mChildren.size());
+    switch(mStyle.mode)
+    {
+        case LayoutMode::Absolute: arrangeAbsolute(content, viewport, rects); break;
+        case LayoutMode::Row:
+        case LayoutMode::Column: arrangeFlex(content, viewport, rects); break;
+        case LayoutMode::Grid: arrangeGrid(content, viewport, rects); break;
+    }
+
+    uint32_t visited = 1;
+    for(size_t i = 0; i < mChildren.size(); i++)
+        visited += mChildren[i]->layout(rects[i], viewport);
+    return visited;
+}
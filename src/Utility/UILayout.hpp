@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace ke
+{
+    namespace gui
+    {
+        class Element;
+
+        enum class LayoutMode : uint8_t
+        {
+            Absolute,   // children place themselves with x/y/w/h, the original format
+            Row,        // children side by side, left to right
+            Column,     // children stacked, top to bottom
+            Grid        // children fill equal cells row by row
+        };
+
+        // A size in the XML: "25" or "25%" of the parent's content box, "120px", or "auto" to fit the node's text.
+        struct Length
+        {
+            enum class Unit : uint8_t {Unset, Percent, Pixels, Auto};
+
+            float value = 0.0f;
+            Unit unit = Unit::Unset;
+
+            static Length parse(const char* text);
+
+            bool isSet() const {return unit != Unit::Unset;}
+            bool dependsOnViewport() const {return unit == Unit::Pixels || unit == Unit::Auto;}
+        };
+
+        // Normalized rect, origin at the bottom left like the element rects.
+        struct LayoutRect
+        {
+            float x = 0.0f, y = 0.0f, w = 0.0f, h = 0.0f;
+
+            bool operator==(const LayoutRect&) const = default;
+        };
+
+        struct LayoutStyle
+        {
+            LayoutMode mode = LayoutMode::Absolute;
+
+            Length x, y, w, h;
+            Length minW, maxW, minH, maxH;
+            float grow = 0.0f;              // share of the free main axis space in a row or column
+
+            Length padding;
+            Length gap;                     // between children in a row, column or grid
+            uint32_t columns = 1;           // grid only
+            Length rowHeight;               // grid only, rows split the height evenly when unset
+
+            // Measured for auto sizes, at a pixel size equal to the node's height.
+            std::string text;
+        };
+
+        // One container or widget of a UI file. A node only rearranges its children when it was marked dirty or
+        // the rect its parent hands it changed, so a resize leaves every subtree whose box didn't move alone.
+        // Pixel sizes and text measurements make a subtree depend on the window size as well, which it tracks.
+        class LayoutNode
+        {
+        public:
+            LayoutNode(LayoutStyle style, Element* element = nullptr);
+
+            LayoutNode* addChild(std::unique_ptr<LayoutNode> child);
+
+            // Lays the tree out inside rect for a viewport of the given pixel size, returns how many nodes were
+            // actually visited. Bound elements get setRect only when their rect really changed.
+            uint32_t layout(const LayoutRect& rect, glm::vec2 viewport);
+
+            // Forces this node and its ancestors to relayout on the next pass, for changes the tree can't see.
+            void markDirty();
+
+            const LayoutRect& getRect() const {return mRect;}
+            const LayoutStyle& getStyle() const {return mStyle;}
+            Element* getElement() const {return pElement;}
+            size_t getNodeCount() const;
+        private:
+            // Sizes along one axis, resolved against a parent extent in normalized units.
+            float resolve(const Length& length, float parentExtent, float pixelsPerUnit) const;
+            float clampWidth(float w, float parentW, glm::vec2 viewport) const;
+            float clampHeight(float h, float parentH, glm::vec2 viewport) const;
+            float measureText(float height, glm::vec2 viewport) const;
+
+            void arrangeAbsolute(const LayoutRect& content, glm::vec2 viewport, std::vector<LayoutRect>& rects) const;
+            void arrangeFlex(const LayoutRect& content, glm::vec2 viewport, std::vector<LayoutRect>& rects) const;
+            void arrangeGrid(const LayoutRect& content, glm::vec2 viewport, std::vector<LayoutRect>& rects) const;
+
+            LayoutStyle mStyle;
+            Element* pElement = nullptr;
+            LayoutNode* pParent = nullptr;
+            std::vector<std::unique_ptr<LayoutNode>> mChildren;
+
+            // Anything under this node uses pixel lengths or text, so its result changes with the viewport.
+            bool mViewportDependent = false;
+            bool mDirty = true;
+            LayoutRect mRect;
+            glm::vec2 mViewport{0.0f};
+        };
+    }
+}
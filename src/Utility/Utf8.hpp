@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ke
+{
+    namespace util
+    {
+        constexpr uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+        // Decodes the code point starting at text[pos] and moves pos past it. Malformed input comes back as
+        // U+FFFD one byte at a time, so a bad byte never swallows the text after it.
+        inline uint32_t decodeUtf8(std::string_view text, size_t& pos)
+        {
+            uint8_t lead = static_cast<uint8_t>(text[pos++]);
+            if(lead < 0x80) return lead;
+
+            uint32_t length, codepoint, minimum;
+            if((lead & 0xE0) == 0xC0) {length = 1; codepoint = lead & 0x1F; minimum = 0x80;}
+            else if((lead & 0xF0) == 0xE0) {length = 2; codepoint = lead & 0x0F; minimum = 0x800;}
+            else if((lead & 0xF8) == 0xF0) {length = 3; codepoint = lead & 0x07; minimum = 0x10000;}
+            else return REPLACEMENT_CHARACTER;
+
+            if(pos + length > text.size()) return REPLACEMENT_CHARACTER;
+
+            for(uint32_t i = 0; i < length; i++)
+            {
+                uint8_t continuation = static_cast<uint8_t>(text[pos + i]);
+                if((continuation & 0xC0) != 0x80) return REPLACEMENT_CHARACTER;
+                codepoint = (codepoint << 6) | (continuation & 0x3F);
+            }
+
+            // Overlong forms and surrogates are invalid UTF-8 even when well formed.
+            if(codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+                return REPLACEMENT_CHARACTER;
+
+            pos += length;
+            return codepoint;
+        }
+
+        inline void appendUtf8(std::string& text, uint32_t codepoint)
+        {
+            if(codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) codepoint = REPLACEMENT_CHARACTER;
+
+            if(codepoint < 0x80)
+                text.push_back(static_cast<char>(codepoint));
+            else if(codepoint < 0x800)
+            {
+                text.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+                text.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+            }
+            else if(codepoint < 0x10000)
+            {
+                text.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+                text.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+                text.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+            }
+            else
+            {
+                text.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+                text.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+                text.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+                text.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+            }
+        }
+
+        // Removes the last code point rather than the last byte.
+        inline bool popUtf8(std::string& text)
+        {
+            if(text.empty()) return false;
+
+            size_t end = text.size() - 1;
+            while(end > 0 && (static_cast<uint8_t>(text[end]) & 0xC0) == 0x80 && text.size() - end < 4) end--;
+
+            text.erase(end);
+            return true;
+        }
+    }
+}
@@ -1,227 +1,232 @@
 #include "XMLparser.hpp"
 #include "RenderUtil.hpp"
 #include "structs.hpp"
+#include "FrameAllocator.hpp"
+#include <cstring>
 #include <vector>
 
-void ke::util::XML::parseFile(std::string filepath, std::vector<std::unique_ptr<gui::Element>>& elements)
+void ke::util::XML::preloadFile(const std::string& filepath)
 {
-    pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file(filepath.c_str());
+    std::unique_ptr<Document> document = std::make_unique<Document>();
+    document->result = document->document.load_file(filepath.c_str());
 
-    mLogger.info(result.description());
-
-    pugi::xml_node root = doc.child("KEUIcomponent");
-    
-    float rootx = root.attribute("x").as_float() / 100.0f;
-    float rooty = root.attribute("y").as_float() / 100.0f;
-    float rootw = root.attribute("w").as_float() / 100.0f;
-    float rooth = root.attribute("h").as_float() / 100.0f;
-
-    for(pugi::xml_node frame : root.children("Frame"))
-    {  
-        float x = frame.attribute("x").as_float() / 100.0f;
-        float y = frame.attribute("y").as_float() / 100.0f;
-        float w = frame.attribute("w").as_float() / 100.0f;
-        float h = frame.attribute("h").as_float() / 100.0f;
+    std::lock_guard<std::mutex> lock(mPreloadMutex);
+    mPreloaded[filepath] = std::move(document);
+}
 
-        x = rootx + rootw * x;
-        y = rooty + rooth * y;
-        w *= rootw;
-        h *= rooth;
+std::unique_ptr<ke::util::XML::Document> ke::util::XML::loadDocument(const std::string& filepath)
+{
+    {
+        std::lock_guard<std::mutex> lock(mPreloadMutex);
+        auto it = mPreloaded.find(filepath);
+        if(it != mPreloaded.end())
+        {
+            std::unique_ptr<Document> document = std::move(it->second);
+            mPreloaded.erase(it);
+            return document;
+        }
+    }
 
+    std::unique_ptr<Document> document = std::make_unique<Document>();
+    document->result = document->document.load_file(filepath.c_str());
+    return document;
+}
 
-        const char* hexColor = frame.attribute("color").as_string();
-        int r, g, b;
+namespace
+{
+    glm::vec3 parseColor(const char* hexColor)
+    {
+        int r = 0, g = 0, b = 0;
         std::sscanf(hexColor, "#%02x%02x%02x", &r, &g, &b);
 
-        float rf = util::srgbToLinear(r / 255.0f);
-        float gf = util::srgbToLinear(g / 255.0f);
-        float bf = util::srgbToLinear(b / 255.0f);
-
-        elements.push_back(std::make_unique<gui::Frame>(x,y,w,h, glm::vec3(rf,gf,bf)));
+        return glm::vec3(ke::util::srgbToLinear(r / 255.0f), ke::util::srgbToLinear(g / 255.0f), ke::util::srgbToLinear(b / 255.0f));
     }
-    for(pugi::xml_node button : root.children("Button"))
-    {
-
-        float x = button.attribute("x").as_float() / 100.0f;
-        float y = button.attribute("y").as_float() / 100.0f;
-        float w = button.attribute("w").as_float() / 100.0f;
-        float h = button.attribute("h").as_float() / 100.0f;
+}
 
-        x = rootx + rootw * x;
-        y = rooty + rooth * y;
-        w *= rootw;
-        h *= rooth;
+ke::gui::LayoutStyle ke::util::XML::parseStyle(pugi::xml_node node) const
+{
+    gui::LayoutStyle style;
+
+    const char* mode = node.attribute("layout").as_string();
+    if(strcmp(mode, "row") == 0) style.mode = gui::LayoutMode::Row;
+    else if(strcmp(mode, "column") == 0 || strcmp(mode, "stack") == 0) style.mode = gui::LayoutMode::Column;
+    else if(strcmp(mode, "grid") == 0) style.mode = gui::LayoutMode::Grid;
+    else if(*mode != '\0' && strcmp(mode, "absolute") != 0) mLogger.warn("Unknown layout \"{}\", using absolute.", mode);
+
+    style.x = gui::Length::parse(node.attribute("x").as_string(nullptr));
+    style.y = gui::Length::parse(node.attribute("y").as_string(nullptr));
+    style.w = gui::Length::parse(node.attribute("w").as_string(nullptr));
+    style.h = gui::Length::parse(node.attribute("h").as_string(nullptr));
+    style.minW = gui::Length::parse(node.attribute("minW").as_string(nullptr));
+    style.maxW = gui::Length::parse(node.attribute("maxW").as_string(nullptr));
+    style.minH = gui::Length::parse(node.attribute("minH").as_string(nullptr));
+    style.maxH = gui::Length::parse(node.attribute("maxH").as_string(nullptr));
+    style.grow = node.attribute("grow").as_float(0.0f);
+
+    style.padding = gui::Length::parse(node.attribute("padding").as_string(nullptr));
+    style.gap = gui::Length::parse(node.attribute("gap").as_string(nullptr));
+    style.columns = node.attribute("columns").as_uint(1);
+    style.rowHeight = gui::Length::parse(node.attribute("rowHeight").as_string(nullptr));
+
+    style.text = node.attribute("text").as_string(node.attribute("placeholder").as_string());
+    return style;
+}
 
-        const char* hexColor = button.attribute("color").as_string();
-        int r, g, b;
-        std::sscanf(hexColor, "#%02x%02x%02x", &r, &g, &b);
+std::unique_ptr<ke::gui::LayoutNode> ke::util::XML::parseNode(pugi::xml_node node, std::vector<std::unique_ptr<gui::Element>>& elements)
+{
+    std::unique_ptr<gui::Element> element;
+    const char* name = node.name();
+
+    // Rects stay empty until the first layout pass.
+    if(strcmp(name, "Frame") == 0)
+        element = std::make_unique<gui::Frame>(0.0f, 0.0f, 0.0f, 0.0f, parseColor(node.attribute("color").as_string()));
+    else if(strcmp(name, "Button") == 0)
+        element = std::make_unique<gui::Button>(0.0f, 0.0f, 0.0f, 0.0f, parseColor(node.attribute("color").as_string()), node.attribute("id").as_string());
+    else if(strcmp(name, "input") == 0)
+    {
+        const char* inputType = node.attribute("type").as_string();
+        gui::InputType type = gui::InputType::MAX_ENUM;
+        if(strcmp(inputType, "text") == 0) type = gui::InputType::TEXT;
+        else if(strcmp(inputType, "number") == 0) type = gui::InputType::NUMBER;
+
+        if(type != gui::InputType::MAX_ENUM)
+            element = std::make_unique<gui::InputField>(0.0f, 0.0f, 0.0f, 0.0f, parseColor(node.attribute("color").as_string()),
+                (std::string)node.attribute("placeholder").as_string(), type, (std::string)node.attribute("name").as_string());
+    }
+    else if(strcmp(name, "Explorer") == 0)
+        element = std::make_unique<gui::Explorer>(0.0f, 0.0f, 0.0f, 0.0f, parseColor(node.attribute("color").as_string()));
 
-        float rf = util::srgbToLinear(r / 255.0f);
-        float gf = util::srgbToLinear(g / 255.0f);
-        float bf = util::srgbToLinear(b / 255.0f);
+    std::unique_ptr<gui::LayoutNode> layoutNode = std::make_unique<gui::LayoutNode>(parseStyle(node), element.get());
 
-        const char* buttonID = button.attribute("id").as_string();
-        elements.push_back(std::make_unique<gui::Button>(x,y,w,h, glm::vec3{rf,gf,bf}, buttonID));
+    // Parents go first so they draw underneath their children.
+    if(element) elements.push_back(std::move(element));
 
-    }
-    for(pugi::xml_node inputField : root.children("input"))
+    for(pugi::xml_node child : node.children())
     {
-        float x = inputField.attribute("x").as_float() / 100.0f;
-        float y = inputField.attribute("y").as_float() / 100.0f;
-        float w = inputField.attribute("w").as_float() / 100.0f;
-        float h = inputField.attribute("h").as_float() / 100.0f;
-
-        x = rootx + rootw * x;
-        y = rooty + rooth * y;
-        w *= rootw;
-        h *= rooth;
-
-        const char* hexColor = inputField.attribute("color").as_string();
-        int r, g, b;
-        std::sscanf(hexColor, "#%02x%02x%02x", &r, &g, &b);
+        const char* childName = child.name();
+        if(strcmp(childName, "Frame") == 0 || strcmp(childName, "Group") == 0 || strcmp(childName, "Button") == 0 ||
+           strcmp(childName, "input") == 0 || strcmp(childName, "Explorer") == 0)
+            layoutNode->addChild(parseNode(child, elements));
+    }
 
-        float rf = util::srgbToLinear(r / 255.0f);
-        float gf = util::srgbToLinear(g / 255.0f);
-        float bf = util::srgbToLinear(b / 255.0f);
-        
-        const char* placeholder = inputField.attribute("placeholder").as_string();
+    return layoutNode;
+}
 
-        const char* inputName = inputField.attribute("name").as_string();
+void ke::util::XML::parseFile(std::string filepath, std::vector<std::unique_ptr<gui::Element>>& elements, std::unique_ptr<gui::LayoutNode>& layout)
+{
+    std::unique_ptr<Document> document = loadDocument(filepath);
 
-        const char* inputType = inputField.attribute("type").as_string();
-        if(strcmp(inputType, "text") == 0)
-            elements.push_back(std::make_unique<gui::InputField>(x,y,w,h, glm::vec3(rf, gf, bf), (std::string)placeholder, gui::InputType::TEXT, (std::string)inputName));
-        else if(strcmp(inputType, "number") == 0)
-            elements.push_back(std::make_unique<gui::InputField>(x,y,w,h, glm::vec3(rf, gf, bf), (std::string)placeholder, gui::InputType::NUMBER, (std::string)inputName));
+    mLogger.info(document->result.description());
 
-            
-    }
-    for(pugi::xml_node explorer : root.children("Explorer"))
-    {
-        float x = explorer.attribute(("x")).as_float() / 100.0f;
-        float y = explorer.attribute(("y")).as_float() / 100.0f;
-        float w = explorer.attribute(("w")).as_float() / 100.0f;
-        float h = explorer.attribute(("h")).as_float() / 100.0f;
-
-        x = rootx + rootw * x;
-        y = rooty + rooth * y;
-        w *= rootw;
-        h *= rooth;
-
-        const char* hexColor = explorer.attribute("color").as_string();
-        int r, g, b;
-        std::sscanf(hexColor, "#%02x%02x%02x", &r, &g, &b);
+    pugi::xml_node root = document->document.child("KEUIcomponent");
 
-        float rf = util::srgbToLinear(r / 255.0f);
-        float gf = util::srgbToLinear(g / 255.0f);
-        float bf = util::srgbToLinear(b / 255.0f);
-
-        elements.push_back(std::make_unique<gui::Explorer>(x,y,w,h, glm::vec3(rf, gf, bf)));
-    }
+    // The component's own box is placed in the window like any absolute child.
+    layout = std::make_unique<gui::LayoutNode>(gui::LayoutStyle{});
+    layout->addChild(parseNode(root, elements));
 }
 
-void ke::util::XML::parseSceneFile(std::string filepath, glm::ivec2 &offset, glm::ivec2 &extent, int wx, int wy)
+void ke::util::XML::parseSceneFile(std::string filepath, std::unique_ptr<gui::LayoutNode>& layout, gui::LayoutNode*& sceneView)
 {
-    pugi::xml_document doc;
-    pugi::xml_parse_result result = doc.load_file(filepath.c_str());
+    std::unique_ptr<Document> document = loadDocument(filepath);
 
-    pugi::xml_node root = doc.child("KEUIcomponent");
+    pugi::xml_node root = document->document.child("KEUIcomponent");
 
-    float rootx = root.attribute("x").as_float() / 100.0f;
-    float rooty = root.attribute("y").as_float() / 100.0f;
-    float rootw = root.attribute("w").as_float() / 100.0f;
-    float rooth = root.attribute("h").as_float() / 100.0f;
+    layout = std::make_unique<gui::LayoutNode>(gui::LayoutStyle{});
+    gui::LayoutNode* rootNode = layout->addChild(std::make_unique<gui::LayoutNode>(parseStyle(root)));
 
-    for(pugi::xml_node scene: root.children("SceneView"))
+    sceneView = nullptr;
+    for(pugi::xml_node scene : root.children("SceneView"))
+        sceneView = rootNode->addChild(std::make_unique<gui::LayoutNode>(parseStyle(scene)));
+}
+
+void ke::gui::InputField::layoutText(int pixelX, int pixelY, int pixelH)
+{
+    if(pixelX == mTextX && pixelY == mTextY && pixelH == mTextH) return;
+    bool placed = mTextH >= 0;
+    mTextX = pixelX;
+    mTextY = pixelY;
+    mTextH = pixelH;
+
+    // Only moved after the first layout, so a resize keeps the caret and selection.
+    if(placed) mEditor.setPlacement(pixelX, pixelY, static_cast<float>(pixelH));
+    else
     {
-        float x = scene.attribute("x").as_float() / 100.0f;
-        float y = scene.attribute("y").as_float() / 100.0f;
-        float w = scene.attribute("w").as_float() / 100.0f;
-        float h = scene.attribute("h").as_float() / 100.0f;
-
-        x = rootx + rootw * x;
-        y = rooty + rooth * y;
-        w *= rootw;
-        h *= rooth;
-
-        int rx = static_cast<int>(std::round(wx * x));
-        int ry = static_cast<int>(std::round(wy * y));
-        int rw = static_cast<int>(std::round(wx * w));
-        int rh = static_cast<int>(std::round(wy * h));  
-        
-        offset = {rx, ry};
-        extent = {rw, rh};
+        mEditor = Graphics::Text::EditableText("DejaVuSans", pixelX, pixelY, static_cast<float>(pixelH), glm::vec4(1.0f));
+        mEditor.setCaretVisible(mFocused);
     }
+    mPlaceholderText = Graphics::Text::TextInstance(mPlaceholder, "DejaVuSans", pixelX, pixelY, glm::vec4(glm::vec3(0.3f), 1.0f), pixelH);
 }
 
 void ke::gui::InputField::DrawText() const
 {
-    mTextInstance.Draw();
+    if(mEditor.empty()) mPlaceholderText.Draw();
+    mEditor.Draw();
 }
 
 void ke::gui::Explorer::updateExplorerEntries()
 {
+    mEntries.clear();
+    mVisibleEntries.clear();
+    mGeometryDirty = true;
+
     SceneManager& sceneManager = SceneManager::getInstance();
     const nodes::RootObject* rootObject = sceneManager.getRootObject();
-    if(rootObject == nullptr || !rootObject) return;
+    if(rootObject == nullptr) return;
 
-    auto elements = rootObject->gatherDescendants();
+    util::FrameVector<nodes::DefaultObject*> elements;
+    rootObject->gatherDescendants(elements);
 
     for(nodes::DefaultObject* el : elements)
     {
-        mEntries.insert(std::make_pair<uint8_t, ExpEntry>(el->getObjectID(), ExpEntry(el->name, el->getDepth())));
+        mEntries.emplace(el->getObjectID(), ExpEntry(el->name, el->getDepth()));
         mVisibleEntries.push_back(el->getObjectID());
     }
 }
 
 void ke::gui::Explorer::reconstructExplorerVertices()
 {
-    mVertices.clear();
-    mIndices.clear();
-    mVertexBuffer.destroy();
-    mIndexBuffer.destroy();
+    const float rowHeight = 0.1f;   // of the explorer's height
+    const float inset = 0.05f;      // of its width, per level of depth
 
-    float descend = 0.1f;
-    float inset = 0.2f;
+    // Same clip space mapping as the component frames.
+    float left = x * 2.0f - 1.0f;
+    float top = (y + h) * 2.0f - 1.0f;
+    float width = w * 2.0f;
+    float row = h * 2.0f * rowHeight;
 
-    uint64_t i = 0;
-    uint32_t indexOffset = 0;
+    uint32_t quad = 0;
     for(uint64_t entryID : mVisibleEntries)
     {
-        ExpEntry& entry = mEntries.at(entryID);
-        std::vector<util::str::Vertex2P3C2T> entryVertices{};
-
-        float entryInset = entry.depth * inset;
-        float entryDescend = i * descend;
-
-        entryVertices.push_back(util::str::Vertex2P3C2T{{x, y}, color, {0.0f, 0.0f}});
-        entryVertices.push_back(util::str::Vertex2P3C2T{{x + entryInset, y}, color, {0.0f, 0.0f}});
-        entryVertices.push_back(util::str::Vertex2P3C2T{{x, y + entryDescend}, color, {0.0f, 0.0f}});
-        entryVertices.push_back(util::str::Vertex2P3C2T{{x + entryInset, y + entryDescend}, color, {0.0f, 0.0f}});
-
-        std::vector<uint32_t> entryIndices = 
-        {
-            0 + indexOffset,1 + indexOffset ,2 + indexOffset,
-            2 + indexOffset,3 + indexOffset,1 + indexOffset
-        };
-
-        mVertices.insert(mVertices.end(), entryVertices.begin(), entryVertices.end());
-        mIndices.insert(mIndices.end(), entryIndices.begin(), entryIndices.end());
-
-        indexOffset += 4;
-        i++;
+        const ExpEntry& entry = mEntries.at(entryID);
+
+        float rowLeft = left + width * std::min(entry.depth * inset, 0.9f);
+        float rowTop = top - quad * row;
+        float rowBottom = rowTop - row * 0.9f;
+
+        pQuads->setQuad(mQuadBase + quad++, {
+            util::str::Vertex2P3C2T{{rowLeft, rowTop}, color, {0.0f, 0.0f}},
+            util::str::Vertex2P3C2T{{rowLeft, rowBottom}, color, {0.0f, 0.0f}},
+            util::str::Vertex2P3C2T{{left + width, rowBottom}, color, {0.0f, 0.0f}},
+            util::str::Vertex2P3C2T{{left + width, rowTop}, color, {0.0f, 0.0f}},
+        });
     }
 
-    Graphics::Renderer& rend = Graphics::Renderer::getInstance();
-    //rend.createVertexBuffer<util::str::Vertex2P3C2T>(mVertices, mVertexBuffer.buffer, mVertexBuffer.bufferMemory);
-    //rend.createIndexBuffer(mIndices, mIndexBuffer.buffer, mIndexBuffer.bufferMemory);
-    
+    // Unused rows collapse to nothing but stay in the batch's range.
+    for(; quad < mRowCapacity; quad++)
+        pQuads->setQuad(mQuadBase + quad, Graphics::QuadBuffer::Quad{});
 }
 
-void ke::gui::Explorer::DrawGeometry() const
+bool ke::gui::Explorer::update()
 {
-    ke::Graphics::Renderer& rend = ke::Graphics::Renderer::getInstance();
+    if(!mGeometryDirty || pQuads == nullptr) return true;
 
-    rend.drawBuffersIndexed(mVertexBuffer, mIndexBuffer, static_cast<uint32_t>(mIndices.size()));
-}
\ No newline at end of file
+    if(mVisibleEntries.size() > mRowCapacity)
+    {
+        mRowCapacity = std::max(static_cast<uint32_t>(mVisibleEntries.size()), mRowCapacity * 2);
+        return false;
+    }
+
+    reconstructExplorerVertices();
+    mGeometryDirty = false;
+    return true;
+}
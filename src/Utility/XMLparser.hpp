@@ -6,9 +6,17 @@
 #include "Logger.hpp"
 #include <glm/glm.hpp>
 #include <functional>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "../Graphics/TextUtilities.hpp"
+#include "../Graphics/QuadBuffer.hpp"
+#include "../Graphics/EditableText.hpp"
 #include "../Nodes/Object.hpp"
 #include "structs.hpp"
+#include "UILayout.hpp"
 #include "../SceneManager.hpp"
 
 namespace ke
@@ -37,6 +45,28 @@ namespace ke
             glm::vec3 color;
 
             virtual UIType getType() const = 0;
+
+            // Changes made through these reach the GPU on the owning component's next draw, and only this
+            // element's quad is rewritten.
+            void setRect(float _x, float _y, float _w, float _h) {x = _x; y = _y; w = _w; h = _h; markDirty();}
+            void setColor(glm::vec3 _color) {color = _color; markDirty();}
+
+            void markDirty()
+            {
+                if(mDirty) return;
+                mDirty = true;
+                if(pDirtyList) pDirtyList->push_back(this);
+            }
+            void clearDirty() {mDirty = false;}
+            bool isDirty() const {return mDirty;}
+
+            // Set by the owning component, which drains the list when it draws.
+            void setDirtyList(std::vector<Element*>* dirtyList, uint32_t quad) {pDirtyList = dirtyList; mQuad = quad;}
+            uint32_t getQuad() const {return mQuad;}
+        private:
+            bool mDirty = false;
+            std::vector<Element*>* pDirtyList = nullptr;
+            uint32_t mQuad = 0;
         };
 
 
@@ -79,19 +109,21 @@ namespace ke
             Explorer(float _x, float _y, float _w, float _h, glm::vec3 _color)
                 : Element(_x, _y, _w, _h, _color)
             {
-                Graphics::Renderer& rend = Graphics::Renderer::getInstance();
-                mVertexBuffer.setDevice(rend.getDevice());
-                mIndexBuffer.setDevice(rend.getDevice());
-
                 updateExplorerEntries();
-                reconstructExplorerVertices();
+                mRowCapacity = std::max<uint32_t>(static_cast<uint32_t>(mVisibleEntries.size()), MIN_ROW_CAPACITY);
             }
 
+            static constexpr uint32_t MIN_ROW_CAPACITY = 16;
+
+            // Re-reads the scene tree, the rows are rebuilt on the next update.
             void updateExplorerEntries();
-            void reconstructExplorerVertices();
+            void invalidateGeometry() {mGeometryDirty = true;}
 
-            void DrawGeometry() const;
-            //void DrawText() const;
+            // Rows live in the owning component's range of the shared quad buffer, after its frames.
+            void bindQuads(Graphics::QuadBuffer& quads, uint32_t base) {pQuads = &quads; mQuadBase = base; mGeometryDirty = true;}
+            uint32_t getRowCapacity() const {return mRowCapacity;}
+            // False when there are more rows than the range holds, the capacity has grown by then.
+            bool update();
 
             std::unordered_map<uint64_t, ExpEntry> mEntries;
             std::vector<uint64_t> mVisibleEntries;
@@ -99,23 +131,18 @@ namespace ke
             GUI_TYPE(TypeExplorer)
 
         private:
-            std::vector<util::str::Vertex2P3C2T> mVertices;
-            std::vector<uint32_t> mIndices;
-            //std::vector<Graphics::Text::TextInstance> mTextInstances;
+            void reconstructExplorerVertices();
 
-            util::Buffer mVertexBuffer;
-            util::Buffer mIndexBuffer;
+            Graphics::QuadBuffer* pQuads = nullptr;
+            uint32_t mQuadBase = 0;
+            uint32_t mRowCapacity = MIN_ROW_CAPACITY;
+            bool mGeometryDirty = true;
         };
 
         enum InputType
         {
             TEXT, NUMBER, MAX_ENUM
         };
-        struct InputValue
-        {
-            std::string val;
-            glm::vec3 color;
-        };
         class InputField : public Element
         {
         public: 
@@ -123,26 +150,14 @@ namespace ke
             InputField(float _x, float _y, float _w, float _h, glm::vec3 _color, std::string _placeholder, InputType _type, std::string _name)
                 : Element(_x, _y, _w, _h, _color), mPlaceholder(_placeholder), mType(_type), name(_name) {}
 
-            void setValue(const std::string& newValue) {mValue = newValue;}
-            InputValue getValue()
-            {
-                InputValue value{};
-                if(mValue.empty() || mValue == "")
-                    {value.val = mPlaceholder; value.color = glm::vec3(0.3f);}
-                else
-                    {value.val = mValue; value.color = glm::vec3(1.0f);}
+            // Places the value and placeholder text, pixelY is the baseline. Whatever was typed, the caret and the
+            // selection are kept, and nothing moves if the text is already there.
+            void layoutText(int pixelX, int pixelY, int pixelH);
 
-                return value;
-            }
-            std::string getRawValue() const
-            {
-                return mValue;
-            }
+            Graphics::Text::EditableText& getEditor() {return mEditor;}
+            std::string getRawValue() const {return mEditor.getText();}
+            void setFocused(bool focused) {mFocused = focused; mEditor.setCaretVisible(focused);}
 
-            void setTextInstance(ke::Graphics::Text::TextInstance& textInstance)
-            {
-                mTextInstance = std::move(textInstance);
-            }
             GUI_TYPE(TypeInputField) 
 
             void DrawText() const;
@@ -151,10 +166,12 @@ namespace ke
 
         private:
             std::string mPlaceholder;
-            std::string mValue;   
 
             InputType mType;
-            ke::Graphics::Text::TextInstance mTextInstance;
+            bool mFocused = false;
+            int mTextX = -1, mTextY = -1, mTextH = -1;
+            Graphics::Text::EditableText mEditor;
+            Graphics::Text::TextInstance mPlaceholderText;
         };
     };
     namespace util
@@ -169,12 +186,31 @@ namespace ke
                 return instance;
             }
 
-            void parseFile(std::string filepath, std::vector<std::unique_ptr<gui::Element>>& elements);
-            void parseSceneFile(std::string filepath, glm::ivec2& offset, glm::ivec2& extent, int wx, int wy);
+            // Elements come out in drawing order, their rects are set by the first layout pass over the returned tree.
+            // Frames and Groups nest, and any container can lay its children out as a row, column or grid.
+            void parseFile(std::string filepath, std::vector<std::unique_ptr<gui::Element>>& elements, std::unique_ptr<gui::LayoutNode>& layout);
+            void parseSceneFile(std::string filepath, std::unique_ptr<gui::LayoutNode>& layout, gui::LayoutNode*& sceneView);
+
+            // Reads and parses a file ahead of time, from any thread. The next parseFile/parseSceneFile of the
+            // same path uses the result instead of going to disk.
+            void preloadFile(const std::string& filepath);
         private:
             XML() = default;
 
+            struct Document
+            {
+                pugi::xml_document document;
+                pugi::xml_parse_result result;
+            };
+            std::unique_ptr<Document> loadDocument(const std::string& filepath);
+
+            gui::LayoutStyle parseStyle(pugi::xml_node node) const;
+            std::unique_ptr<gui::LayoutNode> parseNode(pugi::xml_node node, std::vector<std::unique_ptr<gui::Element>>& elements);
+
             util::Logger mLogger = util::Logger("XML parser logger");
+
+            std::mutex mPreloadMutex;
+            std::unordered_map<std::string, std::unique_ptr<Document>> mPreloaded;
         };
     }
 }
\ No newline at end of file
@@ -5,7 +5,7 @@ int main(int argc, char** argv)
     ke::Core::Application& APPLICATION = ke::Core::Application::getInstance();
     try
     {
-        APPLICATION.Run();
+        APPLICATION.Run(argc, argv);
     }
     catch (std::runtime_error& e) { std::cerr << e.what() << std::endl; }
 
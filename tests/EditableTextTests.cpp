@@ -0,0 +1,38 @@
+#include "Test.hpp"
+#include "Graphics/EditableText.hpp"
+
+using namespace ke::Graphics::Text;
+
+namespace
+{
+    void loadFonts()
+    {
+        static bool loaded = false;
+        if(loaded) return;
+
+        TextUtils::getInstance().loadFonts();
+        loaded = true;
+    }
+}
+
+KE_TEST(EditableText_PlacementKeepsCaretAndSelection)
+{
+    loadFonts();
+    EditableText editor("DejaVuSans", 10, 20, 16.0f, glm::vec4(1.0f));
+    editor.setText("hello world");
+    editor.setCaret(2);
+    editor.setCaret(7, true);
+
+    // Moving keeps the text, caret and selection, resizing also scales where each character sits.
+    editor.setPlacement(110, 40, 16.0f);
+    KE_CHECK(editor.getText() == "hello world");
+    KE_CHECK(editor.getCaret() == 7);
+    KE_CHECK(editor.getSelectedText() == "llo w");
+    KE_CHECK(editor.hitTest(110.0f) == 0);
+
+    size_t atSmall = editor.hitTest(110.0f + 40.0f);
+    editor.setPlacement(110, 40, 32.0f);
+    KE_CHECK(editor.getCaret() == 7);
+    KE_CHECK(editor.getSelectedText() == "llo w");
+    KE_CHECK(editor.hitTest(110.0f + 80.0f) == atSmall);
+}
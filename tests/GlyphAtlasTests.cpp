@@ -0,0 +1,68 @@
+#include "Test.hpp"
+#include "Graphics/GlyphAtlas.hpp"
+#include "Graphics/Renderer.hpp"
+
+using namespace ke::Graphics;
+using namespace ke::Graphics::Text;
+
+namespace
+{
+    // Fills every page to PAGE_SIZE with one full-page glyph each, all drawn on the given frame.
+    void fillAtlas(GlyphAtlas& atlas, uint64_t frame)
+    {
+        atlas.setFrame(frame);
+        for(uint32_t i = 0; i < GlyphAtlas::MAX_PAGES; i++)
+        {
+            AtlasRegion region;
+            int32_t evicted;
+            atlas.allocate(GlyphAtlas::PAGE_SIZE, GlyphAtlas::PAGE_SIZE, region, evicted);
+            atlas.touch(region.page);
+        }
+    }
+}
+
+KE_TEST(GlyphAtlas_KeepsPagesInFlight)
+{
+    GlyphAtlas atlas;
+    fillAtlas(atlas, 10);
+    KE_CHECK(atlas.getPageCount() == GlyphAtlas::MAX_PAGES);
+
+    // Same order as a real frame: new glyphs are packed first, the draws touch their pages afterwards. Every page
+    // is drawn each frame, so none of them may be cleared.
+    for(uint64_t frame = 11; frame < 11 + 2 * Renderer::MAXFRAMESINFLIGHT; frame++)
+    {
+        atlas.setFrame(frame);
+
+        AtlasRegion region;
+        int32_t evicted = 0;
+        KE_CHECK(!atlas.allocate(32, 32, region, evicted));
+        KE_CHECK(evicted == -1);
+
+        for(uint16_t page = 0; page < atlas.getPageCount(); page++)
+            atlas.touch(page);
+    }
+
+    for(uint16_t page = 0; page < atlas.getPageCount(); page++)
+        KE_CHECK(atlas.getGeneration(page) == 0);
+}
+
+KE_TEST(GlyphAtlas_EvictsOldestIdlePage)
+{
+    GlyphAtlas atlas;
+    fillAtlas(atlas, 10);
+
+    // Page 2 stays live, the others were last drawn on frame 10 and page 1 a little later.
+    uint64_t frame = 12 + Renderer::MAXFRAMESINFLIGHT;
+    atlas.setFrame(11);
+    atlas.touch(1);
+    atlas.setFrame(frame);
+    atlas.touch(2);
+
+    AtlasRegion region;
+    int32_t evicted = -1;
+    KE_CHECK(atlas.allocate(32, 32, region, evicted));
+    KE_CHECK(evicted == 0);
+    KE_CHECK(region.page == 0);
+    KE_CHECK(atlas.getGeneration(0) == 1);
+    KE_CHECK(atlas.getGeneration(2) == 0);
+}
@@ -0,0 +1,46 @@
+#include "Test.hpp"
+#include "Nodes/Rect.hpp"
+
+using namespace ke::nodes;
+
+KE_TEST(NodeHandle_RoundTrip)
+{
+    Rect2D parent(0, 0, 10, 10);
+    Rect2D* child = parent.createChild<Rect2D>(1, 2, 3, 4);
+
+    NodeHandle handle = child->getHandle();
+    KE_CHECK(handle.isValid());
+    KE_CHECK(DefaultObject::fromHandle<Rect2D>(handle) == child);
+    KE_CHECK(DefaultObject::fromHandle(handle) == child);
+}
+
+KE_TEST(NodeHandle_StaleAfterReuse)
+{
+    Rect2D parent(0, 0, 10, 10);
+    Rect2D* first = parent.createChild<Rect2D>(1, 2, 3, 4);
+    NodeHandle stale = first->getHandle();
+
+    KE_CHECK(parent.destroyChild(first));
+    KE_CHECK(DefaultObject::fromHandle(stale) == nullptr);
+
+    // Same size class, so the freed slot is the next one handed out.
+    Rect2D* second = parent.createChild<Rect2D>(5, 6, 7, 8);
+    NodeHandle fresh = second->getHandle();
+
+    KE_CHECK(fresh.index == stale.index);
+    KE_CHECK(fresh.generation != stale.generation);
+    KE_CHECK(DefaultObject::fromHandle(stale) == nullptr);
+    KE_CHECK(DefaultObject::fromHandle<Rect2D>(fresh) == second);
+}
+
+KE_TEST(NodeHandle_NotPooled)
+{
+    Rect2D onStack(0, 0, 10, 10);
+    KE_CHECK(!onStack.getHandle().isValid());
+    KE_CHECK(!RootObject::getInstance().getHandle().isValid());
+
+    // An address inside a slab that isn't the start of a slot isn't a node either.
+    Rect2D* pooled = onStack.createChild<Rect2D>(1, 2, 3, 4);
+    const DefaultObject* inside = reinterpret_cast<const DefaultObject*>(reinterpret_cast<const std::byte*>(pooled) + 16);
+    KE_CHECK(!NodePool::getInstance().getHandle(inside).isValid());
+}
@@ -0,0 +1,32 @@
+#include "Test.hpp"
+
+#include <iostream>
+
+void ke::test::Context::check(bool condition, const char* expression, const char* file, int line)
+{
+    if(condition) return;
+
+    mFailures++;
+    std::cerr << "    " << file << ":" << line << ": check failed: " << expression << "\n";
+}
+
+uint32_t ke::test::runAll(const std::string& filter)
+{
+    uint32_t run = 0;
+    uint32_t failed = 0;
+
+    for(const Test& test : Registry::getInstance().getTests())
+    {
+        if(!filter.empty() && test.name.find(filter) == std::string::npos) continue;
+
+        Context context;
+        test.function(context);
+        run++;
+
+        if(context.getFailures() > 0) failed++;
+        std::cout << (context.getFailures() > 0 ? "FAIL " : "ok   ") << test.name << "\n";
+    }
+
+    std::cout << run - failed << "/" << run << " tests passed\n";
+    return failed;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ke
+{
+    namespace test
+    {
+        // Tracks the checks of the test currently running, a failed check is reported and the test carries on.
+        class Context
+        {
+        public:
+            void check(bool condition, const char* expression, const char* file, int line);
+
+            uint32_t getFailures() const {return mFailures;}
+        private:
+            uint32_t mFailures = 0;
+        };
+
+        using TestFunction = std::function<void(Context&)>;
+
+        struct Test
+        {
+            std::string name;
+            TestFunction function;
+        };
+
+        class Registry
+        {
+        public:
+            static Registry& getInstance()
+            {
+                static Registry instance;
+                return instance;
+            }
+
+            void add(const std::string& name, TestFunction function) {mTests.push_back({name, std::move(function)});}
+            const std::vector<Test>& getTests() const {return mTests;}
+        private:
+            Registry() = default;
+
+            std::vector<Test> mTests;
+        };
+
+        struct Registrar
+        {
+            Registrar(const char* name, TestFunction function)
+            {
+                Registry::getInstance().add(name, std::move(function));
+            }
+        };
+
+        // Runs every registered test whose name contains the filter, returns how many failed.
+        uint32_t runAll(const std::string& filter);
+    }
+}
+
+#define KE_TEST_CONCAT_INNER(a, b) a##b
+#define KE_TEST_CONCAT(a, b) KE_TEST_CONCAT_INNER(a, b)
+#define KE_TEST(name) \
+    static void name(::ke::test::Context& context); \
+    static ::ke::test::Registrar KE_TEST_CONCAT(keTestRegistrar, __LINE__)(#name, name); \
+    static void name(::ke::test::Context& context)
+
+#define KE_CHECK(condition) context.check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
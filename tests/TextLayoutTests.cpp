@@ -0,0 +1,75 @@
+#include "Test.hpp"
+#include "Graphics/TextLayout.hpp"
+#include "Graphics/TextUtilities.hpp"
+
+#include <cmath>
+
+using namespace ke::Graphics::Text;
+
+namespace
+{
+    Font& getTestFont()
+    {
+        static msdfgen::FreetypeHandle* library = msdfgen::initializeFreetype();
+        static Font font("./src/Fonts/DejaVuSans.ttf", library);
+        return font;
+    }
+
+    bool near(float a, float b)
+    {
+        return std::abs(a - b) < 1e-3f;
+    }
+}
+
+KE_TEST(TextLayout_WrapReappliesKerning)
+{
+    Font& font = getTestFont();
+    TextStyle style;
+    style.pixelSize = 32.0f;
+    float scale = style.pixelSize / static_cast<float>(font.getEmSize());
+
+    // "AV" kerns tightly, so a wrap that drops or keeps the wrong kerning moves the V.
+    const std::string word = "AV";
+    KE_CHECK(font.getKerning('A', 'V') != 0.0);
+
+    ShapedRun alone = TextLayout::layout(word, font, style);
+    ShapedRun single = TextLayout::layout("To " + word, font, style);
+    KE_CHECK(single.lineCount == 1);
+    KE_CHECK(single.glyphs.size() == 4);
+
+    // Just too narrow for the word's second glyph, so the wrap happens while it is being placed.
+    const ShapedGlyph& second = single.glyphs[3];
+    style.maxWidth = second.pen.x + static_cast<float>(font.getAdvance('V')) * scale - 0.5f;
+
+    ShapedRun wrapped = TextLayout::layout("To " + word, font, style);
+    KE_CHECK(wrapped.lineCount == 2);
+    KE_CHECK(wrapped.glyphs.size() == 4);
+    if(wrapped.glyphs.size() != 4 || alone.glyphs.size() != 2) return;
+
+    // The word on its own line sits exactly where it would without anything in front of it.
+    for(size_t i = 0; i < alone.glyphs.size(); i++)
+    {
+        const ShapedGlyph& moved = wrapped.glyphs[2 + i];
+        KE_CHECK(moved.codepoint == alone.glyphs[i].codepoint);
+        KE_CHECK(near(moved.pen.x, alone.glyphs[i].pen.x));
+        KE_CHECK(moved.pen.y < 0.0f);
+    }
+    KE_CHECK(near(wrapped.glyphs[2].pen.x, 0.0f));
+}
+
+KE_TEST(TextLayout_WrapsBetweenWords)
+{
+    Font& font = getTestFont();
+    TextStyle style;
+    style.pixelSize = 16.0f;
+
+    ShapedRun single = TextLayout::layout("one two three", font, style);
+    KE_CHECK(single.lineCount == 1);
+
+    style.maxWidth = single.size.x * 0.6f;
+    ShapedRun wrapped = TextLayout::layout("one two three", font, style);
+    KE_CHECK(wrapped.lineCount == 2);
+    KE_CHECK(wrapped.glyphs.size() == single.glyphs.size());
+    for(const ShapedGlyph& glyph : wrapped.glyphs)
+        KE_CHECK(glyph.pen.x <= style.maxWidth);
+}
@@ -0,0 +1,22 @@
+#include "Test.hpp"
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    std::string filter;
+
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if(arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else
+        {
+            std::cerr << "Usage: NewEngineTests [--filter substring]\n";
+            return 1;
+        }
+    }
+
+    return ke::test::runAll(filter) == 0 ? 0 : 1;
+}